@@ -0,0 +1,106 @@
+#include "AudioCodec.h"
+
+// =============================================================================
+// IMA-ADPCM-TABELLEN
+// =============================================================================
+
+static const int8_t ADPCM_INDEX_TABLE[16] = {
+    -1, -1, -1, -1, 2, 4, 6, 8,
+    -1, -1, -1, -1, 2, 4, 6, 8
+};
+
+static const int16_t ADPCM_STEP_TABLE[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17,
+    19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+    130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+    337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+    876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+    2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+    5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+// =============================================================================
+// ÖFFENTLICHE METHODEN
+// =============================================================================
+
+void AdpcmCodec::encode(AdpcmState& state, const int16_t* pcm, size_t samples, uint8_t* out) {
+    for (size_t i = 0; i < samples; i += 2) {
+        uint8_t low = encodeSample(state, pcm[i]);
+        uint8_t high = (i + 1 < samples) ? encodeSample(state, pcm[i + 1]) : 0;
+        out[i / 2] = low | (high << 4);
+    }
+}
+
+void AdpcmCodec::decode(AdpcmState& state, const uint8_t* in, size_t samples, int16_t* pcm) {
+    for (size_t i = 0; i < samples; i++) {
+        uint8_t byte = in[i / 2];
+        uint8_t nibble = (i & 1) ? (byte >> 4) : (byte & 0x0F);
+        pcm[i] = decodeSample(state, nibble);
+    }
+}
+
+size_t AdpcmCodec::encodedSize(size_t samples) {
+    return (samples + 1) / 2;
+}
+
+void AdpcmCodec::resetState(AdpcmState& state) {
+    state.predictor = 0;
+    state.stepIndex = 0;
+}
+
+// =============================================================================
+// PRIVATE METHODEN
+// =============================================================================
+
+uint8_t AdpcmCodec::encodeSample(AdpcmState& state, int16_t sample) {
+    int32_t step = ADPCM_STEP_TABLE[state.stepIndex];
+    int32_t diff = (int32_t)sample - state.predictor;
+    uint8_t nibble = 0;
+
+    if (diff < 0) {
+        nibble = 8;
+        diff = -diff;
+    }
+
+    // Quantisierung wie im Decoder, damit beide Seiten denselben Prädiktor führen
+    int32_t delta = step >> 3;
+    if (diff >= step) { nibble |= 4; diff -= step; delta += step; }
+    step >>= 1;
+    if (diff >= step) { nibble |= 2; diff -= step; delta += step; }
+    step >>= 1;
+    if (diff >= step) { nibble |= 1; delta += step; }
+
+    int32_t predictor = state.predictor + ((nibble & 8) ? -delta : delta);
+    if (predictor > AUDIO_MAX_SAMPLE) predictor = AUDIO_MAX_SAMPLE;
+    if (predictor < AUDIO_MIN_SAMPLE) predictor = AUDIO_MIN_SAMPLE;
+    state.predictor = (int16_t)predictor;
+
+    int index = state.stepIndex + ADPCM_INDEX_TABLE[nibble];
+    if (index < 0) index = 0;
+    if (index > 88) index = 88;
+    state.stepIndex = (uint8_t)index;
+
+    return nibble;
+}
+
+int16_t AdpcmCodec::decodeSample(AdpcmState& state, uint8_t nibble) {
+    int32_t step = ADPCM_STEP_TABLE[state.stepIndex];
+    int32_t delta = step >> 3;
+    if (nibble & 4) delta += step;
+    if (nibble & 2) delta += step >> 1;
+    if (nibble & 1) delta += step >> 2;
+
+    int32_t predictor = state.predictor + ((nibble & 8) ? -delta : delta);
+    if (predictor > AUDIO_MAX_SAMPLE) predictor = AUDIO_MAX_SAMPLE;
+    if (predictor < AUDIO_MIN_SAMPLE) predictor = AUDIO_MIN_SAMPLE;
+    state.predictor = (int16_t)predictor;
+
+    int index = state.stepIndex + ADPCM_INDEX_TABLE[nibble];
+    if (index < 0) index = 0;
+    if (index > 88) index = 88;
+    state.stepIndex = (uint8_t)index;
+
+    return state.predictor;
+}
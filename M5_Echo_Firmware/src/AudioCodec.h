@@ -0,0 +1,40 @@
+#ifndef AUDIO_CODEC_H
+#define AUDIO_CODEC_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// IMA-ADPCM-Zustand (Prädiktor + Schrittweiten-Index)
+struct AdpcmState {
+    int16_t predictor;
+    uint8_t stepIndex;
+};
+
+// Kopf eines ADPCM-Blocks: Zustand am Blockanfang, damit jeder Block
+// unabhängig dekodiert werden kann (älteste Blöcke dürfen verworfen werden)
+struct AdpcmBlockHeader {
+    int16_t predictor;
+    uint8_t stepIndex;
+    uint8_t reserved;
+};
+
+// IMA-ADPCM-Codec (4 Bit pro Sample, 4:1 gegenüber 16-bit PCM)
+class AdpcmCodec {
+public:
+    // Kodiert 'samples' PCM-Samples nach 'out' (samples / 2 Bytes, aufgerundet)
+    static void encode(AdpcmState& state, const int16_t* pcm, size_t samples, uint8_t* out);
+
+    // Dekodiert 'samples' Samples aus 'in' nach 'pcm'
+    static void decode(AdpcmState& state, const uint8_t* in, size_t samples, int16_t* pcm);
+
+    // Bytes, die 'samples' kodierte Samples belegen
+    static size_t encodedSize(size_t samples);
+
+    static void resetState(AdpcmState& state);
+
+private:
+    static uint8_t encodeSample(AdpcmState& state, int16_t sample);
+    static int16_t decodeSample(AdpcmState& state, uint8_t nibble);
+};
+
+#endif // AUDIO_CODEC_H
@@ -3,6 +3,27 @@
 #include <freertos/task.h>
 #include <freertos/queue.h>
 #include <freertos/semphr.h>
+#include <esp_timer.h>
+#include <HTTPClient.h>
+
+// Überblendung muss vollständig in einen I2S-Block passen
+static const size_t MAX_CROSSFADE_BYTES = AUDIO_MAX_CROSSFADE_MS * (I2S_SAMPLE_RATE / 1000) * sizeof(int16_t);
+static_assert(MAX_CROSSFADE_BYTES <= I2S_BUFFER_SIZE, "AUDIO_MAX_CROSSFADE_MS zu groß für I2S_BUFFER_SIZE");
+
+// Rückgabewert von clipRemaining(), solange das Clip-Ende unbekannt ist
+static const size_t CLIP_REMAINING_UNKNOWN = (size_t)-1;
+
+// Clip-Übergang beim Rendern vormerken (clipId 0 = impliziter Clip, keine Ereignisse)
+static void appendPlaybackMark(PlaybackMark* marks, size_t* markCount, uint32_t clipId,
+                               uint64_t sampleIndex, bool finished) {
+    if (clipId == 0) {
+        return;
+    }
+    PlaybackMark& mark = marks[(*markCount)++];
+    mark.sampleIndex = sampleIndex;
+    mark.clipId = clipId;
+    mark.finished = finished;
+}
 
 // =============================================================================
 // KONSTRUKTOR & DESTRUKTOR
@@ -22,6 +43,53 @@ AudioManager::AudioManager() {
     micBuffer.buffer = nullptr;
     speakerBuffer.buffer = nullptr;
     
+    // Pre-Roll-Puffer
+    preRoll.blocks = nullptr;
+    preRoll.blockCount = 0;
+    resetPreRoll();
+    audioSink = nullptr;
+    
+    // Stream-Gate (standardmäßig offen: on_button_press sendet sofort)
+    streamOpen = true;
+    streamStartSample = 0;
+    capturedSamples = 0;
+    lastBlockEndUs = 0;
+    captureMux = portMUX_INITIALIZER_UNLOCKED;
+    
+    // Downlink-Zähler
+    downlinkReceivedBytes = 0;
+    downlinkConsumedBytes = 0;
+    downlinkDroppedBytes = 0;
+    speakerGeneration = 0;
+    
+    // Wiedergabe-Queue
+    playbackQueueHead = 0;
+    playbackQueueCount = 0;
+    flashClipCount = 0;
+    prefetchBufferData = nullptr;
+    prefetchBuffer.buffer = nullptr;
+    prefetchTaskHandle = nullptr;
+    prefetchClipId = 0;
+    prefetchActive = false;
+    prefetchUrl[0] = '\0';
+    
+    // Wiedergabe-Position
+    speakerEventQueue = nullptr;
+    speakerDmaFrames = speakerLatency.getGeometry().bufLen;
+    micGeometry = micLatency.getGeometry();
+    resetPlaybackPosition();
+    
+    // Barge-in
+    bargeInPending = false;
+    bargeInHoldoff = false;
+    bargeInTime = 0;
+    bargeInRequestUs = 0;
+    
+    // Endpointing
+    endpoint.enabled = false;
+    resetEndpointing();
+    audioEventCallback = nullptr;
+    
     // Audio-Verarbeitung
     lastAudioProcess = 0;
     silenceCounter = 0;
@@ -33,15 +101,19 @@ AudioManager::AudioManager() {
     recordingQueue = nullptr;
     playingQueue = nullptr;
     audioMutex = nullptr;
+    preRollMutex = nullptr;
+    recordingExited = nullptr;
     
     // Event-Manager Referenz (temporär deaktiviert)
     // eventManager = nullptr;
 }
 
 AudioManager::~AudioManager() {
-    // Tasks stoppen
+    // Tasks stoppen (eine schon beendete Recording-Task hat ihr Ende gemeldet)
     if (recordingTaskHandle) {
-        vTaskDelete(recordingTaskHandle);
+        if (!recordingExited || xSemaphoreTake(recordingExited, 0) != pdTRUE) {
+            vTaskDelete(recordingTaskHandle);
+        }
         recordingTaskHandle = nullptr;
     }
     if (playingTaskHandle) {
@@ -64,6 +136,14 @@ AudioManager::~AudioManager() {
         vSemaphoreDelete(audioMutex);
         audioMutex = nullptr;
     }
+    if (preRollMutex) {
+        vSemaphoreDelete(preRollMutex);
+        preRollMutex = nullptr;
+    }
+    if (recordingExited) {
+        vSemaphoreDelete(recordingExited);
+        recordingExited = nullptr;
+    }
     
     // Puffer freigeben
     if (micBufferData) {
@@ -74,6 +154,14 @@ AudioManager::~AudioManager() {
         free(speakerBufferData);
         speakerBufferData = nullptr;
     }
+    if (preRoll.blocks) {
+        free(preRoll.blocks);
+        preRoll.blocks = nullptr;
+    }
+    if (prefetchBufferData) {
+        free(prefetchBufferData);
+        prefetchBufferData = nullptr;
+    }
     
     // I2S-Ports schließen
     i2s_driver_uninstall(micI2SPort);
@@ -89,7 +177,9 @@ bool AudioManager::begin() {
     
     // Mutex erstellen
     audioMutex = xSemaphoreCreateMutex();
-    if (!audioMutex) {
+    preRollMutex = xSemaphoreCreateMutex();
+    recordingExited = xSemaphoreCreateBinary();
+    if (!audioMutex || !preRollMutex || !recordingExited) {
         Serial.println("AudioManager: Fehler beim Erstellen des Mutex");
         return false;
     }
@@ -111,6 +201,28 @@ bool AudioManager::begin() {
     micBuffer.size = AUDIO_RING_BUFFER_SIZE;
     speakerBuffer.size = AUDIO_RING_BUFFER_SIZE;
     
+    // Pre-Roll-Puffer allozieren (ADPCM, 4:1 gegenüber PCM)
+    preRoll.blocks = (uint8_t*)malloc(AUDIO_PREROLL_BLOCK_COUNT * AUDIO_PREROLL_BLOCK_SIZE);
+    if (!preRoll.blocks) {
+        Serial.println("AudioManager: Fehler beim Allozieren des Pre-Roll-Puffers");
+        return false;
+    }
+    preRoll.blockCount = AUDIO_PREROLL_BLOCK_COUNT;
+    resetPreRoll();
+    Serial.printf("AudioManager: Pre-Roll-Puffer %u Bytes (%u ms)\n",
+                  (unsigned)(AUDIO_PREROLL_BLOCK_COUNT * AUDIO_PREROLL_BLOCK_SIZE),
+                  (unsigned)getPreRollStats().capacityMs);
+    
+    // Prefetch-Puffer für URL-Clips
+    prefetchBufferData = (uint8_t*)malloc(AUDIO_PREFETCH_BUFFER_SIZE);
+    if (!prefetchBufferData) {
+        Serial.println("AudioManager: Fehler beim Allozieren des Prefetch-Puffers");
+        return false;
+    }
+    resetRingBuffer(prefetchBuffer);
+    prefetchBuffer.buffer = prefetchBufferData;
+    prefetchBuffer.size = AUDIO_PREFETCH_BUFFER_SIZE;
+    
     // I2S-Mikrofon initialisieren
     if (!initI2SMicrophone()) {
         Serial.println("AudioManager: Fehler beim Initialisieren des I2S-Mikrofons");
@@ -168,14 +280,35 @@ bool AudioManager::startRecording() {
         return false;
     }
     
-    if (currentState == AudioState::RECORDING) {
+    // Aufnahme am Mikrofon-Flag erkennen, nicht am Gesamtzustand: die
+    // Wiedergabe setzt ihn auf PLAYING bzw. IDLE, während die Aufnahme läuft
+    if (micEnabled) {
         xSemaphoreGive(audioMutex);
         return true; // Bereits aktiv
     }
     
+    // Task der vorigen Aufnahme steckt noch im i2s_read: abwarten, sonst lesen
+    // zwei Tasks denselben Port
+    if (!waitRecordingTaskExit()) {
+        Serial.println("AudioManager: Vorige Recording-Task läuft noch, Aufnahme nicht gestartet");
+        xSemaphoreGive(audioMutex);
+        return false;
+    }
+    
     // Ring-Puffer zurücksetzen
     resetRingBuffer(micBuffer);
     
+    // Aufnahme-Uhr neu starten
+    portENTER_CRITICAL(&captureMux);
+    capturedSamples = 0;
+    streamStartSample = 0;
+    lastBlockEndUs = esp_timer_get_time();
+    portEXIT_CRITICAL(&captureMux);
+    resetEndpointing();
+    
+    // Recording-Task vor dem Start als aktiv markieren, damit die Schleife läuft
+    micEnabled = true;
+    
     // Recording-Task starten
     BaseType_t result = xTaskCreatePinnedToCore(
         recordingTask,
@@ -189,11 +322,11 @@ bool AudioManager::startRecording() {
     
     if (result != pdPASS) {
         Serial.println("AudioManager: Fehler beim Erstellen der Recording-Task");
+        micEnabled = false;
         xSemaphoreGive(audioMutex);
         return false;
     }
     
-    micEnabled = true;
     currentState = AudioState::RECORDING;
     silenceCounter = 0;
     isSilenceDetected = false;
@@ -208,27 +341,47 @@ bool AudioManager::stopRecording() {
         return false;
     }
     
-    if (currentState != AudioState::RECORDING) {
+    if (!micEnabled) {
         xSemaphoreGive(audioMutex);
         return true; // Bereits gestoppt
     }
     
     micEnabled = false;
-    currentState = AudioState::IDLE;
+    currentState = speakerEnabled ? AudioState::PLAYING : AudioState::IDLE;
     
-    // Task stoppen
-    if (recordingTaskHandle) {
-        vTaskDelete(recordingTaskHandle);
-        recordingTaskHandle = nullptr;
+    xSemaphoreGive(audioMutex);
+    
+    // Task beendet sich nach dem laufenden i2s_read selbst. Nicht hart löschen,
+    // da sie während eines Senke-Aufrufs fremde Mutexe halten kann. Reicht die
+    // Zeit nicht, bleibt das Handle gesetzt: startRecording() und der
+    // Geometrie-Wechsel warten dann auf sie.
+    if (!waitRecordingTaskExit()) {
+        Serial.println("AudioManager: Recording-Task noch nicht beendet");
     }
     
-    xSemaphoreGive(audioMutex);
+    // Zwischen Äußerungen: DMA-Geometrie nachführen
+    applyLatencyConfig();
+    
     Serial.println("AudioManager: Aufnahme gestoppt");
     return true;
 }
 
+bool AudioManager::waitRecordingTaskExit() {
+    // Nur hier wird das Handle zurückgesetzt. Die Task meldet ihr Ende genau
+    // einmal über recordingExited; wer es abholt (stopRecording() oder
+    // startRecording() unter audioMutex), gibt das Handle frei.
+    if (recordingTaskHandle == nullptr) {
+        return true;
+    }
+    if (xSemaphoreTake(recordingExited, pdMS_TO_TICKS(AUDIO_RECORDING_EXIT_MS)) != pdTRUE) {
+        return false;
+    }
+    recordingTaskHandle = nullptr;
+    return true;
+}
+
 bool AudioManager::isRecording() const {
-    return currentState == AudioState::RECORDING;
+    return micEnabled;
 }
 
 size_t AudioManager::getAvailableAudio() {
@@ -265,13 +418,13 @@ bool AudioManager::startPlaying() {
         return false;
     }
     
-    if (currentState == AudioState::PLAYING) {
+    if (speakerEnabled) {
         xSemaphoreGive(audioMutex);
         return true; // Bereits aktiv
     }
     
     // Ring-Puffer zurücksetzen
-    resetRingBuffer(speakerBuffer);
+    discardSpeakerBuffer();
     
     speakerEnabled = true;
     currentState = AudioState::PLAYING;
@@ -289,7 +442,7 @@ bool AudioManager::startPlaying() {
     if (result != pdPASS) {
         Serial.println("AudioManager: Fehler beim Erstellen der Playing-Task");
         speakerEnabled = false;
-        currentState = AudioState::IDLE;
+        currentState = micEnabled ? AudioState::RECORDING : AudioState::IDLE;
         xSemaphoreGive(audioMutex);
         return false;
     }
@@ -304,7 +457,7 @@ bool AudioManager::stopPlaying() {
         return false;
     }
     
-    if (currentState != AudioState::PLAYING) {
+    if (!speakerEnabled) {
         xSemaphoreGive(audioMutex);
         return true; // Bereits gestoppt
     }
@@ -318,7 +471,7 @@ bool AudioManager::stopPlaying() {
 }
 
 bool AudioManager::isPlaying() const {
-    return currentState == AudioState::PLAYING;
+    return speakerEnabled;
 }
 
 bool AudioManager::writeAudio(const uint8_t* data, size_t length) {
@@ -326,19 +479,7 @@ bool AudioManager::writeAudio(const uint8_t* data, size_t length) {
         return false;
     }
     
-    // Lautsprecher starten falls noch nicht aktiv
-    startSpeaker();
-    
-    // Audiodaten in Ring-Puffer schreiben
-    if (xSemaphoreTake(audioMutex, pdMS_TO_TICKS(100)) != pdTRUE) {
-        Serial.println("AudioManager: Fehler beim Zugriff auf Audio-Mutex");
-        return false;
-    }
-    
-    updateRingBuffer(speakerBuffer, data, length);
-    xSemaphoreGive(audioMutex);
-    
-    return true;
+    return queueDownlinkAudio(data, length);
 }
 
 bool AudioManager::writeAudioChunk(const AudioChunk& chunk) {
@@ -367,7 +508,7 @@ void AudioManager::clearSpeakerBuffer() {
         return;
     }
     
-    resetRingBuffer(speakerBuffer);
+    discardSpeakerBuffer();
     xSemaphoreGive(audioMutex);
 }
 
@@ -379,6 +520,178 @@ size_t AudioManager::getSpeakerBufferAvailable() const {
     return speakerBuffer.available;
 }
 
+// =============================================================================
+// PRE-ROLL & STREAMING-SENKE
+// =============================================================================
+
+void AudioManager::setAudioSink(AudioSinkCallback sink) {
+    audioSink = sink;
+}
+
+bool AudioManager::hasPreRollData() const {
+    return preRoll.usedBlocks > 0 || preRoll.pendingCount > 0;
+}
+
+bool AudioManager::flushPreRollBacklog() {
+    // Während der Aufnahme leert die Recording-Task den Puffer selbst. Startet
+    // sie gerade, wartet sie am Mutex, bis der Rückstand vor ihrem Live-Audio liegt.
+    if (!audioSink || recordingTaskHandle || !hasPreRollData()) {
+        return false;
+    }
+    if (xSemaphoreTake(preRollMutex, 0) != pdTRUE) {
+        return false;
+    }
+    
+    bool flushed = flushPreRoll();
+    xSemaphoreGive(preRollMutex);
+    return flushed;
+}
+
+StreamMark AudioManager::openStream() {
+    StreamMark mark;
+    
+    // Der Block, den die DMA gerade füllt, ist der erste gesendete
+    portENTER_CRITICAL(&captureMux);
+    streamStartSample = capturedSamples;
+    mark.sampleIndex = streamStartSample;
+    mark.captureTimestampUs = sampleTimestampUs(mark.sampleIndex);
+    streamOpen = true;
+    portEXIT_CRITICAL(&captureMux);
+    
+    return mark;
+}
+
+StreamMark AudioManager::closeStream() {
+    StreamMark mark;
+    
+    portENTER_CRITICAL(&captureMux);
+    streamOpen = false;
+    mark.sampleIndex = capturedSamples;
+    mark.captureTimestampUs = sampleTimestampUs(mark.sampleIndex);
+    portEXIT_CRITICAL(&captureMux);
+    
+    return mark;
+}
+
+bool AudioManager::isStreamOpen() const {
+    return streamOpen;
+}
+
+int64_t AudioManager::sampleTimestampUs(uint64_t sampleIndex) const {
+    // Rückgerechnet vom Ende des zuletzt gelesenen DMA-Blocks
+    int64_t offsetSamples = (int64_t)sampleIndex - (int64_t)capturedSamples;
+    return lastBlockEndUs + offsetSamples * 1000000LL / I2S_SAMPLE_RATE;
+}
+
+// =============================================================================
+// ENDPOINTING
+// =============================================================================
+
+void AudioManager::setEndpointingEnabled(bool enabled) {
+    endpoint.enabled = enabled;
+}
+
+bool AudioManager::isEndpointingEnabled() const {
+    return endpoint.enabled;
+}
+
+void AudioManager::setAudioEventCallback(AudioEventCallback callback) {
+    audioEventCallback = callback;
+}
+
+void AudioManager::resetEndpointing() {
+    endpoint.noiseFloor = 0.0f;
+    endpoint.noiseFloorValid = false;
+    endpoint.speechMs = 0;
+    endpoint.silenceMs = 0;
+    endpoint.endSignalled = false;
+    endpoint.speechStartSample = 0;
+    endpoint.lastSpeechSample = 0;
+}
+
+void AudioManager::processEndpointing(const int16_t* samples, size_t count, uint64_t blockStartSample) {
+    const size_t frameSamples = I2S_SAMPLE_RATE / 1000 * ENDPOINT_FRAME_MS;
+    
+    for (size_t offset = 0; offset + frameSamples <= count; offset += frameSamples) {
+        const int16_t* frame = samples + offset;
+        
+        // Energie (mittlerer Betrag) und Nulldurchgangsrate des Frames
+        uint32_t sum = 0;
+        uint32_t zeroCrossings = 0;
+        for (size_t i = 0; i < frameSamples; i++) {
+            sum += abs(frame[i]);
+            if (i > 0 && ((frame[i] ^ frame[i - 1]) < 0)) {
+                zeroCrossings++;
+            }
+        }
+        float energy = (float)sum / frameSamples;
+        
+        if (!endpoint.noiseFloorValid) {
+            endpoint.noiseFloor = energy;
+            endpoint.noiseFloorValid = true;
+        }
+        
+        float threshold = max((float)ENDPOINT_MIN_ENERGY, endpoint.noiseFloor * ENDPOINT_SPEECH_RATIO);
+        bool isSpeech = energy > threshold &&
+                        zeroCrossings * 100 < frameSamples * ENDPOINT_MAX_ZCR_PERCENT;
+        
+        if (isSpeech) {
+            // Neue Äußerung nach bereits gemeldetem Ende
+            if (endpoint.endSignalled) {
+                endpoint.endSignalled = false;
+                endpoint.speechMs = 0;
+            }
+            if (endpoint.speechMs == 0) {
+                endpoint.speechStartSample = blockStartSample + offset;
+            }
+            endpoint.speechMs += ENDPOINT_FRAME_MS;
+            endpoint.silenceMs = 0;
+            endpoint.lastSpeechSample = blockStartSample + offset + frameSamples;
+        } else {
+            // Grundpegel nur in Nicht-Sprach-Frames nachführen (schnell fallend, langsam steigend)
+            float rate = energy < endpoint.noiseFloor ? 0.3f : 0.05f;
+            endpoint.noiseFloor += (energy - endpoint.noiseFloor) * rate;
+            
+            // Vereinzelte Sprach-Frames ohne Mindestdauer verwerfen
+            if (endpoint.speechMs < ENDPOINT_MIN_SPEECH_MS) {
+                endpoint.speechMs = 0;
+                continue;
+            }
+            endpoint.silenceMs += ENDPOINT_FRAME_MS;
+        }
+        
+        if (!endpoint.endSignalled &&
+            endpoint.speechMs >= ENDPOINT_MIN_SPEECH_MS &&
+            endpoint.silenceMs >= ENDPOINT_TRAILING_SILENCE_MS) {
+            endpoint.endSignalled = true;
+            
+            if (audioEventCallback) {
+                EventField fields[] = {
+                    { ControlTag::SPEECH_START_SAMPLE, (int64_t)endpoint.speechStartSample },
+                    { ControlTag::SPEECH_END_SAMPLE, (int64_t)endpoint.lastSpeechSample },
+                    { ControlTag::CAPTURE_TIMESTAMP, sampleTimestampUs(endpoint.lastSpeechSample) },
+                    { ControlTag::TRAILING_SILENCE_MS, (int64_t)endpoint.silenceMs },
+                };
+                audioEventCallback(EVENT_UTTERANCE_END, fields, sizeof(fields) / sizeof(fields[0]));
+            }
+            Serial.printf("AudioManager: Äußerungsende erkannt (Sample %llu)\n",
+                          (unsigned long long)endpoint.lastSpeechSample);
+        }
+    }
+}
+
+PreRollStats AudioManager::getPreRollStats() const {
+    PreRollStats stats;
+    size_t bufferedSamples = preRoll.usedBlocks * AUDIO_PREROLL_BLOCK_SAMPLES + preRoll.pendingCount;
+    stats.usedBytes = preRoll.usedBlocks * AUDIO_PREROLL_BLOCK_SIZE;
+    stats.capacityBytes = preRoll.blockCount * AUDIO_PREROLL_BLOCK_SIZE;
+    stats.bufferedMs = (uint32_t)(bufferedSamples * 1000 / I2S_SAMPLE_RATE);
+    stats.capacityMs = (uint32_t)(preRoll.blockCount * AUDIO_PREROLL_BLOCK_SAMPLES * 1000 / I2S_SAMPLE_RATE);
+    stats.droppedBlocks = preRoll.droppedBlocks;
+    stats.lockTimeouts = preRoll.lockTimeouts;
+    return stats;
+}
+
 // =============================================================================
 // AUDIO-KONFIGURATION
 // =============================================================================
@@ -468,6 +781,28 @@ void AudioManager::printBufferStatus() {
                   speakerBuffer.available,
                   speakerBuffer.isFull ? "true" : "false",
                   speakerBuffer.isEmpty ? "true" : "false");
+    
+    LatencyStats speakerStats = speakerLatency.getStats();
+    LatencyStats micStats = micLatency.getStats();
+    Serial.printf("AudioManager: DMA Lautsprecher %u x %u (%u ms), Mikrofon %u x %u (%u ms)\n",
+                  (unsigned)speakerStats.geometry.bufCount, (unsigned)speakerStats.geometry.bufLen,
+                  (unsigned)speakerStats.bufferMs,
+                  (unsigned)micStats.geometry.bufCount, (unsigned)micStats.geometry.bufLen,
+                  (unsigned)micStats.bufferMs);
+    
+    PreRollStats preRollStats = getPreRollStats();
+    Serial.printf("AudioManager: Pre-Roll - %u/%u Bytes, %u/%u ms, Verworfen: %u Blöcke, Sperre belegt: %u\n",
+                  (unsigned)preRollStats.usedBytes,
+                  (unsigned)preRollStats.capacityBytes,
+                  (unsigned)preRollStats.bufferedMs,
+                  (unsigned)preRollStats.capacityMs,
+                  (unsigned)preRollStats.droppedBlocks,
+                  (unsigned)preRollStats.lockTimeouts);
+    
+    Serial.printf("AudioManager: Wiedergabe-Queue - %u/%u Clips, Prefetch: %u Bytes\n",
+                  (unsigned)playbackQueueCount,
+                  (unsigned)AUDIO_PLAYBACK_QUEUE_SIZE,
+                  (unsigned)prefetchBuffer.available);
 }
 
 void AudioManager::printAudioStats() {
@@ -483,6 +818,9 @@ void AudioManager::printAudioStats() {
 // =============================================================================
 
 bool AudioManager::initI2SMicrophone() {
+    // Geometrie vom Latenz-Regler
+    micGeometry = micLatency.getGeometry();
+    
     // I2S-Konfiguration für Mikrofon
     i2s_config_t i2sConfig = {
         .mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_RX),
@@ -491,8 +829,8 @@ bool AudioManager::initI2SMicrophone() {
         .channel_format = I2S_CHANNEL_FMT_ONLY_LEFT,
         .communication_format = I2S_COMM_FORMAT_STAND_I2S,
         .intr_alloc_flags = ESP_INTR_FLAG_LEVEL1,
-        .dma_buf_count = 8,
-        .dma_buf_len = I2S_BUFFER_SIZE,
+        .dma_buf_count = micGeometry.bufCount,
+        .dma_buf_len = micGeometry.bufLen,
         .use_apll = false,
         .tx_desc_auto_clear = false,
         .fixed_mclk = 0
@@ -520,11 +858,16 @@ bool AudioManager::initI2SMicrophone() {
         return false;
     }
     
-    Serial.println("AudioManager: I2S-Mikrofon initialisiert");
+    Serial.printf("AudioManager: I2S-Mikrofon initialisiert (DMA %u x %u)\n",
+                  (unsigned)micGeometry.bufCount, (unsigned)micGeometry.bufLen);
     return true;
 }
 
 bool AudioManager::initI2SSpeaker() {
+    // Geometrie vom Latenz-Regler, TX_DONE-Zählung braucht die Puffergröße
+    DmaGeometry speakerGeometry = speakerLatency.getGeometry();
+    speakerDmaFrames = speakerGeometry.bufLen;
+    
     // I2S-Konfiguration für Lautsprecher
     i2s_config_t i2sConfig = {
         .mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_TX),
@@ -533,8 +876,8 @@ bool AudioManager::initI2SSpeaker() {
         .channel_format = I2S_CHANNEL_FMT_ONLY_LEFT,
         .communication_format = I2S_COMM_FORMAT_STAND_I2S,
         .intr_alloc_flags = ESP_INTR_FLAG_LEVEL1,
-        .dma_buf_count = 8,
-        .dma_buf_len = I2S_BUFFER_SIZE,
+        .dma_buf_count = speakerGeometry.bufCount,
+        .dma_buf_len = speakerGeometry.bufLen,
         .use_apll = false,
         .tx_desc_auto_clear = true,
         .fixed_mclk = 0
@@ -548,8 +891,8 @@ bool AudioManager::initI2SSpeaker() {
         .data_in_num = I2S_PIN_NO_CHANGE
     };
     
-    // I2S-Treiber installieren
-    esp_err_t err = i2s_driver_install(speakerI2SPort, &i2sConfig, 0, NULL);
+    // I2S-Treiber installieren (Ereignis-Queue liefert TX_DONE je DMA-Puffer)
+    esp_err_t err = i2s_driver_install(speakerI2SPort, &i2sConfig, AUDIO_I2S_EVENT_QUEUE_SIZE, &speakerEventQueue);
     if (err != ESP_OK) {
         Serial.printf("AudioManager: I2S-Treiber Installation fehlgeschlagen: %d\n", err);
         return false;
@@ -562,7 +905,8 @@ bool AudioManager::initI2SSpeaker() {
         return false;
     }
     
-    Serial.println("AudioManager: I2S-Lautsprecher initialisiert");
+    Serial.printf("AudioManager: I2S-Lautsprecher initialisiert (DMA %u x %u)\n",
+                  (unsigned)speakerGeometry.bufCount, (unsigned)speakerGeometry.bufLen);
     return true;
 }
 
@@ -594,9 +938,9 @@ bool AudioManager::detectSilence(const uint8_t* data, size_t length) {
     return average < AUDIO_SILENCE_THRESHOLD;
 }
 
-void AudioManager::updateRingBuffer(AudioRingBuffer& buffer, const uint8_t* data, size_t length) {
+size_t AudioManager::updateRingBuffer(AudioRingBuffer& buffer, const uint8_t* data, size_t length) {
     if (!data || length == 0 || buffer.isFull) {
-        return;
+        return 0;
     }
     
     size_t bytesToWrite = min(length, buffer.size - buffer.available);
@@ -609,6 +953,8 @@ void AudioManager::updateRingBuffer(AudioRingBuffer& buffer, const uint8_t* data
     
     buffer.isFull = (buffer.available >= buffer.size);
     buffer.isEmpty = (buffer.available == 0);
+    
+    return bytesToWrite;
 }
 
 size_t AudioManager::readFromRingBuffer(AudioRingBuffer& buffer, uint8_t* data, size_t maxLength) {
@@ -638,6 +984,116 @@ void AudioManager::resetRingBuffer(AudioRingBuffer& buffer) {
     buffer.isEmpty = true;
 }
 
+void AudioManager::deliverCapturedAudio(const uint8_t* data, size_t length) {
+    // Ohne Senke: klassischer Pull-Betrieb über readAudio()
+    if (!audioSink) {
+        if (xSemaphoreTake(audioMutex, pdMS_TO_TICKS(10)) == pdTRUE) {
+            updateRingBuffer(micBuffer, data, length);
+            xSemaphoreGive(audioMutex);
+        }
+        return;
+    }
+    
+    // Pre-Roll gehört unter dem Mutex einer Task; leert die Netzwerk-Task gerade
+    // den Rückstand, folgt das Live-Audio danach
+    if (xSemaphoreTake(preRollMutex, pdMS_TO_TICKS(AUDIO_PREROLL_LOCK_MS)) != pdTRUE) {
+        preRoll.lockTimeouts++;
+        return;
+    }
+    
+    // Erst den Rückstand aus dem Pre-Roll senden, dann live weiter
+    if (hasPreRollData() && !flushPreRoll()) {
+        writeToPreRoll((const int16_t*)data, length / sizeof(int16_t));
+    } else if (!audioSink(data, length)) {
+        writeToPreRoll((const int16_t*)data, length / sizeof(int16_t));
+    }
+    xSemaphoreGive(preRollMutex);
+}
+
+void AudioManager::writeToPreRoll(const int16_t* samples, size_t count) {
+    if (!preRoll.blocks) {
+        return;
+    }
+    
+    while (count > 0) {
+        size_t space = AUDIO_PREROLL_BLOCK_SAMPLES - preRoll.pendingCount;
+        size_t n = min(space, count);
+        memcpy(&preRoll.pending[preRoll.pendingCount], samples, n * sizeof(int16_t));
+        preRoll.pendingCount += n;
+        samples += n;
+        count -= n;
+        
+        if (preRoll.pendingCount == AUDIO_PREROLL_BLOCK_SAMPLES) {
+            encodePreRollBlock(preRoll.pending);
+            preRoll.pendingCount = 0;
+        }
+    }
+}
+
+void AudioManager::encodePreRollBlock(const int16_t* samples) {
+    // Voller Ring: ältesten Block überschreiben, neueste Sprache hat Vorrang
+    if (preRoll.usedBlocks == preRoll.blockCount) {
+        preRoll.readBlock = (preRoll.readBlock + 1) % preRoll.blockCount;
+        preRoll.usedBlocks--;
+        preRoll.droppedBlocks++;
+    }
+    
+    uint8_t* block = preRoll.blocks + preRoll.writeBlock * AUDIO_PREROLL_BLOCK_SIZE;
+    AdpcmBlockHeader header;
+    header.predictor = preRoll.encoderState.predictor;
+    header.stepIndex = preRoll.encoderState.stepIndex;
+    header.reserved = 0;
+    memcpy(block, &header, sizeof(header));
+    AdpcmCodec::encode(preRoll.encoderState, samples, AUDIO_PREROLL_BLOCK_SAMPLES, block + sizeof(header));
+    
+    preRoll.writeBlock = (preRoll.writeBlock + 1) % preRoll.blockCount;
+    preRoll.usedBlocks++;
+}
+
+bool AudioManager::flushPreRoll() {
+    int16_t pcm[AUDIO_PREROLL_BLOCK_SAMPLES];
+    
+    // Blöcke erst nach erfolgreicher Übergabe freigeben
+    while (preRoll.usedBlocks > 0) {
+        const uint8_t* block = preRoll.blocks + preRoll.readBlock * AUDIO_PREROLL_BLOCK_SIZE;
+        AdpcmBlockHeader header;
+        memcpy(&header, block, sizeof(header));
+        
+        AdpcmState state;
+        state.predictor = header.predictor;
+        state.stepIndex = header.stepIndex;
+        AdpcmCodec::decode(state, block + sizeof(header), AUDIO_PREROLL_BLOCK_SAMPLES, pcm);
+        
+        if (!audioSink((const uint8_t*)pcm, sizeof(pcm))) {
+            return false;
+        }
+        
+        preRoll.readBlock = (preRoll.readBlock + 1) % preRoll.blockCount;
+        preRoll.usedBlocks--;
+    }
+    
+    // Unkodierter Rest liegt noch als PCM vor
+    if (preRoll.pendingCount > 0) {
+        if (!audioSink((const uint8_t*)preRoll.pending, preRoll.pendingCount * sizeof(int16_t))) {
+            return false;
+        }
+        preRoll.pendingCount = 0;
+    }
+    
+    AdpcmCodec::resetState(preRoll.encoderState);
+    return true;
+}
+
+void AudioManager::resetPreRoll() {
+    preRoll.readBlock = 0;
+    preRoll.writeBlock = 0;
+    preRoll.usedBlocks = 0;
+    preRoll.pendingCount = 0;
+    preRoll.droppedBlocks = 0;
+    preRoll.lockTimeouts = 0;
+    AdpcmCodec::resetState(preRoll.encoderState);
+}
+
 // =============================================================================
 // FREERTOS-TASKS
 // =============================================================================
@@ -648,17 +1104,43 @@ void AudioManager::recordingTask(void* parameter) {
     uint8_t* audioBuffer = (uint8_t*)malloc(I2S_BUFFER_SIZE);
     if (!audioBuffer) {
         Serial.println("AudioManager: Fehler beim Allozieren des Audio-Buffers");
+        xSemaphoreGive(manager->recordingExited);
         vTaskDelete(nullptr);
         return;
     }
     
     Serial.println("AudioManager: Recording-Task gestartet");
     
+    int64_t lastReadUs = 0;
+    
     while (manager->micEnabled) {
         size_t bytesRead = 0;
         esp_err_t err = i2s_read(manager->micI2SPort, audioBuffer, I2S_BUFFER_SIZE, &bytesRead, portMAX_DELAY);
         
         if (err == ESP_OK && bytesRead > 0) {
+            // Jitter: Abstand der Lesevorgänge gegenüber der Blockdauer. Länger
+            // als die DMA-Kapazität heißt, dass Samples verloren gingen.
+            int64_t nowUs = esp_timer_get_time();
+            if (lastReadUs != 0) {
+                uint32_t intervalUs = (uint32_t)(nowUs - lastReadUs);
+                uint32_t expectedUs = (uint32_t)((bytesRead / sizeof(int16_t)) * 1000000ULL / I2S_SAMPLE_RATE);
+                manager->micLatency.recordInterval(intervalUs, expectedUs);
+                uint32_t capacityUs = (uint32_t)((uint32_t)manager->micGeometry.bufCount * manager->micGeometry.bufLen
+                                                 * 1000000ULL / I2S_SAMPLE_RATE);
+                if (intervalUs > capacityUs) {
+                    manager->micLatency.recordDropout();
+                }
+            }
+            lastReadUs = nowUs;
+            
+            // Aufnahme-Uhr fortschreiben und Gate für diesen Block auswerten
+            portENTER_CRITICAL(&manager->captureMux);
+            uint64_t blockStart = manager->capturedSamples;
+            manager->capturedSamples += bytesRead / sizeof(int16_t);
+            manager->lastBlockEndUs = esp_timer_get_time();
+            bool sendBlock = manager->streamOpen && blockStart >= manager->streamStartSample;
+            portEXIT_CRITICAL(&manager->captureMux);
+            
             // Stille-Erkennung
             bool isSilence = manager->detectSilence(audioBuffer, bytesRead);
             
@@ -672,10 +1154,14 @@ void AudioManager::recordingTask(void* parameter) {
                 manager->isSilenceDetected = false;
             }
             
-            // Daten in Ring-Puffer schreiben
-            if (xSemaphoreTake(manager->audioMutex, pdMS_TO_TICKS(10)) == pdTRUE) {
-                manager->updateRingBuffer(manager->micBuffer, audioBuffer, bytesRead);
-                xSemaphoreGive(manager->audioMutex);
+            // An Senke übergeben bzw. in Ring-/Pre-Roll-Puffer schreiben,
+            // bei geschlossenem Gate verwerfen
+            if (sendBlock) {
+                manager->deliverCapturedAudio(audioBuffer, bytesRead);
+                
+                if (manager->endpoint.enabled) {
+                    manager->processEndpointing((const int16_t*)audioBuffer, bytesRead / sizeof(int16_t), blockStart);
+                }
             }
         }
         
@@ -685,6 +1171,9 @@ void AudioManager::recordingTask(void* parameter) {
     
     free(audioBuffer);
     Serial.println("AudioManager: Recording-Task beendet");
+    
+    // Handle nicht selbst zurücksetzen: es könnte schon einer neuen Task gehören
+    xSemaphoreGive(manager->recordingExited);
     vTaskDelete(nullptr);
 }
 
@@ -703,31 +1192,122 @@ if (!audioBuffer || !silenceBuffer) {
 memset(silenceBuffer, 0, I2S_BUFFER_SIZE); // Stille-Puffer mit Nullen füllen
 Serial.println("AudioManager: Playing-Task gestartet");
 
+PlaybackMark marks[2 * AUDIO_PLAYBACK_QUEUE_SIZE];
 uint32_t lastDataTime = millis();
-const uint32_t TIMEOUT_MS = 500;
+int64_t lastWriteUs = 0;
+uint32_t lastProgressTime = 0;
 
 while (true) {
 size_t bytesToWrite = 0;
+size_t markCount = 0;
+size_t queuedClips = 0;
+
+// Barge-in: bereits geschriebene Ausgabe sofort verwerfen
+if (manager->bargeInPending) {
+    manager->handleBargeIn();
+}
+
+// Von der DMA ausgegebene Samples erfassen und fällige Marken melden
+manager->updatePlaybackPosition();
+manager->emitDueMarks();
+
+// Inhalt vollständig ausgegeben: Server kann sofort wieder zuhören
+if (manager->contentPending && manager->playbackQueueCount == 0 &&
+    manager->playbackPlayedSamples >= manager->contentEndSample) {
+    manager->contentPending = false;
+    if (manager->audioEventCallback) {
+        EventField fields[] = {
+            { ControlTag::SAMPLE_INDEX, (int64_t)manager->contentEndSample },
+            { ControlTag::TIMESTAMP, manager->playedTimestampUs(manager->contentEndSample) },
+            { ControlTag::LAST_CLIP_ID, (int64_t)manager->audibleClipId },
+        };
+        manager->audioEventCallback(EVENT_PLAYBACK_DONE, fields, sizeof(fields) / sizeof(fields[0]));
+    }
+    Serial.printf("AudioManager: Wiedergabe beendet bei Sample %llu\n",
+                  (unsigned long long)manager->contentEndSample);
+}
 
+// Fortschrittsmeldung während der Wiedergabe
+if (manager->contentPending && millis() - lastProgressTime >= AUDIO_PLAYBACK_PROGRESS_MS) {
+    lastProgressTime = millis();
+    if (manager->audioEventCallback) {
+        PlaybackPosition position = manager->getPlaybackPosition();
+        EventField fields[] = {
+            { ControlTag::SAMPLE_INDEX, (int64_t)position.playedSamples },
+            { ControlTag::TIMESTAMP, (int64_t)manager->lastTxDoneUs },
+            { ControlTag::CLIP_ID, (int64_t)position.clipId },
+            { ControlTag::CLIP_SAMPLE, (int64_t)position.clipSample },
+        };
+        manager->audioEventCallback(EVENT_PLAYBACK_PROGRESS, fields, sizeof(fields) / sizeof(fields[0]));
+    }
+}
+
+// Block über Clip-Grenzen hinweg füllen (lückenlos)
 if (xSemaphoreTake(manager->audioMutex, pdMS_TO_TICKS(10)) == pdTRUE) {
-    bytesToWrite = manager->readFromRingBuffer(manager->speakerBuffer, audioBuffer, I2S_BUFFER_SIZE);
+    bytesToWrite = manager->renderPlayback(audioBuffer, I2S_BUFFER_SIZE, marks, &markCount);
+    queuedClips = manager->playbackQueueCount;
     xSemaphoreGive(manager->audioMutex);
 }
 
+// Clip-Übergänge erst melden, wenn die DMA sie erreicht
+for (size_t i = 0; i < markCount; i++) {
+    manager->pushPlaybackMark(marks[i]);
+}
+
+// Vor dem Barge-in gerenderter Block wird nicht mehr ausgegeben
+if (manager->bargeInPending) {
+    continue;
+}
+
 if (bytesToWrite > 0) {
     // Echte Audiodaten erhalten, sende audioBuffer
     lastDataTime = millis();
+    
+    // In DMA-Puffer-Stücken schreiben: ein Barge-in wartet höchstens einen
+    // Puffer auf i2s_zero_dma_buffer, der Rest des Blocks entfällt
+    size_t chunkBytes = manager->speakerDmaFrames * sizeof(int16_t);
     size_t bytesWritten = 0;
-    i2s_write(manager->speakerI2SPort, audioBuffer, bytesToWrite, &bytesWritten, portMAX_DELAY);
+    while (bytesWritten < bytesToWrite && !manager->bargeInPending) {
+        size_t written = 0;
+        i2s_write(manager->speakerI2SPort, audioBuffer + bytesWritten, min(chunkBytes, bytesToWrite - bytesWritten),
+                  &written, portMAX_DELAY);
+        bytesWritten += written;
+    }
+    manager->playbackWrittenSamples += bytesWritten / sizeof(int16_t);
+    manager->contentEndSample = manager->playbackWrittenSamples;
+    manager->contentPending = true;
+    
+    // Jitter bei fortlaufender Ausgabe: i2s_write kehrt im DMA-Takt zurück
+    int64_t nowUs = esp_timer_get_time();
+    if (lastWriteUs != 0) {
+        uint32_t expectedUs = (uint32_t)((bytesWritten / sizeof(int16_t)) * 1000000ULL / I2S_SAMPLE_RATE);
+        manager->speakerLatency.recordInterval((uint32_t)(nowUs - lastWriteUs), expectedUs);
+    }
+    lastWriteUs = nowUs;
 } else {
-    // Keine Daten verfügbar, prüfe auf Timeout
-    if (millis() - lastDataTime > TIMEOUT_MS) {
+    lastWriteUs = 0;
+    uint32_t idleMs = millis() - lastDataTime;
+    
+    // Queue leer und DMA ausgespielt: nach Timeout Lautsprecher abschalten.
+    // Ohne TX-Ereignisse greift spätestens der Stall-Timeout.
+    if (queuedClips == 0 && idleMs > AUDIO_PLAYBACK_IDLE_TIMEOUT_MS &&
+        (!manager->contentPending || idleMs > AUDIO_PLAYBACK_STALL_TIMEOUT_MS)) {
         Serial.println("[AudioManager] Playback Timeout. Stopping speaker...");
         break; // Schleife verlassen und Task beenden
     }
-    // Noch kein Timeout, sende Stille, um Rauschen zu vermeiden
+    
+    // Queue wartet auf Daten, die nicht mehr kommen
+    if (queuedClips > 0 && idleMs > AUDIO_PLAYBACK_STALL_TIMEOUT_MS) {
+        Serial.printf("[AudioManager] Wiedergabe-Queue hängt, verwerfe %u Clips\n", (unsigned)queuedClips);
+        manager->clearPlaybackQueue();
+        lastDataTime = millis();
+        continue;
+    }
+    
+    // Kurze Stille-Blöcke, damit neue Daten ohne große Verzögerung folgen
     size_t bytesWritten = 0;
-    i2s_write(manager->speakerI2SPort, silenceBuffer, I2S_BUFFER_SIZE, &bytesWritten, portMAX_DELAY);
+    i2s_write(manager->speakerI2SPort, silenceBuffer, I2S_BUFFER_SIZE / 4, &bytesWritten, portMAX_DELAY);
+    manager->playbackWrittenSamples += bytesWritten / sizeof(int16_t);
 }
 vTaskDelay(pdMS_TO_TICKS(1));
 }
@@ -737,6 +1317,9 @@ free(silenceBuffer);
 
 manager->stopSpeaker();
 
+// Zwischen Antworten: DMA-Geometrie für den nächsten Start nachführen
+manager->applyLatencyConfig();
+
 Serial.println("[AudioManager] PlayingTask DELETED.");
 vTaskDelete(nullptr);
 
@@ -754,6 +1337,9 @@ void AudioManager::startSpeaker() {
     
     Serial.println("[AudioManager] Speaker START requested...");
     
+    // Neuer Wiedergabe-Zeitstrahl
+    resetPlaybackPosition();
+    
     // Verstärker physisch einschalten
     enableAmplifier();
     
@@ -803,6 +1389,7 @@ void AudioManager::stopSpeaker() {
     
     // I2S-Treiber deinstallieren
     i2s_driver_uninstall(speakerI2SPort);
+    speakerEventQueue = nullptr;    // Gehört dem Treiber
     Serial.println("[AudioManager] I2S driver UNINSTALLED.");
     
     // Verstärker physisch ausschalten
@@ -812,7 +1399,7 @@ void AudioManager::stopSpeaker() {
     playingTaskHandle = nullptr;
     
     speakerEnabled = false;
-    currentState = AudioState::IDLE;
+    currentState = micEnabled ? AudioState::RECORDING : AudioState::IDLE;   // Laufende Aufnahme bleibt sichtbar
     m_speakerState = SpeakerState::INACTIVE;
     
     Serial.println("AudioManager: Lautsprecher deaktiviert");
@@ -849,23 +1436,869 @@ bool AudioManager::playChunk(const uint8_t* data, size_t size) {
         return false;
     }
     
+    return queueDownlinkAudio(data, size);
+}
+
+bool AudioManager::queueDownlinkAudio(const uint8_t* data, size_t length) {
     // Lautsprecher starten falls noch nicht aktiv
     startSpeaker();
     
     // Audiodaten in Ring-Puffer schreiben
     if (xSemaphoreTake(audioMutex, pdMS_TO_TICKS(100)) != pdTRUE) {
         Serial.println("AudioManager: Fehler beim Zugriff auf Audio-Mutex");
+        downlinkDroppedBytes += length;
+        return false;
+    }
+    
+    if (!admitDownlink(length)) {
+        xSemaphoreGive(audioMutex);
+        return true;
+    }
+    
+    size_t written = updateRingBuffer(speakerBuffer, data, length);
+    attributeDownlink(written);
+    xSemaphoreGive(audioMutex);
+    
+    // Bei eingehaltenen Credits bleibt dieser Zähler bei 0
+    if (written < length) {
+        downlinkDroppedBytes += length - written;
+        Serial.printf("AudioManager: Wiedergabe-Puffer voll, %u Bytes verworfen\n", (unsigned)(length - written));
+        return false;
+    }
+    
+    return true;
+}
+
+bool AudioManager::reservePlayout(size_t maxBytes, PlayoutReservation& reservation) {
+    reservation.total = 0;
+    
+    // Lautsprecher starten falls noch nicht aktiv
+    startSpeaker();
+    
+    if (xSemaphoreTake(audioMutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+        return false;
+    }
+    
+    // Freier Bereich ab writeIndex, ggf. über das Pufferende hinweg. Der
+    // Playing-Task liest nur belegte Bytes, daher ist der Bereich exklusiv.
+    size_t space = min(maxBytes, speakerBuffer.size - speakerBuffer.available);
+    size_t first = min(space, speakerBuffer.size - speakerBuffer.writeIndex);
+    reservation.segment[0] = speakerBuffer.buffer + speakerBuffer.writeIndex;
+    reservation.length[0] = first;
+    reservation.segment[1] = speakerBuffer.buffer;
+    reservation.length[1] = space - first;
+    reservation.total = space;
+    reservation.generation = speakerGeneration;
+    
+    xSemaphoreGive(audioMutex);
+    return space > 0;
+}
+
+bool AudioManager::commitPlayout(const PlayoutReservation& reservation, size_t bytesWritten) {
+    if (bytesWritten == 0) {
+        return true;
+    }
+    
+    if (xSemaphoreTake(audioMutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+        downlinkDroppedBytes += bytesWritten;
+        return false;
+    }
+    
+    // Puffer wurde zwischenzeitlich geleert (Barge-in, Stall): Daten verwerfen,
+    // für die Credits aber als empfangen und verbraucht zählen
+    if (reservation.generation != speakerGeneration || !admitDownlink(bytesWritten)) {
+        if (reservation.generation != speakerGeneration) {
+            downlinkReceivedBytes += bytesWritten;
+            downlinkConsumedBytes += bytesWritten;
+        }
+        xSemaphoreGive(audioMutex);
+        return false;
+    }
+    
+    size_t written = min(bytesWritten, reservation.total);
+    speakerBuffer.writeIndex = (speakerBuffer.writeIndex + written) % speakerBuffer.size;
+    speakerBuffer.available += written;
+    speakerBuffer.isFull = (speakerBuffer.available >= speakerBuffer.size);
+    speakerBuffer.isEmpty = (speakerBuffer.available == 0);
+    attributeDownlink(written);
+    
+    xSemaphoreGive(audioMutex);
+    return true;
+}
+
+bool AudioManager::admitDownlink(size_t length) {
+    PlaybackClip* last = lastStreamClip();
+    
+    // Nach Barge-in: Frames der abgebrochenen Antwort sind noch unterwegs
+    if (bargeInHoldoff && millis() - bargeInTime > AUDIO_BARGE_IN_HOLDOFF_MS) {
+        bargeInHoldoff = false;
+    }
+    if (bargeInHoldoff && (!last || (last->endKnown && last->streamEnd <= downlinkReceivedBytes))) {
+        // Als empfangen und verbraucht zählen, damit die Credits stimmen
+        downlinkReceivedBytes += length;
+        downlinkConsumedBytes += length;
+        return false;
+    }
+    return true;
+}
+
+void AudioManager::attributeDownlink(size_t written) {
+    // Downlink ohne passenden queue_clip: impliziter Clip (clipId 0)
+    PlaybackClip* last = lastStreamClip();
+    uint32_t receivedEnd = downlinkReceivedBytes + written;
+    if (written > 0 && (!last || (last->endKnown && last->streamEnd < receivedEnd))) {
+        PlaybackClip clip;
+        memset(&clip, 0, sizeof(clip));
+        clip.source = ClipSource::STREAM;
+        clip.streamStart = last ? max(last->streamEnd, (uint32_t)downlinkReceivedBytes) : downlinkReceivedBytes;
+        enqueueClip(clip);
+    }
+    downlinkReceivedBytes = receivedEnd;
+}
+
+void AudioManager::discardSpeakerBuffer() {
+    // Verworfene Bytes zählen als verbraucht, sonst laufen die Credits auseinander.
+    // Offene Reservierungen werden über die Generation ungültig.
+    downlinkConsumedBytes += speakerBuffer.available;
+    resetRingBuffer(speakerBuffer);
+    speakerGeneration++;
+}
+
+DownlinkCredit AudioManager::getDownlinkCredit() const {
+    DownlinkCredit credit;
+    credit.receivedBytes = downlinkReceivedBytes;
+    credit.consumedBytes = downlinkConsumedBytes;
+    credit.droppedBytes = downlinkDroppedBytes;
+    credit.bufferedBytes = speakerBuffer.available;
+    
+    // Fenster bis zum Ziel-Füllstand, begrenzt durch den freien Platz
+    size_t target = min((size_t)AUDIO_DOWNLINK_TARGET_BYTES, speakerBuffer.size);
+    size_t window = credit.bufferedBytes < target ? target - credit.bufferedBytes : 0;
+    credit.creditLimit = credit.receivedBytes + window;
+    return credit;
+}
+
+// =============================================================================
+// WIEDERGABE-QUEUE
+// =============================================================================
+
+bool AudioManager::queueStreamClip(uint32_t clipId, uint16_t crossfadeMs, uint32_t lengthBytes) {
+    if (clipId == 0) {
+        return false;
+    }
+    if (xSemaphoreTake(audioMutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+        return false;
+    }
+    
+    // Offener Stream-Clip endet dort, wo der neue beginnt
+    uint32_t start = downlinkReceivedBytes;
+    PlaybackClip* last = lastStreamClip();
+    if (last) {
+        if (!last->endKnown) {
+            last->streamEnd = max(last->streamStart, start);
+            last->endKnown = true;
+        }
+        start = max(start, last->streamEnd);
+    }
+    
+    PlaybackClip clip;
+    memset(&clip, 0, sizeof(clip));
+    clip.clipId = clipId;
+    clip.source = ClipSource::STREAM;
+    clip.crossfadeMs = crossfadeMs;
+    clip.streamStart = start;
+    if (lengthBytes > 0) {
+        clip.streamEnd = start + lengthBytes;
+        clip.endKnown = true;
+    }
+    
+    bool queued = enqueueClip(clip);
+    xSemaphoreGive(audioMutex);
+    return queued;
+}
+
+bool AudioManager::endStreamClip(uint32_t clipId, uint32_t lengthBytes) {
+    if (xSemaphoreTake(audioMutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+        return false;
+    }
+    
+    bool found = false;
+    for (size_t i = 0; i < playbackQueueCount; i++) {
+        PlaybackClip* clip = clipAt(i);
+        if (clip->source == ClipSource::STREAM && clip->clipId == clipId) {
+            // Ohne Längenangabe endet der Clip beim aktuellen Downlink-Stand
+            clip->streamEnd = lengthBytes > 0 ? clip->streamStart + lengthBytes
+                                              : max(clip->streamStart, (uint32_t)downlinkReceivedBytes);
+            clip->endKnown = true;
+            found = true;
+            break;
+        }
+    }
+    
+    xSemaphoreGive(audioMutex);
+    return found;
+}
+
+bool AudioManager::queueFlashClip(uint32_t clipId, const char* name, uint16_t crossfadeMs) {
+    const FlashClip* flash = nullptr;
+    for (size_t i = 0; i < flashClipCount; i++) {
+        if (strcmp(flashClips[i].name, name) == 0) {
+            flash = &flashClips[i];
+            break;
+        }
+    }
+    if (!flash || clipId == 0) {
+        Serial.printf("AudioManager: Flash-Clip '%s' nicht registriert\n", name);
+        return false;
+    }
+    
+    PlaybackClip clip;
+    memset(&clip, 0, sizeof(clip));
+    clip.clipId = clipId;
+    clip.source = ClipSource::FLASH;
+    clip.crossfadeMs = crossfadeMs;
+    clip.data = flash->data;
+    clip.length = flash->length;
+    clip.endKnown = true;
+    
+    if (xSemaphoreTake(audioMutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+        return false;
+    }
+    bool queued = enqueueClip(clip);
+    xSemaphoreGive(audioMutex);
+    
+    if (queued) {
+        startSpeaker();
+    }
+    return queued;
+}
+
+bool AudioManager::queueUrlClip(uint32_t clipId, const char* url, uint16_t crossfadeMs) {
+    if (clipId == 0 || !url || strlen(url) == 0 || strlen(url) >= AUDIO_CLIP_URL_MAX) {
+        Serial.println("AudioManager: Ungültige Clip-URL");
+        return false;
+    }
+    
+    PlaybackClip clip;
+    memset(&clip, 0, sizeof(clip));
+    clip.clipId = clipId;
+    clip.source = ClipSource::URL;
+    clip.crossfadeMs = crossfadeMs;
+    strncpy(clip.url, url, AUDIO_CLIP_URL_MAX - 1);
+    
+    if (xSemaphoreTake(audioMutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+        return false;
+    }
+    bool queued = enqueueClip(clip);
+    if (queued) {
+        startPrefetch();
+    }
+    xSemaphoreGive(audioMutex);
+    
+    if (queued) {
+        startSpeaker();
+    }
+    return queued;
+}
+
+bool AudioManager::registerFlashClip(const char* name, const uint8_t* data, size_t length) {
+    // Nur in setup() aufrufen, die Tabelle wird danach nur gelesen
+    if (flashClipCount >= AUDIO_FLASH_CLIP_MAX || !name || strlen(name) >= AUDIO_CLIP_NAME_MAX || !data) {
+        Serial.println("AudioManager: Flash-Clip kann nicht registriert werden");
+        return false;
+    }
+    
+    FlashClip& flash = flashClips[flashClipCount++];
+    strncpy(flash.name, name, AUDIO_CLIP_NAME_MAX - 1);
+    flash.name[AUDIO_CLIP_NAME_MAX - 1] = '\0';
+    flash.data = data;
+    flash.length = length & ~(size_t)1;     // Nur ganze 16-bit-Samples
+    return true;
+}
+
+void AudioManager::clearPlaybackQueue() {
+    if (xSemaphoreTake(audioMutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+        return;
+    }
+    
+    playbackQueueHead = 0;
+    playbackQueueCount = 0;
+    
+    // Laufenden Download abbrechen (Task prüft prefetchClipId)
+    prefetchClipId = 0;
+    resetRingBuffer(prefetchBuffer);
+    
+    // Gepufferten Downlink verwerfen
+    discardSpeakerBuffer();
+    
+    xSemaphoreGive(audioMutex);
+}
+
+size_t AudioManager::getQueuedClipCount() const {
+    return playbackQueueCount;
+}
+
+bool AudioManager::enqueueClip(const PlaybackClip& clip) {
+    if (playbackQueueCount >= AUDIO_PLAYBACK_QUEUE_SIZE) {
+        Serial.println("AudioManager: Wiedergabe-Queue voll");
+        return false;
+    }
+    
+    playbackQueue[(playbackQueueHead + playbackQueueCount) % AUDIO_PLAYBACK_QUEUE_SIZE] = clip;
+    playbackQueueCount++;
+    
+    // Neue Antwort vom Server beendet die Sperre nach einem Barge-in
+    if (clip.clipId != 0) {
+        bargeInHoldoff = false;
+    }
+    return true;
+}
+
+PlaybackClip* AudioManager::clipAt(size_t index) {
+    return &playbackQueue[(playbackQueueHead + index) % AUDIO_PLAYBACK_QUEUE_SIZE];
+}
+
+PlaybackClip* AudioManager::lastStreamClip() {
+    for (size_t i = playbackQueueCount; i > 0; i--) {
+        PlaybackClip* clip = clipAt(i - 1);
+        if (clip->source == ClipSource::STREAM) {
+            return clip;
+        }
+    }
+    return nullptr;
+}
+
+void AudioManager::popClip() {
+    if (playbackQueueCount == 0) {
+        return;
+    }
+    
+    playbackQueueHead = (playbackQueueHead + 1) % AUDIO_PLAYBACK_QUEUE_SIZE;
+    playbackQueueCount--;
+    
+    // Prefetch-Puffer ist frei, sobald der URL-Clip abgespielt ist
+    startPrefetch();
+}
+
+size_t AudioManager::renderPlayback(uint8_t* out, size_t maxBytes, PlaybackMark* marks, size_t* markCount) {
+    size_t filled = 0;
+    *markCount = 0;
+    
+    // Übergänge werden im Zeitstrahl des Playing-Tasks vermerkt
+    uint64_t blockStart = playbackWrittenSamples;
+    
+    while (filled < maxBytes && playbackQueueCount > 0) {
+        PlaybackClip* clip = clipAt(0);
+        PlaybackClip* next = playbackQueueCount > 1 ? clipAt(1) : nullptr;
+        
+        if (!clip->started) {
+            clip->started = true;
+            appendPlaybackMark(marks, markCount, clip->clipId, blockStart + filled / sizeof(int16_t), false);
+        }
+        
+        size_t space = maxBytes - filled;
+        size_t fadeBytes = next ? crossfadeBytes(*next) : 0;
+        size_t remaining = clipRemaining(*clip);
+        
+        if (fadeBytes > 0 && remaining != CLIP_REMAINING_UNKNOWN) {
+            if (remaining > fadeBytes) {
+                // Nur bis zum Beginn der Überblendung lesen
+                space = min(space, remaining - fadeBytes);
+            } else if (remaining > space) {
+                // Überblendung im nächsten Block vollständig ausführen
+                break;
+            } else if (clipReadable(*clip) >= remaining) {
+                // Ausklang des Clips mit dem Anfang des nächsten mischen
+                size_t n = readClip(*clip, out + filled, remaining);
+                if (n > 0 && clipReadable(*next) >= n) {
+                    uint8_t fadeIn[MAX_CROSSFADE_BYTES];
+                    readClip(*next, fadeIn, n);
+                    size_t samples = n / 2;
+                    for (size_t i = 0; i < samples; i++) {
+                        uint8_t* p = out + filled + i * 2;
+                        int32_t a = (int16_t)(p[0] | (p[1] << 8));
+                        int32_t b = (int16_t)(fadeIn[i * 2] | (fadeIn[i * 2 + 1] << 8));
+                        int32_t mixed = (a * (int32_t)(samples - i) + b * (int32_t)i) / (int32_t)samples;
+                        p[0] = mixed & 0xFF;
+                        p[1] = (mixed >> 8) & 0xFF;
+                    }
+                    if (!next->started) {
+                        appendPlaybackMark(marks, markCount, next->clipId, blockStart + filled / sizeof(int16_t), false);
+                    }
+                    next->started = true;
+                }
+                filled += n;
+            }
+        }
+        
+        if (isClipFinished(*clip)) {
+            appendPlaybackMark(marks, markCount, clip->clipId, blockStart + filled / sizeof(int16_t), true);
+            popClip();
+            continue;
+        }
+        
+        size_t n = readClip(*clip, out + filled, space);
+        filled += n;
+        
+        if (isClipFinished(*clip)) {
+            appendPlaybackMark(marks, markCount, clip->clipId, blockStart + filled / sizeof(int16_t), true);
+            popClip();
+            continue;
+        }
+        
+        // Clip wartet auf Daten (Stream oder Download)
+        if (n == 0) {
+            break;
+        }
+    }
+    
+    return filled;
+}
+
+size_t AudioManager::readClip(PlaybackClip& clip, uint8_t* out, size_t maxBytes) {
+    size_t n = 0;
+    
+    switch (clip.source) {
+        case ClipSource::STREAM: {
+            // Nicht zugeordnete Bytes vor dem Clip-Anfang verwerfen
+            while (downlinkConsumedBytes < clip.streamStart && !speakerBuffer.isEmpty) {
+                downlinkConsumedBytes += readFromRingBuffer(speakerBuffer, out,
+                                             min(maxBytes, (size_t)(clip.streamStart - downlinkConsumedBytes)));
+            }
+            size_t limit = min(maxBytes, clipReadable(clip));
+            n = readFromRingBuffer(speakerBuffer, out, limit);
+            downlinkConsumedBytes += n;
+            break;
+        }
+        case ClipSource::FLASH:
+            n = min(maxBytes, clip.length - clip.position);
+            memcpy(out, clip.data + clip.position, n);
+            clip.position += n;
+            break;
+        case ClipSource::URL:
+            if (clip.clipId == prefetchClipId) {
+                n = readFromRingBuffer(prefetchBuffer, out, maxBytes);
+                clip.position += n;
+            }
+            break;
+    }
+    
+    return n;
+}
+
+size_t AudioManager::clipReadable(const PlaybackClip& clip) const {
+    switch (clip.source) {
+        case ClipSource::STREAM: {
+            if (downlinkConsumedBytes < clip.streamStart) {
+                return 0;
+            }
+            size_t readable = speakerBuffer.available;
+            if (clip.endKnown) {
+                readable = min(readable, (size_t)(clip.streamEnd - downlinkConsumedBytes));
+            }
+            return readable;
+        }
+        case ClipSource::FLASH:
+            return clip.length - clip.position;
+        case ClipSource::URL:
+            return clip.clipId == prefetchClipId ? prefetchBuffer.available : 0;
+    }
+    return 0;
+}
+
+size_t AudioManager::clipRemaining(const PlaybackClip& clip) const {
+    switch (clip.source) {
+        case ClipSource::STREAM:
+            if (!clip.endKnown) {
+                return CLIP_REMAINING_UNKNOWN;
+            }
+            return clip.streamEnd > downlinkConsumedBytes ? clip.streamEnd - downlinkConsumedBytes : 0;
+        case ClipSource::FLASH:
+            return clip.length - clip.position;
+        case ClipSource::URL:
+            return clip.endKnown ? clip.length - clip.position : CLIP_REMAINING_UNKNOWN;
+    }
+    return 0;
+}
+
+bool AudioManager::isClipFinished(const PlaybackClip& clip) const {
+    // Impliziter Clip endet, sobald der Puffer leer ist
+    if (clip.source == ClipSource::STREAM && clip.clipId == 0 && !clip.endKnown) {
+        return downlinkConsumedBytes >= downlinkReceivedBytes;
+    }
+    return clipRemaining(clip) == 0;
+}
+
+size_t AudioManager::crossfadeBytes(const PlaybackClip& next) const {
+    uint16_t ms = min(next.crossfadeMs, (uint16_t)AUDIO_MAX_CROSSFADE_MS);
+    return ms * (I2S_SAMPLE_RATE / 1000) * sizeof(int16_t);
+}
+
+void AudioManager::notifyClipEvent(const char* event, uint32_t clipId, uint64_t sampleIndex, int64_t timestampUs) {
+    if (audioEventCallback) {
+        EventField fields[] = {
+            { ControlTag::CLIP_ID, (int64_t)clipId },
+            { ControlTag::SAMPLE_INDEX, (int64_t)sampleIndex },
+            { ControlTag::TIMESTAMP, timestampUs },
+        };
+        audioEventCallback(event, fields, sizeof(fields) / sizeof(fields[0]));
+    }
+}
+
+// =============================================================================
+// WIEDERGABE-POSITION
+// =============================================================================
+
+PlaybackPosition AudioManager::getPlaybackPosition() const {
+    PlaybackPosition position;
+    position.writtenSamples = playbackWrittenSamples;
+    position.playedSamples = playbackPlayedSamples;
+    position.clipId = audibleClipId;
+    position.clipSample = position.playedSamples > audibleClipStart ? position.playedSamples - audibleClipStart : 0;
+    position.active = contentPending;
+    return position;
+}
+
+void AudioManager::resetPlaybackPosition() {
+    playbackWrittenSamples = 0;
+    playbackPlayedSamples = 0;
+    lastTxDoneUs = esp_timer_get_time();
+    contentEndSample = 0;
+    contentPending = false;
+    audibleClipId = 0;
+    audibleClipStart = 0;
+    pendingMarkHead = 0;
+    pendingMarkCount = 0;
+}
+
+void AudioManager::updatePlaybackPosition() {
+    if (!speakerEventQueue) {
+        return;
+    }
+    
+    // Jedes TX_DONE entspricht einem ausgegebenen DMA-Puffer. Bei leerer DMA
+    // sendet der Treiber Nullen (tx_desc_auto_clear), daher Begrenzung auf
+    // die geschriebenen Samples.
+    i2s_event_t event;
+    while (xQueueReceive(speakerEventQueue, &event, 0) == pdTRUE) {
+        if (event.type == I2S_EVENT_TX_DONE) {
+            uint64_t played = playbackPlayedSamples + speakerDmaFrames;
+            
+            // DMA leer gelaufen, obwohl Daten bereitlagen: Task war zu spät
+            if (played > playbackWrittenSamples && contentPending && !speakerBuffer.isEmpty) {
+                speakerLatency.recordDropout();
+            }
+            playbackPlayedSamples = min(played, (uint64_t)playbackWrittenSamples);
+            lastTxDoneUs = esp_timer_get_time();
+        }
+    }
+}
+
+void AudioManager::pushPlaybackMark(const PlaybackMark& mark) {
+    if (pendingMarkCount >= AUDIO_PLAYBACK_MARK_QUEUE_SIZE) {
+        // Älteste Marke sofort melden statt sie zu verlieren
+        Serial.println("AudioManager: Marken-Queue voll");
+        PlaybackMark& oldest = pendingMarks[pendingMarkHead];
+        notifyClipEvent(oldest.finished ? EVENT_CLIP_FINISHED : EVENT_CLIP_STARTED,
+                        oldest.clipId, oldest.sampleIndex, esp_timer_get_time());
+        pendingMarkHead = (pendingMarkHead + 1) % AUDIO_PLAYBACK_MARK_QUEUE_SIZE;
+        pendingMarkCount--;
+    }
+    
+    pendingMarks[(pendingMarkHead + pendingMarkCount) % AUDIO_PLAYBACK_MARK_QUEUE_SIZE] = mark;
+    pendingMarkCount++;
+}
+
+void AudioManager::emitDueMarks() {
+    while (pendingMarkCount > 0) {
+        PlaybackMark& mark = pendingMarks[pendingMarkHead];
+        if (mark.sampleIndex > playbackPlayedSamples) {
+            break;
+        }
+        
+        if (!mark.finished) {
+            audibleClipId = mark.clipId;
+            audibleClipStart = mark.sampleIndex;
+        }
+        notifyClipEvent(mark.finished ? EVENT_CLIP_FINISHED : EVENT_CLIP_STARTED,
+                        mark.clipId, mark.sampleIndex, playedTimestampUs(mark.sampleIndex));
+        
+        pendingMarkHead = (pendingMarkHead + 1) % AUDIO_PLAYBACK_MARK_QUEUE_SIZE;
+        pendingMarkCount--;
+    }
+}
+
+// =============================================================================
+// LATENZ-REGLER
+// =============================================================================
+
+LatencyStats AudioManager::getSpeakerLatencyStats() const {
+    return speakerLatency.getStats();
+}
+
+LatencyStats AudioManager::getMicLatencyStats() const {
+    return micLatency.getStats();
+}
+
+void AudioManager::applyLatencyConfig() {
+    if (xSemaphoreTake(audioMutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+        return;
+    }
+    
+    uint32_t blockUs = (uint32_t)((I2S_BUFFER_SIZE / sizeof(int16_t)) * 1000000ULL / I2S_SAMPLE_RATE);
+    bool speakerChanged = speakerLatency.update(blockUs);
+    bool micChanged = micLatency.update(blockUs);
+    
+    // Lautsprecher übernimmt die Geometrie beim nächsten startSpeaker(),
+    // das Mikrofon nur ohne laufende Aufnahme (always_on: beim nächsten Stopp)
+    DmaGeometry mic = micLatency.getGeometry();
+    bool micPending = mic.bufCount != micGeometry.bufCount || mic.bufLen != micGeometry.bufLen;
+    if (micPending && recordingTaskHandle == nullptr) {
+        i2s_driver_uninstall(micI2SPort);
+        if (!initI2SMicrophone()) {
+            Serial.println("AudioManager: Mikrofon nach Geometrie-Wechsel nicht verfügbar");
+        }
+    }
+    
+    xSemaphoreGive(audioMutex);
+    
+    if (speakerChanged) {
+        reportLatencyConfig("speaker", speakerLatency);
+    }
+    if (micChanged) {
+        reportLatencyConfig("mic", micLatency);
+    }
+}
+
+void AudioManager::reportLatencyConfig(const char* target, const LatencyController& controller) {
+    LatencyStats stats = controller.getStats();
+    Serial.printf("AudioManager: DMA %s -> %u x %u (%u ms, Jitter %u µs, Aussetzer %u)\n",
+                  target, (unsigned)stats.geometry.bufCount, (unsigned)stats.geometry.bufLen,
+                  (unsigned)stats.bufferMs, (unsigned)stats.peakJitterUs, (unsigned)stats.dropouts);
+    
+    if (audioEventCallback) {
+        EventField fields[] = {
+            { ControlTag::TARGET, target },
+            { ControlTag::DMA_BUF_COUNT, (int64_t)stats.geometry.bufCount },
+            { ControlTag::DMA_BUF_LEN, (int64_t)stats.geometry.bufLen },
+            { ControlTag::BUFFER_MS, (int64_t)stats.bufferMs },
+            { ControlTag::JITTER_US, (int64_t)stats.peakJitterUs },
+            { ControlTag::DROPOUTS, (int64_t)stats.dropouts },
+        };
+        audioEventCallback(EVENT_LATENCY_CONFIG, fields, sizeof(fields) / sizeof(fields[0]));
+    }
+}
+
+// =============================================================================
+// BARGE-IN
+// =============================================================================
+
+bool AudioManager::isPlaybackActive() const {
+    return m_speakerState == SpeakerState::ACTIVE && (contentPending || playbackQueueCount > 0);
+}
+
+bool AudioManager::bargeIn(PlaybackPosition* position) {
+    if (!isPlaybackActive()) {
+        return false;
+    }
+    
+    if (xSemaphoreTake(audioMutex, pdMS_TO_TICKS(10)) != pdTRUE) {
+        Serial.println("AudioManager: Barge-in ohne Mutex nicht möglich");
         return false;
     }
     
-    updateRingBuffer(speakerBuffer, data, size);
+    // Position vor dem Abbruch (auf einen DMA-Puffer genau)
+    if (position) {
+        *position = getPlaybackPosition();
+    }
+    
+    // Queue, Prefetch und Downlink-Puffer verwerfen
+    playbackQueueHead = 0;
+    playbackQueueCount = 0;
+    prefetchClipId = 0;
+    resetRingBuffer(prefetchBuffer);
+    discardSpeakerBuffer();
+    
+    bargeInHoldoff = true;
+    bargeInTime = millis();
+    bargeInRequestUs = esp_timer_get_time();
+    bargeInPending = true;
+    
     xSemaphoreGive(audioMutex);
     
+    // Aufrufer startet direkt danach die Aufnahme, DMA leert der Playing-Task
     return true;
 }
 
+void AudioManager::handleBargeIn() {
+    // i2s_zero_dma_buffer wartet auf ein laufendes i2s_write, daher hier im
+    // Playing-Task: Stille spätestens nach einem DMA-Puffer
+    i2s_zero_dma_buffer(speakerI2SPort);
+    
+    // Verworfene Samples gelten als ausgegeben, ausstehende Marken entfallen
+    playbackPlayedSamples = playbackWrittenSamples;
+    lastTxDoneUs = esp_timer_get_time();
+    contentEndSample = playbackWrittenSamples;
+    contentPending = false;
+    pendingMarkHead = 0;
+    pendingMarkCount = 0;
+    bargeInPending = false;
+    
+    Serial.printf("AudioManager: Barge-in, Ausgabe nach %lld µs stumm\n",
+                  (long long)(lastTxDoneUs - bargeInRequestUs));
+}
+
+int64_t AudioManager::playedTimestampUs(uint64_t sampleIndex) const {
+    // Zurückrechnen vom letzten TX_DONE (Genauigkeit: ein DMA-Puffer)
+    uint64_t played = playbackPlayedSamples;
+    uint64_t behind = played > sampleIndex ? played - sampleIndex : 0;
+    return lastTxDoneUs - (int64_t)(behind * 1000000ULL / I2S_SAMPLE_RATE);
+}
+
+void AudioManager::startPrefetch() {
+    if (prefetchActive || !prefetchBufferData) {
+        return;
+    }
+    
+    // Nur der erste URL-Clip der Queue wird geladen (ein gemeinsamer Puffer)
+    for (size_t i = 0; i < playbackQueueCount; i++) {
+        PlaybackClip* clip = clipAt(i);
+        if (clip->source != ClipSource::URL) {
+            continue;
+        }
+        if (clip->clipId == prefetchClipId || clip->endKnown) {
+            return;
+        }
+        
+        resetRingBuffer(prefetchBuffer);
+        prefetchClipId = clip->clipId;
+        strncpy(prefetchUrl, clip->url, AUDIO_CLIP_URL_MAX - 1);
+        prefetchUrl[AUDIO_CLIP_URL_MAX - 1] = '\0';
+        prefetchActive = true;
+        
+        BaseType_t result = xTaskCreate(
+            prefetchTask,
+            "AudioPrefetchTask",
+            PREFETCH_TASK_STACK_SIZE,
+            this,
+            PREFETCH_TASK_PRIORITY,
+            &prefetchTaskHandle
+        );
+        if (result != pdPASS) {
+            // Clip überspringen statt die Queue zu blockieren
+            Serial.println("AudioManager: Fehler beim Erstellen der Prefetch-Task");
+            prefetchActive = false;
+            clip->length = 0;
+            clip->endKnown = true;
+        }
+        return;
+    }
+}
+
+void AudioManager::prefetchTask(void* parameter) {
+    AudioManager* manager = static_cast<AudioManager*>(parameter);
+    
+    uint32_t clipId = manager->prefetchClipId;
+    String url = manager->prefetchUrl;
+    size_t total = 0;
+    
+    Serial.printf("AudioManager: Lade Clip %u von %s\n", (unsigned)clipId, url.c_str());
+    
+    HTTPClient http;
+    if (http.begin(url)) {
+        int httpCode = http.GET();
+        if (httpCode == HTTP_CODE_OK) {
+            WiFiClient* stream = http.getStreamPtr();
+            int contentLength = http.getSize();     // -1 bei chunked/unbekannt
+            int received = 0;
+            size_t headerSkip = 0;
+            bool headerChecked = false;
+            uint8_t chunk[512];
+            unsigned long lastProgress = millis();
+            
+            while (manager->prefetchClipId == clipId &&
+                   (contentLength < 0 || received < contentLength) &&
+                   (http.connected() || stream->available())) {
+                size_t available = stream->available();
+                if (available == 0) {
+                    if (millis() - lastProgress > AUDIO_PLAYBACK_STALL_TIMEOUT_MS) {
+                        Serial.println("AudioManager: Prefetch-Timeout");
+                        break;
+                    }
+                    vTaskDelay(pdMS_TO_TICKS(5));
+                    continue;
+                }
+                
+                int bytesRead = stream->read(chunk, min(available, sizeof(chunk)));
+                if (bytesRead <= 0) {
+                    continue;
+                }
+                size_t n = (size_t)bytesRead;
+                received += bytesRead;
+                lastProgress = millis();
+                
+                // WAV-Kopf überspringen (PCM 16 kHz/16 bit mono vorausgesetzt)
+                size_t offset = 0;
+                if (!headerChecked) {
+                    headerChecked = true;
+                    if (n >= 4 && memcmp(chunk, "RIFF", 4) == 0) {
+                        headerSkip = 44;
+                    }
+                }
+                if (headerSkip > 0) {
+                    offset = min(headerSkip, n);
+                    headerSkip -= offset;
+                }
+                
+                // Bei vollem Puffer warten, bis die Wiedergabe Platz schafft
+                while (offset < n && manager->prefetchClipId == clipId) {
+                    size_t written = 0;
+                    if (xSemaphoreTake(manager->audioMutex, pdMS_TO_TICKS(10)) == pdTRUE) {
+                        if (manager->prefetchClipId == clipId) {
+                            written = manager->updateRingBuffer(manager->prefetchBuffer, chunk + offset, n - offset);
+                        }
+                        xSemaphoreGive(manager->audioMutex);
+                    }
+                    offset += written;
+                    total += written;
+                    if (offset < n) {
+                        vTaskDelay(pdMS_TO_TICKS(10));
+                    }
+                }
+            }
+        } else {
+            Serial.printf("AudioManager: Prefetch HTTP-Fehler %d\n", httpCode);
+        }
+        http.end();
+    }
+    
+    // Clip-Länge festlegen; bei Fehlern endet der Clip nach den geladenen Daten
+    xSemaphoreTake(manager->audioMutex, portMAX_DELAY);
+    for (size_t i = 0; i < manager->playbackQueueCount; i++) {
+        PlaybackClip* clip = manager->clipAt(i);
+        if (clip->source == ClipSource::URL && clip->clipId == clipId) {
+            clip->length = total & ~(size_t)1;
+            clip->endKnown = true;
+            break;
+        }
+    }
+    manager->prefetchActive = false;
+    manager->prefetchTaskHandle = nullptr;
+    
+    // Abgebrochener Download: nächsten URL-Clip sofort laden
+    manager->startPrefetch();
+    xSemaphoreGive(manager->audioMutex);
+    
+    Serial.printf("AudioManager: Clip %u geladen (%u Bytes)\n", (unsigned)clipId, (unsigned)total);
+    vTaskDelete(nullptr);
+}
+
 bool AudioManager::playTestTone() {
-    return playTestTone(100.0f);
+    if (m_speakerState == SpeakerState::ACTIVE) {
+        return false;   // Port gehört der laufenden Wiedergabe
+    }
+    playTestTone(100.0f);
+    return true;
 }
 
 void AudioManager::playTestTone(float volumePercentage) {
@@ -882,8 +2315,12 @@ void AudioManager::playTestTone(float volumePercentage) {
     float originalVolume = m_volume_gain;
     m_volume_gain = volumeGain;
     
-    // I2S-Treiber für Lautsprecher initialisieren
-    installI2SDriver(MODE_SPK);
+    // I2S-Treiber für Lautsprecher initialisieren (nicht während der Wiedergabe)
+    if (m_speakerState == SpeakerState::ACTIVE || !initI2SSpeaker()) {
+        Serial.println("AudioManager: Lautsprecher belegt, kein Test-Ton");
+        m_volume_gain = originalVolume;
+        return;
+    }
     enableAmplifier();
     
     // Test-Ton-Parameter
@@ -901,7 +2338,8 @@ void AudioManager::playTestTone(float volumePercentage) {
     if (!buffer) {
         Serial.println("AudioManager: Fehler beim Allozieren des Test-Ton-Buffers");
         m_volume_gain = originalVolume; // Ursprüngliche Lautstärke wiederherstellen
-        uninstallI2SDriver();
+        i2s_driver_uninstall(speakerI2SPort);
+        speakerEventQueue = nullptr;
         disableAmplifier();
         return;
     }
@@ -926,7 +2364,7 @@ void AudioManager::playTestTone(float volumePercentage) {
         
         // Buffer an I2S senden
         size_t bytesWritten = 0;
-        esp_err_t result = i2s_write(SPEAKER_I2S_NUMBER, buffer, 
+        esp_err_t result = i2s_write(speakerI2SPort, buffer, 
                                    samplesToGenerate * sizeof(int16_t), 
                                    &bytesWritten, pdMS_TO_TICKS(100));
         
@@ -945,7 +2383,8 @@ void AudioManager::playTestTone(float volumePercentage) {
     vTaskDelay(pdMS_TO_TICKS(100));
     
     // I2S-Treiber deinstallieren und Verstärker ausschalten
-    uninstallI2SDriver();
+    i2s_driver_uninstall(speakerI2SPort);
+    speakerEventQueue = nullptr;    // Gehört dem Treiber
     disableAmplifier();
     
     // Ursprüngliche Lautstärke wiederherstellen
@@ -8,6 +8,9 @@
 #include <freertos/queue.h>
 #include <freertos/semphr.h>
 #include "config.h"
+#include "AudioCodec.h"
+#include "LatencyController.h"
+#include "ControlProtocol.h"
 
 // Forward-Deklaration
 class EventManager;
@@ -32,6 +35,114 @@ struct AudioRingBuffer {
     bool isEmpty;
 };
 
+// Komprimierter Pre-Roll-Puffer (Ring aus unabhängig dekodierbaren ADPCM-Blöcken)
+struct PreRollBuffer {
+    uint8_t* blocks;
+    size_t blockCount;          // Kapazität in Blöcken
+    size_t readBlock;
+    size_t writeBlock;
+    size_t usedBlocks;
+    AdpcmState encoderState;
+    int16_t pending[AUDIO_PREROLL_BLOCK_SAMPLES];  // Noch nicht kodierter Rest
+    size_t pendingCount;
+    uint32_t droppedBlocks;     // Überschriebene (älteste) Blöcke
+    uint32_t lockTimeouts;      // Live-Blöcke verloren, Pre-Roll war belegt
+};
+
+// Pre-Roll-Statistik für Diagnose
+struct PreRollStats {
+    size_t usedBytes;
+    size_t capacityBytes;
+    uint32_t bufferedMs;
+    uint32_t capacityMs;
+    uint32_t droppedBlocks;
+    uint32_t lockTimeouts;
+};
+
+// Stream-Marke: erstes bzw. letztes gesendetes Sample mit Aufnahmezeitpunkt
+struct StreamMark {
+    uint64_t sampleIndex;           // Sample-Index seit Aufnahmestart
+    int64_t captureTimestampUs;     // esp_timer-Zeit der Aufnahme dieses Samples
+};
+
+// Endpointing-Zustand (Energie + VAD + Nachlauf-Stille-Modell)
+struct EndpointDetector {
+    bool enabled;
+    float noiseFloor;           // Adaptiver Grundpegel (mittlerer Betrag)
+    bool noiseFloorValid;
+    uint32_t speechMs;          // Sprachdauer der aktuellen Äußerung
+    uint32_t silenceMs;         // Stille seit dem letzten Sprach-Frame
+    bool endSignalled;          // utterance_end für diese Äußerung gesendet
+    uint64_t speechStartSample;
+    uint64_t lastSpeechSample;
+};
+
+// Credit-Stand des Downlinks (kumulative Byte-Zähler seit Wiedergabestart)
+struct DownlinkCredit {
+    uint32_t receivedBytes;     // Angenommene Bytes
+    uint32_t consumedBytes;     // An I2S übergebene Bytes
+    uint32_t creditLimit;       // Server darf bis zu diesem kumulativen Stand senden
+    uint32_t droppedBytes;      // Verworfen wegen vollem Puffer
+    size_t bufferedBytes;
+};
+
+// Reservierter Schreibbereich im Wiedergabe-Puffer. Wegen des Umlaufs bis zu
+// zwei Segmente; der Empfänger liest Nutzdaten direkt hinein (ohne Kopie).
+struct PlayoutReservation {
+    uint8_t* segment[2];
+    size_t length[2];
+    size_t total;
+    uint32_t generation;        // Ungültig, wenn der Puffer inzwischen geleert wurde
+};
+
+// Quelle eines Clips in der Wiedergabe-Queue
+enum class ClipSource {
+    STREAM,         // Binär-Frames vom Server (im Wiedergabe-Puffer)
+    FLASH,          // Im Flash abgelegter PCM-Clip (registerFlashClip)
+    URL             // Per HTTP vorab geladener PCM/WAV-Clip
+};
+
+// Eintrag der Wiedergabe-Queue. Stream-Clips werden über kumulative
+// Downlink-Byte-Offsets abgegrenzt, dadurch sind Übergänge sample-genau.
+// clipId 0 kennzeichnet Downlink-Audio ohne queue_clip (keine Ereignisse).
+struct PlaybackClip {
+    uint32_t clipId;
+    ClipSource source;
+    uint16_t crossfadeMs;           // Überblendung in diesen Clip
+    const uint8_t* data;            // FLASH
+    size_t length;                  // FLASH/URL: Länge in Bytes (URL: sobald bekannt)
+    char url[AUDIO_CLIP_URL_MAX];   // URL
+    uint32_t streamStart;           // STREAM: erster Downlink-Offset
+    uint32_t streamEnd;             // STREAM: Ende (exklusiv), wenn endKnown
+    bool endKnown;                  // STREAM: Ende bekannt, URL: Download abgeschlossen
+    size_t position;                // FLASH/URL: abgespielte Bytes
+    bool started;
+};
+
+// Clip-Marke im Wiedergabe-Zeitstrahl (Sample-Index seit Lautsprecherstart).
+// Wird gemeldet, sobald die DMA das Sample tatsächlich ausgegeben hat.
+struct PlaybackMark {
+    uint64_t sampleIndex;
+    uint32_t clipId;
+    bool finished;                  // false: Clip beginnt, true: Clip endet
+};
+
+// Aktuelle Wiedergabe-Position
+struct PlaybackPosition {
+    uint64_t writtenSamples;        // An i2s_write übergeben (inkl. Stille)
+    uint64_t playedSamples;         // Von der DMA ausgegeben
+    uint32_t clipId;                // Zuletzt hörbar begonnener Clip
+    uint64_t clipSample;            // Position innerhalb dieses Clips
+    bool active;                    // Inhalt noch nicht vollständig ausgegeben
+};
+
+// Registrierter Flash-Clip (z.B. Earcons)
+struct FlashClip {
+    char name[AUDIO_CLIP_NAME_MAX];
+    const uint8_t* data;
+    size_t length;
+};
+
 // Audio-Chunk für Streaming
 struct AudioChunk {
     uint8_t* data;
@@ -40,6 +151,13 @@ struct AudioChunk {
     bool isSilence;
 };
 
+// Senke für aufgenommenes Audio (z.B. WebSocketClient::sendAudio).
+// Rückgabe false: Senke nicht bereit, die Daten wandern in den Pre-Roll-Puffer
+typedef bool (*AudioSinkCallback)(const uint8_t* data, size_t length);
+
+// Audio-Ereignisse an den Server ('fields' ist ein JSON-Fragment "key":value,...)
+typedef void (*AudioEventCallback)(const char* event, const EventField* fields, size_t count);
+
 class AudioManager {
 private:
     // I2S-Konfiguration
@@ -52,10 +170,71 @@ private:
     uint8_t* micBufferData;
     uint8_t* speakerBufferData;
     
+    // Pre-Roll-Puffer für Audio vor dem Verbindungsaufbau
+    PreRollBuffer preRoll;
+    AudioSinkCallback audioSink;
+    
+    // Stream-Gate: laufende Aufnahme wird verworfen ("armed") oder gesendet
+    volatile bool streamOpen;
+    uint64_t streamStartSample;
+    uint64_t capturedSamples;
+    int64_t lastBlockEndUs;
+    portMUX_TYPE captureMux;
+    
+    // Downlink-Zähler für Credit-Flusskontrolle
+    volatile uint32_t downlinkReceivedBytes;
+    volatile uint32_t downlinkConsumedBytes;
+    volatile uint32_t downlinkDroppedBytes;
+    uint32_t speakerGeneration;         // Erhöht bei jedem Leeren des Wiedergabe-Puffers
+    
+    // Wiedergabe-Queue (Ring, geschützt durch audioMutex)
+    PlaybackClip playbackQueue[AUDIO_PLAYBACK_QUEUE_SIZE];
+    size_t playbackQueueHead;
+    size_t playbackQueueCount;
+    FlashClip flashClips[AUDIO_FLASH_CLIP_MAX];
+    size_t flashClipCount;
+    
+    // URL-Prefetch
+    AudioRingBuffer prefetchBuffer;
+    uint8_t* prefetchBufferData;
+    TaskHandle_t prefetchTaskHandle;
+    uint32_t prefetchClipId;        // Clip, dessen Daten im Prefetch-Puffer liegen
+    volatile bool prefetchActive;
+    char prefetchUrl[AUDIO_CLIP_URL_MAX];
+    
+    // Wiedergabe-Position (nur vom Playing-Task geschrieben)
+    QueueHandle_t speakerEventQueue;
+    size_t speakerDmaFrames;            // Samples pro DMA-Puffer
+    volatile uint64_t playbackWrittenSamples;
+    volatile uint64_t playbackPlayedSamples;
+    int64_t lastTxDoneUs;
+    uint64_t contentEndSample;          // Ende des zuletzt geschriebenen Inhalts
+    volatile bool contentPending;       // playback_done steht noch aus
+    uint32_t audibleClipId;
+    uint64_t audibleClipStart;
+    PlaybackMark pendingMarks[AUDIO_PLAYBACK_MARK_QUEUE_SIZE];
+    size_t pendingMarkHead;
+    size_t pendingMarkCount;
+    
+    // Latenz-Regler für die DMA-Geometrie beider I2S-Treiber
+    LatencyController speakerLatency;
+    LatencyController micLatency;
+    DmaGeometry micGeometry;            // Aktuell installiert
+    
+    // Barge-in: Playing-Task leert die DMA, verspätete Downlink-Frames werden verworfen
+    volatile bool bargeInPending;
+    bool bargeInHoldoff;
+    unsigned long bargeInTime;
+    int64_t bargeInRequestUs;
+    
+    // Endpointing und Ereignis-Callback
+    EndpointDetector endpoint;
+    AudioEventCallback audioEventCallback;
+    
     // Zustandsverwaltung
-    AudioState currentState;
-    bool micEnabled;
-    bool speakerEnabled;
+    AudioState currentState;        // Zuletzt gestarteter Vorgang, nur zur Anzeige (getState)
+    bool micEnabled;                // Aufnahme läuft; maßgeblich für isRecording()
+    bool speakerEnabled;            // Wiedergabe läuft; maßgeblich für isPlaying()
     
     // Lautsprecher-Zustandsverwaltung
     enum class SpeakerState { INACTIVE, ACTIVE };
@@ -76,6 +255,8 @@ private:
     QueueHandle_t recordingQueue;
     QueueHandle_t playingQueue;
     SemaphoreHandle_t audioMutex;
+    SemaphoreHandle_t preRollMutex;     // Pre-Roll: Recording-Task und Nachschub der Netzwerk-Task
+    SemaphoreHandle_t recordingExited;  // Gibt die Recording-Task unmittelbar vor ihrem Ende
     
     // Private Methoden
     bool initI2SMicrophone();
@@ -83,10 +264,58 @@ private:
     void processMicrophone();
     void processSpeaker();
     bool detectSilence(const uint8_t* data, size_t length);
-    void updateRingBuffer(AudioRingBuffer& buffer, const uint8_t* data, size_t length);
+    size_t updateRingBuffer(AudioRingBuffer& buffer, const uint8_t* data, size_t length);
     size_t readFromRingBuffer(AudioRingBuffer& buffer, uint8_t* data, size_t maxLength);
     void resetRingBuffer(AudioRingBuffer& buffer);
     
+    // Pre-Roll-Verarbeitung
+    void deliverCapturedAudio(const uint8_t* data, size_t length);
+    void writeToPreRoll(const int16_t* samples, size_t count);
+    void encodePreRollBlock(const int16_t* samples);
+    bool flushPreRoll();
+    void resetPreRoll();
+    int64_t sampleTimestampUs(uint64_t sampleIndex) const;
+    
+    // Endpointing
+    void processEndpointing(const int16_t* samples, size_t count, uint64_t blockStartSample);
+    void resetEndpointing();
+    
+    // Recording-Task: auf ihr Ende warten, false wenn sie nach AUDIO_RECORDING_EXIT_MS noch lebt
+    bool waitRecordingTaskExit();
+    
+    // Downlink
+    bool queueDownlinkAudio(const uint8_t* data, size_t length);
+    bool admitDownlink(size_t length);
+    void attributeDownlink(size_t written);
+    void discardSpeakerBuffer();
+    
+    // Wiedergabe-Queue (Aufruf mit gehaltenem audioMutex)
+    bool enqueueClip(const PlaybackClip& clip);
+    PlaybackClip* lastStreamClip();
+    PlaybackClip* clipAt(size_t index);
+    void popClip();
+    size_t renderPlayback(uint8_t* out, size_t maxBytes, PlaybackMark* marks, size_t* markCount);
+    size_t readClip(PlaybackClip& clip, uint8_t* out, size_t maxBytes);
+    size_t clipReadable(const PlaybackClip& clip) const;
+    size_t clipRemaining(const PlaybackClip& clip) const;
+    bool isClipFinished(const PlaybackClip& clip) const;
+    size_t crossfadeBytes(const PlaybackClip& next) const;
+    void startPrefetch();
+    void notifyClipEvent(const char* event, uint32_t clipId, uint64_t sampleIndex, int64_t timestampUs);
+    
+    // Wiedergabe-Position
+    void resetPlaybackPosition();
+    void updatePlaybackPosition();
+    void pushPlaybackMark(const PlaybackMark& mark);
+    void emitDueMarks();
+    int64_t playedTimestampUs(uint64_t sampleIndex) const;
+    void handleBargeIn();
+    
+    // Latenz-Regler
+    void applyLatencyConfig();
+    void reportLatencyConfig(const char* target, const LatencyController& controller);
+    static void prefetchTask(void* parameter);
+    
     // FreeRTOS-Task-Funktionen
     static void recordingTask(void* parameter);
     static void playingTask(void* parameter);
@@ -130,6 +359,47 @@ public:
     void clearSpeakerBuffer();
     size_t getMicBufferAvailable() const;
     size_t getSpeakerBufferAvailable() const;
+    DownlinkCredit getDownlinkCredit() const;
+    
+    // Direkter Downlink-Empfang (nur ein Schreiber): reservieren, Socket
+    // liest in die Segmente, commit übernimmt die tatsächlich gelesenen Bytes
+    bool reservePlayout(size_t maxBytes, PlayoutReservation& reservation);
+    bool commitPlayout(const PlayoutReservation& reservation, size_t bytesWritten);
+    
+    // Wiedergabe-Queue: lückenlose Clip-Folgen mit optionaler Überblendung
+    bool queueStreamClip(uint32_t clipId, uint16_t crossfadeMs, uint32_t lengthBytes);
+    bool endStreamClip(uint32_t clipId, uint32_t lengthBytes);
+    bool queueFlashClip(uint32_t clipId, const char* name, uint16_t crossfadeMs);
+    bool queueUrlClip(uint32_t clipId, const char* url, uint16_t crossfadeMs);
+    bool registerFlashClip(const char* name, const uint8_t* data, size_t length);
+    void clearPlaybackQueue();
+    size_t getQueuedClipCount() const;
+    PlaybackPosition getPlaybackPosition() const;
+    
+    // Barge-in: bricht laufende Wiedergabe sofort ab (false, wenn nichts spielt)
+    bool bargeIn(PlaybackPosition* position);
+    bool isPlaybackActive() const;
+    
+    // Vom Latenz-Regler gewählte DMA-Geometrie
+    LatencyStats getSpeakerLatencyStats() const;
+    LatencyStats getMicLatencyStats() const;
+    
+    // Pre-Roll & Streaming-Senke
+    void setAudioSink(AudioSinkCallback sink);
+    bool hasPreRollData() const;
+    bool flushPreRollBacklog();
+    PreRollStats getPreRollStats() const;
+    
+    // Server-gesteuertes Streaming (always_on): Aufnahme läuft, Gate schaltet
+    // zwischen Verwerfen und Senden um
+    StreamMark openStream();
+    StreamMark closeStream();
+    bool isStreamOpen() const;
+    
+    // Endpointing: meldet "utterance_end", Aufnahme läuft bis zum Loslassen weiter
+    void setEndpointingEnabled(bool enabled);
+    bool isEndpointingEnabled() const;
+    void setAudioEventCallback(AudioEventCallback callback);
     
     // Audio-Konfiguration
     void setSampleRate(uint32_t sampleRate);
@@ -0,0 +1,231 @@
+#include "AudioPacketizer.h"
+#include <esp_timer.h>
+
+// =============================================================================
+// KONSTRUKTOR & DESTRUKTOR
+// =============================================================================
+
+AudioPacketizer::AudioPacketizer() {
+    queue = nullptr;
+    opcode = 0;
+    buffer = nullptr;
+    pending = 0;
+    lastAppendUs = 0;
+    frameMs = WS_PACKETIZER_START_MS;
+    mutex = nullptr;
+    lastAdaptUs = 0;
+    windowPeakDepth = 0;
+    windowPayloadStart = 0;
+    windowOverheadStart = 0;
+    overheadPermille = 0;
+    increases = 0;
+    decreases = 0;
+    framesSent = 0;
+    payloadBytes = 0;
+    overheadBytes = 0;
+}
+
+AudioPacketizer::~AudioPacketizer() {
+    end();
+}
+
+bool AudioPacketizer::begin(TxQueue* target, uint8_t frameOpcode) {
+    if (!target || target->getSlotSize() < WS_PACKETIZER_MAX_BYTES) {
+        Serial.println("AudioPacketizer: Sende-Slots zu klein für die größte Frame-Dauer");
+        return false;
+    }
+    
+    buffer = (uint8_t*)malloc(WS_PACKETIZER_MAX_BYTES);
+    mutex = xSemaphoreCreateMutex();
+    if (!buffer || !mutex) {
+        Serial.println("AudioPacketizer: Fehler beim Allozieren des Frame-Puffers");
+        end();
+        return false;
+    }
+    
+    queue = target;
+    opcode = frameOpcode;
+    pending = 0;
+    frameMs = WS_PACKETIZER_START_MS;
+    lastAdaptUs = esp_timer_get_time();
+    return true;
+}
+
+void AudioPacketizer::end() {
+    if (buffer) {
+        free(buffer);
+        buffer = nullptr;
+    }
+    if (mutex) {
+        vSemaphoreDelete(mutex);
+        mutex = nullptr;
+    }
+    queue = nullptr;
+    pending = 0;
+}
+
+size_t AudioPacketizer::bytesForMs(uint32_t ms) {
+    return (size_t)ms * (I2S_SAMPLE_RATE / 1000) * (I2S_BITS_PER_SAMPLE / 8) * I2S_CHANNELS;
+}
+
+// =============================================================================
+// BÜNDELN
+// =============================================================================
+
+bool AudioPacketizer::append(const uint8_t* data, size_t length) {
+    if (!queue || xSemaphoreTake(mutex, pdMS_TO_TICKS(WS_TX_LOCK_TIMEOUT_MS)) != pdTRUE) {
+        return false;
+    }
+    
+    // Nach dem Verkleinern kann der angefangene Frame schon zu groß sein,
+    // er geht dann für sich allein
+    size_t frameBytes = bytesForMs(frameMs);
+    uint32_t frames = pending >= frameBytes ? 1 + length / frameBytes : (pending + length) / frameBytes;
+    
+    // Alles oder nichts: einzige Audio-Quelle, die Queue wird bis zum Einreihen
+    // nur leerer. Bei REJECT behält der Aufrufer sonst den ganzen Block.
+    if (queue->getPolicy() == TxPolicy::REJECT && frames > queue->getFreeSlots()) {
+        queue->recordRejected();
+        xSemaphoreGive(mutex);
+        return false;
+    }
+    
+    if (pending >= frameBytes) {
+        emitPending();
+    }
+    lastAppendUs = esp_timer_get_time();
+    
+    while (length > 0) {
+        // Ganze Frames direkt aus dem Block, ohne Umweg über den Puffer
+        if (pending == 0 && length >= frameBytes) {
+            queue->push(opcode, data, frameBytes);
+            data += frameBytes;
+            length -= frameBytes;
+            continue;
+        }
+    
+        size_t n = min(frameBytes - pending, length);
+        memcpy(buffer + pending, data, n);
+        pending += n;
+        data += n;
+        length -= n;
+        if (pending == frameBytes) {
+            emitPending();
+        }
+    }
+    
+    xSemaphoreGive(mutex);
+    return true;
+}
+
+void AudioPacketizer::emitPending() {
+    queue->push(opcode, buffer, pending);
+    pending = 0;
+}
+
+void AudioPacketizer::flush() {
+    if (!queue || xSemaphoreTake(mutex, pdMS_TO_TICKS(WS_TX_LOCK_TIMEOUT_MS)) != pdTRUE) {
+        return;
+    }
+    if (pending > 0) {
+        emitPending();
+    }
+    xSemaphoreGive(mutex);
+}
+
+void AudioPacketizer::flushIfIdle() {
+    // Ohne Nachschub (Stream gestoppt, Aufnahme beendet) nicht auf den Rest warten
+    if (pending > 0 && esp_timer_get_time() - lastAppendUs >= WS_PACKETIZER_FLUSH_MS * 1000LL) {
+        flush();
+    }
+}
+
+void AudioPacketizer::clear() {
+    if (!queue || xSemaphoreTake(mutex, pdMS_TO_TICKS(WS_TX_LOCK_TIMEOUT_MS)) != pdTRUE) {
+        return;
+    }
+    pending = 0;
+    xSemaphoreGive(mutex);
+}
+
+// =============================================================================
+// REGELUNG
+// =============================================================================
+
+bool AudioPacketizer::adapt() {
+    if (!queue || xSemaphoreTake(mutex, pdMS_TO_TICKS(WS_TX_LOCK_TIMEOUT_MS)) != pdTRUE) {
+        return false;
+    }
+    
+    uint32_t depth = queue->getDepth();
+    if (depth > windowPeakDepth) {
+        windowPeakDepth = depth;
+    }
+    
+    int64_t now = esp_timer_get_time();
+    if (now - lastAdaptUs < WS_PACKETIZER_ADAPT_MS * 1000LL) {
+        xSemaphoreGive(mutex);
+        return false;
+    }
+    lastAdaptUs = now;
+    
+    // Overhead des abgelaufenen Intervalls
+    uint32_t payload = payloadBytes - windowPayloadStart;
+    uint32_t overhead = overheadBytes - windowOverheadStart;
+    windowPayloadStart = payloadBytes;
+    windowOverheadStart = overheadBytes;
+    if (payload > 0) {
+        overheadPermille = (uint32_t)((uint64_t)overhead * 1000 / payload);
+    }
+    
+    uint32_t latencyMs = queue->getStats().avgLatencyUs / 1000;
+    uint32_t target = frameMs;
+    
+    if (windowPeakDepth >= WS_PACKETIZER_BACKLOG_FRAMES) {
+        // Rückstand: der Sender schafft die Frame-Rate nicht, größere Frames
+        // sparen Header und Writes je Sekunde Audio
+        target = min(frameMs * 2, (uint32_t)WS_PACKETIZER_MAX_MS);
+    } else if (frameMs + latencyMs > WS_PACKETIZER_BUDGET_MS) {
+        // Langsamer Link: große Bursts halten den Socket zu lange auf
+        target = max(frameMs / 2 / WS_PACKETIZER_STEP_MS * WS_PACKETIZER_STEP_MS, (uint32_t)WS_PACKETIZER_MIN_MS);
+    } else if (frameMs + WS_PACKETIZER_STEP_MS + latencyMs <= WS_PACKETIZER_BUDGET_MS) {
+        // Guter Link: schrittweise weniger Frames pro Sekunde
+        target = min(frameMs + WS_PACKETIZER_STEP_MS, (uint32_t)WS_PACKETIZER_MAX_MS);
+    }
+    windowPeakDepth = 0;
+    
+    bool changed = target != frameMs;
+    if (target > frameMs) {
+        increases++;
+    } else if (target < frameMs) {
+        decreases++;
+    }
+    frameMs = target;
+    
+    xSemaphoreGive(mutex);
+    return changed;
+}
+
+void AudioPacketizer::recordSent(size_t payload, size_t overhead) {
+    framesSent = framesSent + 1;
+    payloadBytes = payloadBytes + payload;
+    overheadBytes = overheadBytes + overhead;
+}
+
+// =============================================================================
+// STATUS
+// =============================================================================
+
+PacketizerStats AudioPacketizer::getStats() const {
+    PacketizerStats stats;
+    stats.frameMs = frameMs;
+    stats.frameBytes = bytesForMs(stats.frameMs);
+    stats.frames = framesSent;
+    stats.payloadBytes = payloadBytes;
+    stats.overheadBytes = overheadBytes;
+    stats.overheadPermille = overheadPermille;
+    stats.sendLatencyUs = queue ? queue->getStats().avgLatencyUs : 0;
+    stats.increases = increases;
+    stats.decreases = decreases;
+    return stats;
+}
@@ -0,0 +1,83 @@
+#ifndef AUDIO_PACKETIZER_H
+#define AUDIO_PACKETIZER_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "config.h"
+#include "TxQueue.h"
+
+// Gewählte Frame-Größe und gemessener Protokoll-Overhead
+struct PacketizerStats {
+    uint32_t frameMs;               // Aktuelle Frame-Dauer
+    uint32_t frameBytes;
+    uint32_t frames;                // Gesendete Frames
+    uint32_t payloadBytes;
+    uint32_t overheadBytes;         // Frame-Header, Maske, Kind-Byte, TLS-Record
+    uint32_t overheadPermille;      // Overhead je Nutzdaten im letzten Regelintervall
+    uint32_t sendLatencyUs;         // Einreihen bis Socket, Grundlage der Regelung
+    uint32_t increases;
+    uint32_t decreases;
+};
+
+// Bündelt Mikrofon-Audio zu Frames von WS_PACKETIZER_MIN_MS bis
+// WS_PACKETIZER_MAX_MS. Auf gutem Link werden die Frames größer (weniger
+// Header und Writes), übersteigt Frame-Dauer plus Sendelatenz das Budget,
+// werden sie kleiner. Staut sich die Queue, helfen nur größere Frames.
+class AudioPacketizer {
+private:
+    TxQueue* queue;
+    uint8_t opcode;
+    uint8_t* buffer;                // Angefangener Frame
+    size_t pending;
+    int64_t lastAppendUs;
+    volatile uint32_t frameMs;
+    SemaphoreHandle_t mutex;
+    
+    // Regelung (unter mutex)
+    int64_t lastAdaptUs;
+    uint32_t windowPeakDepth;
+    uint32_t windowPayloadStart;
+    uint32_t windowOverheadStart;
+    uint32_t overheadPermille;
+    uint32_t increases;
+    uint32_t decreases;
+    
+    // Nur vom Sender geschrieben
+    volatile uint32_t framesSent;
+    volatile uint32_t payloadBytes;
+    volatile uint32_t overheadBytes;
+    
+    static size_t bytesForMs(uint32_t ms);
+    void emitPending();
+
+public:
+    AudioPacketizer();
+    ~AudioPacketizer();
+    
+    // Frames gehen mit opcode in die Queue; ihre Slots müssen
+    // WS_PACKETIZER_MAX_BYTES fassen
+    bool begin(TxQueue* queue, uint8_t opcode);
+    void end();
+    
+    // Block übernehmen, volle Frames einreihen. false = nichts übernommen
+    // (REJECT-Queue hat nicht genug Platz), der Aufrufer behält den Block.
+    bool append(const uint8_t* data, size_t length);
+    
+    // Angefangenen Frame sofort bzw. nach WS_PACKETIZER_FLUSH_MS ohne Nachschub senden
+    void flush();
+    void flushIfIdle();
+    void clear();
+    bool hasPending() const { return pending > 0; }
+    
+    // Frame-Größe nachführen; true, wenn sie sich geändert hat
+    bool adapt();
+    
+    // Vom Sender nach jedem Audio-Frame
+    void recordSent(size_t payload, size_t overhead);
+    
+    uint32_t getFrameMs() const { return frameMs; }
+    PacketizerStats getStats() const;
+};
+
+#endif // AUDIO_PACKETIZER_H
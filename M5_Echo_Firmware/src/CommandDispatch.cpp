@@ -0,0 +1,203 @@
+#include "CommandRegistry.h"
+#include "WebSocketClient.h"
+#include "AudioManager.h"
+#include "LedManager.h"
+#include "PowerManager.h"
+#include "OtaManager.h"
+#include "WifiManager.h"
+#include <esp_timer.h>
+
+// Ausführung der Befehle an den Managern. Getrennt von Tabelle und Parsern
+// (CommandRegistry.cpp), damit diese ohne Manager im Host-Build laufen.
+
+// =============================================================================
+// DISPATCH
+// =============================================================================
+
+bool CommandRegistry::dispatch(ControlCommand command, const CommandArgs& args) {
+    int64_t startUs = esp_timer_get_time();
+    bool available = true;
+    
+    switch (command) {
+        case ControlCommand::LED:
+            available = ledManager != nullptr;
+            if (available) {
+                handleLed(args);
+            }
+            break;
+        case ControlCommand::LED_STATE:
+            available = ledManager != nullptr;
+            if (available) {
+                handleLedState(args);
+            }
+            break;
+        case ControlCommand::BRIGHTNESS:
+            available = ledManager != nullptr;
+            if (available) {
+                handleBrightness(args);
+            }
+            break;
+        case ControlCommand::START_STREAM:
+            available = webSocketClient != nullptr;
+            if (available) {
+                webSocketClient->handleStartStream();
+            }
+            break;
+        case ControlCommand::STOP_STREAM:
+            available = webSocketClient != nullptr;
+            if (available) {
+                webSocketClient->handleStopStream();
+            }
+            break;
+        case ControlCommand::QUEUE_CLIP:
+            available = webSocketClient != nullptr;
+            if (available) {
+                webSocketClient->handleQueueClip(args.clipId, args.source, args.crossfadeMs, args.length,
+                                                 args.name, args.url);
+            }
+            break;
+        case ControlCommand::CLIP_END:
+            available = audioManager != nullptr;
+            if (available) {
+                audioManager->endStreamClip(args.clipId, args.length);
+            }
+            break;
+        case ControlCommand::POWER_MODE:
+            available = powerManager != nullptr;
+            if (available) {
+                handlePowerMode(args);
+            }
+            break;
+        case ControlCommand::SLEEP_TIMEOUT:
+            available = powerManager != nullptr;
+            if (available && args.timeoutMs > 0) {
+                powerManager->setSleepTimeout(args.timeoutMs);
+            }
+            break;
+        case ControlCommand::SLEEP:
+            available = powerManager != nullptr;
+            if (available) {
+                powerManager->goToSleep();
+            }
+            break;
+        case ControlCommand::OTA_CHECK:
+            // OTA-Aufträge laufen in der OTA-Task, die Netzwerk-Task blockiert nicht
+            available = otaManager != nullptr;
+            if (available && !otaManager->requestCheck()) {
+                Serial.println("CommandRegistry: OTA beschäftigt, Prüfung abgelehnt");
+            }
+            break;
+        case ControlCommand::OTA_START:
+        case ControlCommand::OTA_URL:
+            available = otaManager != nullptr;
+            if (available && !otaManager->requestUpdate(command == ControlCommand::OTA_URL ? args.url : nullptr)) {
+                Serial.println("CommandRegistry: OTA beschäftigt, Update abgelehnt");
+            }
+            break;
+        case ControlCommand::WIFI_RECONNECT:
+            available = wifiManager != nullptr;
+            if (available) {
+                wifiManager->forceReconnect();
+            }
+            break;
+        case ControlCommand::CONFIG:
+            handleConfig(args);
+            break;
+        default:
+            stats.unknown++;
+            Serial.printf("CommandRegistry: Unbekannte Befehls-Id %u\n", (unsigned)command);
+            return false;
+    }
+    
+    if (!available) {
+        stats.unavailable++;
+        Serial.printf("CommandRegistry: Kein Manager für Befehl %u\n", (unsigned)command);
+        return false;
+    }
+    
+    recordHandlerTime(startUs);
+    return true;
+}
+
+// =============================================================================
+// HANDLER
+// =============================================================================
+
+void CommandRegistry::handleLed(const CommandArgs& args) {
+    uint32_t color = args.hasColor ? args.color : 0xFFFFFF;
+    
+    if (strcmp(args.effect, "breathing") == 0) {
+        ledManager->startBreathing(color);
+    } else if (strcmp(args.effect, "pulsing") == 0) {
+        ledManager->startPulsing(color);
+    } else if (strcmp(args.effect, "blinking") == 0) {
+        ledManager->startBlinking(color);
+    } else if (strcmp(args.effect, "off") == 0) {
+        ledManager->stopEffect();
+        ledManager->turnOff();
+    } else if (args.hasColor) {
+        ledManager->stopEffect();
+        ledManager->setColor((color >> 16) & 0xFF, (color >> 8) & 0xFF, color & 0xFF);
+    }
+}
+
+void CommandRegistry::handleLedState(const CommandArgs& args) {
+    static const struct {
+        const char* name;
+        LedState state;
+    } states[] = {
+        { "booting", LedState::BOOTING },
+        { "access_point", LedState::ACCESS_POINT },
+        { "wifi_connecting", LedState::WIFI_CONNECTING },
+        { "server_connecting", LedState::SERVER_CONNECTING },
+        { "connected", LedState::CONNECTED },
+        { "error", LedState::ERROR },
+        { "listening", LedState::LISTENING },
+        { "playing", LedState::PLAYING },
+        { "ota_update", LedState::OTA_UPDATE },
+        { "success", LedState::SUCCESS },
+        { "idle", LedState::IDLE },
+    };
+    
+    for (size_t i = 0; i < sizeof(states) / sizeof(states[0]); i++) {
+        if (strcmp(args.state, states[i].name) == 0) {
+            ledManager->setState(states[i].state);
+            return;
+        }
+    }
+    Serial.printf("CommandRegistry: Unbekannter LED-Zustand: %s\n", args.state);
+}
+
+void CommandRegistry::handleBrightness(const CommandArgs& args) {
+    if (args.brightness >= 0) {
+        ledManager->setBrightness(args.brightness);
+    }
+}
+
+void CommandRegistry::handlePowerMode(const CommandArgs& args) {
+    if (strcmp(args.mode, "always_on") == 0) {
+        powerManager->setPowerMode(PowerMode::ALWAYS_ON);
+    } else if (strcmp(args.mode, "button_wake") == 0) {
+        powerManager->setPowerMode(PowerMode::BUTTON_WAKE);
+    } else if (strcmp(args.mode, "timer_wake") == 0) {
+        powerManager->setPowerMode(PowerMode::TIMER_WAKE);
+    } else if (strcmp(args.mode, "deep_sleep") == 0) {
+        powerManager->setPowerMode(PowerMode::DEEP_SLEEP);
+    } else {
+        Serial.printf("CommandRegistry: Unbekannter Power-Modus: %s\n", args.mode);
+    }
+}
+
+void CommandRegistry::handleConfig(const CommandArgs& args) {
+    // config-Nachricht: nur gesetzte Werte übernehmen
+    if (ledManager && args.brightness >= 0) {
+        handleBrightness(args);
+    }
+    if (powerManager && args.timeoutMs > 0) {
+        powerManager->setSleepTimeout(args.timeoutMs);
+    }
+    if (powerManager && args.mode[0] != '\0') {
+        handlePowerMode(args);
+    }
+    Serial.println("CommandRegistry: Konfiguration übernommen");
+}
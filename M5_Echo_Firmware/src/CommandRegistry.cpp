@@ -0,0 +1,204 @@
+#include "CommandRegistry.h"
+#include <esp_timer.h>
+
+// =============================================================================
+// KONSTRUKTOR
+// =============================================================================
+
+CommandRegistry::CommandRegistry() {
+    webSocketClient = nullptr;
+    audioManager = nullptr;
+    ledManager = nullptr;
+    powerManager = nullptr;
+    otaManager = nullptr;
+    wifiManager = nullptr;
+    memset(&stats, 0, sizeof(stats));
+    
+    // Alles andere (type, clientId, ...) landet gar nicht erst im Dokument
+    filter["command"] = true;
+    filter["clipId"] = true;
+    filter["length"] = true;
+    filter["crossfadeMs"] = true;
+    filter["source"] = true;
+    filter["name"] = true;
+    filter["url"] = true;
+    filter["color"] = true;
+    filter["effect"] = true;
+    filter["state"] = true;
+    filter["brightness"] = true;
+    filter["mode"] = true;
+    filter["timeoutMs"] = true;
+}
+
+// =============================================================================
+// MANAGER-INTEGRATION
+// =============================================================================
+
+void CommandRegistry::setWebSocketClient(WebSocketClient* client) {
+    webSocketClient = client;
+}
+
+void CommandRegistry::setAudioManager(AudioManager* manager) {
+    audioManager = manager;
+}
+
+void CommandRegistry::setLedManager(LedManager* manager) {
+    ledManager = manager;
+}
+
+void CommandRegistry::setPowerManager(PowerManager* manager) {
+    powerManager = manager;
+}
+
+void CommandRegistry::setOtaManager(OtaManager* manager) {
+    otaManager = manager;
+}
+
+void CommandRegistry::setWifiManager(WifiManager* manager) {
+    wifiManager = manager;
+}
+
+// =============================================================================
+// BEFEHLSTABELLE
+// =============================================================================
+
+bool CommandRegistry::lookup(const char* name, ControlCommand& command) {
+    // Ein Hash, ein Sprung; strcmp schließt Fremdnamen mit gleichem Hash aus
+    switch (commandHash(name)) {
+#define COMMAND_HASH_CASE(id, value, jsonName) \
+        case commandHash(jsonName): \
+            command = ControlCommand::id; \
+            return strcmp(name, jsonName) == 0;
+        CONTROL_COMMANDS(COMMAND_HASH_CASE)
+#undef COMMAND_HASH_CASE
+        default:
+            return false;
+    }
+}
+
+// =============================================================================
+// DISPATCH
+// =============================================================================
+
+bool CommandRegistry::dispatchJson(const char* json, size_t length, const char* defaultCommand) {
+    StaticJsonDocument<512> doc;
+    DeserializationError error = deserializeJson(doc, json, length, DeserializationOption::Filter(filter));
+    if (error) {
+        Serial.printf("CommandRegistry: JSON-Parsing-Fehler: %s\n", error.c_str());
+        return false;
+    }
+    
+    const char* name = doc["command"] | defaultCommand;
+    ControlCommand command;
+    if (!name || !lookup(name, command)) {
+        stats.unknown++;
+        Serial.printf("CommandRegistry: Unbekannter Befehl: %s\n", name ? name : "-");
+        return false;
+    }
+    
+    CommandArgs args;
+    clearArgs(args);
+    args.clipId = doc["clipId"] | 0;
+    args.length = doc["length"] | 0;
+    args.crossfadeMs = doc["crossfadeMs"] | 0;
+    args.brightness = doc["brightness"] | -1;
+    args.timeoutMs = doc["timeoutMs"] | 0;
+    strlcpy(args.source, doc["source"] | "stream", sizeof(args.source));
+    strlcpy(args.name, doc["name"] | "", sizeof(args.name));
+    strlcpy(args.url, doc["url"] | "", sizeof(args.url));
+    strlcpy(args.effect, doc["effect"] | "", sizeof(args.effect));
+    strlcpy(args.state, doc["state"] | "", sizeof(args.state));
+    strlcpy(args.mode, doc["mode"] | "", sizeof(args.mode));
+    
+    // Farbe als "#RRGGBB" oder als Zahl
+    if (doc["color"].is<const char*>()) {
+        args.hasColor = parseColor(doc["color"].as<const char*>(), args.color);
+    } else if (doc["color"].is<uint32_t>()) {
+        args.hasColor = true;
+        args.color = doc["color"].as<uint32_t>();
+    }
+    
+    return dispatch(command, args);
+}
+
+bool CommandRegistry::dispatchControl(const uint8_t* data, size_t length) {
+    ControlReader reader(data, length);
+    if (!reader.isValid()) {
+        return false;
+    }
+    
+    CommandArgs args;
+    clearArgs(args);
+    strlcpy(args.source, "stream", sizeof(args.source));
+    int command = reader.type() == ControlType::CONFIG ? (int)ControlCommand::CONFIG : -1;
+    
+    char color[16] = "";
+    ControlTag tag;
+    const uint8_t* value;
+    uint8_t valueLength;
+    while (reader.next(tag, value, valueLength)) {
+        switch (tag) {
+            case ControlTag::COMMAND:      command = ControlReader::toUint(value, valueLength); break;
+            case ControlTag::CLIP_ID:      args.clipId = ControlReader::toUint(value, valueLength); break;
+            case ControlTag::LENGTH:       args.length = ControlReader::toUint(value, valueLength); break;
+            case ControlTag::CROSSFADE_MS: args.crossfadeMs = ControlReader::toUint(value, valueLength); break;
+            case ControlTag::BRIGHTNESS:   args.brightness = ControlReader::toUint(value, valueLength) & 0xFF; break;
+            case ControlTag::TIMEOUT_MS:   args.timeoutMs = ControlReader::toUint(value, valueLength); break;
+            case ControlTag::SOURCE: ControlReader::toString(value, valueLength, args.source, sizeof(args.source)); break;
+            case ControlTag::NAME:   ControlReader::toString(value, valueLength, args.name, sizeof(args.name)); break;
+            case ControlTag::URL:    ControlReader::toString(value, valueLength, args.url, sizeof(args.url)); break;
+            case ControlTag::EFFECT: ControlReader::toString(value, valueLength, args.effect, sizeof(args.effect)); break;
+            case ControlTag::STATE:  ControlReader::toString(value, valueLength, args.state, sizeof(args.state)); break;
+            case ControlTag::MODE:   ControlReader::toString(value, valueLength, args.mode, sizeof(args.mode)); break;
+            case ControlTag::COLOR:  ControlReader::toString(value, valueLength, color, sizeof(color)); break;
+            default: break;
+        }
+    }
+    if (color[0] != '\0') {
+        args.hasColor = parseColor(color, args.color);
+    }
+    
+    if (command < 0) {
+        stats.unknown++;
+        Serial.println("CommandRegistry: TLV-Befehl ohne Id");
+        return false;
+    }
+    return dispatch((ControlCommand)command, args);
+}
+
+// =============================================================================
+// HILFSFUNKTIONEN
+// =============================================================================
+
+bool CommandRegistry::parseColor(const char* text, uint32_t& color) {
+    if (text[0] == '#') {
+        text++;
+    }
+    char* end;
+    unsigned long value = strtoul(text, &end, 16);
+    if (end == text || *end != '\0' || value > 0xFFFFFF) {
+        return false;
+    }
+    color = value;
+    return true;
+}
+
+void CommandRegistry::clearArgs(CommandArgs& args) {
+    memset(&args, 0, sizeof(args));
+    args.brightness = -1;
+}
+
+void CommandRegistry::recordHandlerTime(int64_t startUs) {
+    uint32_t elapsedUs = (uint32_t)(esp_timer_get_time() - startUs);
+    stats.dispatched++;
+    stats.avgHandlerUs = stats.dispatched == 1
+        ? elapsedUs
+        : stats.avgHandlerUs + ((int32_t)(elapsedUs - stats.avgHandlerUs) >> 3);
+    if (elapsedUs > stats.maxHandlerUs) {
+        stats.maxHandlerUs = elapsedUs;
+    }
+}
+
+CommandStats CommandRegistry::getStats() const {
+    return stats;
+}
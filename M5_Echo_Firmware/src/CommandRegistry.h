@@ -0,0 +1,99 @@
+#ifndef COMMAND_REGISTRY_H
+#define COMMAND_REGISTRY_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "config.h"
+#include "ControlProtocol.h"
+
+class WebSocketClient;
+class AudioManager;
+class LedManager;
+class PowerManager;
+class OtaManager;
+class WifiManager;
+
+// FNV-1a über den Befehlsnamen; constexpr, damit die Tabelle zur Compile-Zeit
+// feststeht. Doppelte Hashes ergeben doppelte case-Labels und brechen den Build.
+constexpr uint32_t commandHash(const char* name, uint32_t hash = 2166136261u) {
+    return *name ? commandHash(name + 1, (hash ^ (uint8_t)*name) * 16777619u) : hash;
+}
+
+// Argumente aller Befehle, aus JSON oder TLV befüllt (keine Heap-Allokation)
+struct CommandArgs {
+    uint32_t clipId;
+    uint32_t length;
+    uint16_t crossfadeMs;
+    bool hasColor;
+    uint32_t color;                 // 0xRRGGBB
+    int16_t brightness;             // -1 = nicht gesetzt
+    uint32_t timeoutMs;             // 0 = nicht gesetzt
+    char effect[16];
+    char state[20];
+    char mode[16];
+    char source[16];
+    char name[64];
+    char url[WS_TLV_MAX_SIZE];
+};
+
+// Kennzahlen des Dispatchers
+struct CommandStats {
+    uint32_t dispatched;            // Ausgeführte Befehle
+    uint32_t unknown;               // Unbekannter Name bzw. Id
+    uint32_t unavailable;           // Zuständiger Manager nicht gesetzt
+    uint32_t avgHandlerUs;          // Handler-Laufzeit (Befehl bis Wirkung), geglättet
+    uint32_t maxHandlerUs;
+};
+
+// Leitet Server-Befehle (command, ota, config) direkt an die zuständigen
+// Manager. Befehle und Ids stehen im Schema (CONTROL_COMMANDS).
+class CommandRegistry {
+private:
+    WebSocketClient* webSocketClient;
+    AudioManager* audioManager;
+    LedManager* ledManager;
+    PowerManager* powerManager;
+    OtaManager* otaManager;
+    WifiManager* wifiManager;
+    
+    // Nur bekannte Argumente in das Dokument übernehmen; Platz für alle
+    // Schlüssel des Konstruktors auch mit den größeren Slots eines 64-Bit-Hosts
+    StaticJsonDocument<JSON_OBJECT_SIZE(16)> filter;
+    CommandStats stats;
+    
+    static bool lookup(const char* name, ControlCommand& command);
+    static bool parseColor(const char* text, uint32_t& color);
+    static void clearArgs(CommandArgs& args);
+    void recordHandlerTime(int64_t startUs);
+    
+    // Handler je Manager
+    void handleLed(const CommandArgs& args);
+    void handleLedState(const CommandArgs& args);
+    void handleBrightness(const CommandArgs& args);
+    void handlePowerMode(const CommandArgs& args);
+    void handleConfig(const CommandArgs& args);
+
+public:
+    CommandRegistry();
+    
+    // Manager-Integration
+    void setWebSocketClient(WebSocketClient* client);
+    void setAudioManager(AudioManager* manager);
+    void setLedManager(LedManager* manager);
+    void setPowerManager(PowerManager* manager);
+    void setOtaManager(OtaManager* manager);
+    void setWifiManager(WifiManager* manager);
+    
+    // JSON-Nachricht; Befehlsname aus "command", sonst defaultCommand
+    bool dispatchJson(const char* json, size_t length, const char* defaultCommand);
+    
+    // TLV-Nachricht vom Typ COMMAND oder CONFIG (ohne Kind-Byte)
+    bool dispatchControl(const uint8_t* data, size_t length);
+    
+    // Befehl mit bereits befüllten Argumenten ausführen (CommandDispatch.cpp)
+    bool dispatch(ControlCommand command, const CommandArgs& args);
+    
+    CommandStats getStats() const;
+};
+
+#endif // COMMAND_REGISTRY_H
@@ -0,0 +1,239 @@
+#include "ControlProtocol.h"
+
+// =============================================================================
+// SCHEMA-TABELLEN (aus den X-Makros generiert)
+// =============================================================================
+
+struct ControlFieldInfo {
+    const char* key;
+    uint8_t tag;
+    ControlValueType type;
+};
+
+struct ControlEventInfo {
+    const char* name;
+    uint8_t id;
+};
+
+#define CONTROL_FIELD_INFO(name, tag, type, key) { key, tag, ControlValueType::type },
+#define CONTROL_EVENT_INFO(name, id, jsonName) { jsonName, id },
+
+static const ControlFieldInfo FIELD_TABLE[] = { CONTROL_FIELDS(CONTROL_FIELD_INFO) };
+
+// Doppelte Schlüssel im selben Objekt: die meisten Parser behalten den letzten
+static constexpr bool sameKey(const char* a, const char* b) {
+    return *a == *b && (*a == '\0' || sameKey(a + 1, b + 1));
+}
+
+#define CONTROL_FIELD_KEY_CHECK(name, tag, type, key) \
+    static_assert(!sameKey(key, CONTROL_JSON_TIME_KEY), "Feld " #name " belegt den Zeitstempel der Hülle");
+CONTROL_FIELDS(CONTROL_FIELD_KEY_CHECK)
+static const ControlEventInfo EVENT_TABLE[] = { CONTROL_EVENTS(CONTROL_EVENT_INFO) };
+
+bool controlEventId(const char* name, uint8_t& id) {
+    for (size_t i = 0; i < sizeof(EVENT_TABLE) / sizeof(EVENT_TABLE[0]); i++) {
+        if (strcmp(EVENT_TABLE[i].name, name) == 0) {
+            id = EVENT_TABLE[i].id;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* controlEventName(uint8_t id) {
+    for (size_t i = 0; i < sizeof(EVENT_TABLE) / sizeof(EVENT_TABLE[0]); i++) {
+        if (EVENT_TABLE[i].id == id) {
+            return EVENT_TABLE[i].name;
+        }
+    }
+    return nullptr;
+}
+
+const char* controlFieldKey(ControlTag tag, ControlValueType& type) {
+    for (size_t i = 0; i < sizeof(FIELD_TABLE) / sizeof(FIELD_TABLE[0]); i++) {
+        if (FIELD_TABLE[i].tag == (uint8_t)tag) {
+            type = FIELD_TABLE[i].type;
+            return FIELD_TABLE[i].key;
+        }
+    }
+    return nullptr;
+}
+
+// =============================================================================
+// SCHREIBEN
+// =============================================================================
+
+ControlWriter::ControlWriter(uint8_t* buffer, size_t capacity, ControlType type, uint8_t kind)
+    : buffer(buffer), capacity(capacity), length(0), overflow(capacity < 2) {
+    if (!overflow) {
+        buffer[length++] = kind;
+        buffer[length++] = (uint8_t)type;
+    }
+}
+
+void ControlWriter::putUint(ControlTag tag, uint64_t value) {
+    // Minimale Länge: 0 belegt keine Wertbytes
+    uint8_t valueLength = 0;
+    for (uint64_t rest = value; rest != 0; rest >>= 8) {
+        valueLength++;
+    }
+    if (overflow || length + 2 + valueLength > capacity) {
+        overflow = true;
+        return;
+    }
+    
+    buffer[length++] = (uint8_t)tag;
+    buffer[length++] = valueLength;
+    for (uint8_t i = 0; i < valueLength; i++) {
+        buffer[length++] = (value >> (i * 8)) & 0xFF;
+    }
+}
+
+void ControlWriter::putString(ControlTag tag, const char* value, size_t valueLength) {
+    if (overflow || valueLength > 255 || length + 2 + valueLength > capacity) {
+        overflow = true;
+        return;
+    }
+    
+    buffer[length++] = (uint8_t)tag;
+    buffer[length++] = (uint8_t)valueLength;
+    memcpy(buffer + length, value, valueLength);
+    length += valueLength;
+}
+
+bool ControlWriter::putFields(const EventField* fields, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (fields[i].text) {
+            putString(fields[i].tag, fields[i].text, strlen(fields[i].text));
+        } else if (fields[i].number < 0) {
+            return false; // TLV kennt nur vorzeichenlose Zahlen -> JSON-Fallback
+        } else {
+            putUint(fields[i].tag, (uint64_t)fields[i].number);
+        }
+    }
+    return ok();
+}
+
+void controlWriteJsonFields(JsonWriter& json, const EventField* fields, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        ControlValueType type;
+        const char* key = controlFieldKey(fields[i].tag, type);
+        if (!key) {
+            continue;
+        }
+        if (fields[i].text) {
+            json.addString(key, fields[i].text);
+        } else if (type == ControlValueType::BOOL) {
+            json.addBool(key, fields[i].number != 0);
+        } else {
+            json.addInt(key, fields[i].number);
+        }
+    }
+}
+
+void controlWriteJsonEvent(JsonWriter& json, const char* eventType, const EventField* fields, size_t count,
+                           const char* clientId, uint32_t timestampMs) {
+    json.beginObject();
+    json.addString("type", "event");
+    json.addString("event", eventType);
+    controlWriteJsonFields(json, fields, count);
+    json.addString("clientId", clientId);
+    json.addUint(CONTROL_JSON_TIME_KEY, timestampMs);
+    json.endObject();
+}
+
+bool controlWriteJsonMessage(JsonWriter& json, const uint8_t* message, size_t length, const char* clientId) {
+    // Gegenstück zu den TLV-Erzeugern: dieselben Felder unter ihren JSON-Namen
+    ControlReader reader(message, length);
+    if (!reader.isValid()) {
+        return false;
+    }
+    
+    const char* type;
+    switch (reader.type()) {
+        case ControlType::EVENT:     type = "event"; break;
+        case ControlType::HEARTBEAT: type = "heartbeat"; break;
+        case ControlType::CREDIT:    type = "credit"; break;
+        default:                     return false;
+    }
+    json.beginObject();
+    json.addString("type", type);
+    
+    ControlTag tag;
+    const uint8_t* value;
+    uint8_t valueLength;
+    while (reader.next(tag, value, valueLength)) {
+        if (tag == ControlTag::EVENT) {
+            const char* name = controlEventName(ControlReader::toUint(value, valueLength));
+            if (!name) {
+                return false;
+            }
+            json.addString("event", name);
+        } else if (tag == ControlTag::UPTIME_MS) {
+            json.addUint(CONTROL_JSON_TIME_KEY, ControlReader::toUint(value, valueLength));
+        } else {
+            ControlValueType valueType;
+            const char* key = controlFieldKey(tag, valueType);
+            if (!key) {
+                return false;
+            }
+            if (valueType == ControlValueType::STR) {
+                char text[256];
+                ControlReader::toString(value, valueLength, text, sizeof(text));
+                json.addString(key, text);
+            } else if (valueType == ControlValueType::BOOL) {
+                json.addBool(key, ControlReader::toUint(value, valueLength) != 0);
+            } else {
+                json.addUint(key, ControlReader::toUint(value, valueLength));
+            }
+        }
+    }
+    if (reader.type() != ControlType::CREDIT) {
+        json.addString("clientId", clientId);
+    }
+    json.endObject();
+    return json.ok();
+}
+
+// =============================================================================
+// LESEN
+// =============================================================================
+
+ControlReader::ControlReader(const uint8_t* data, size_t length)
+    : data(data), length(length), offset(1) {
+}
+
+bool ControlReader::next(ControlTag& tag, const uint8_t*& value, uint8_t& valueLength) {
+    if (offset + 2 > length) {
+        return false;
+    }
+    
+    uint8_t fieldLength = data[offset + 1];
+    if (offset + 2 + fieldLength > length) {
+        offset = length; // Abgeschnitten: Rest ignorieren
+        return false;
+    }
+    
+    tag = (ControlTag)data[offset];
+    value = data + offset + 2;
+    valueLength = fieldLength;
+    offset += 2 + fieldLength;
+    return true;
+}
+
+uint64_t ControlReader::toUint(const uint8_t* value, uint8_t valueLength) {
+    uint64_t result = 0;
+    for (uint8_t i = 0; i < valueLength && i < 8; i++) {
+        result |= (uint64_t)value[i] << (i * 8);
+    }
+    return result;
+}
+
+void ControlReader::toString(const uint8_t* value, uint8_t valueLength, char* out, size_t outSize) {
+    if (outSize == 0) {
+        return;
+    }
+    size_t copyLength = min((size_t)valueLength, outSize - 1);
+    memcpy(out, value, copyLength);
+    out[copyLength] = '\0';
+}
@@ -0,0 +1,207 @@
+#ifndef CONTROL_PROTOCOL_H
+#define CONTROL_PROTOCOL_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "JsonWriter.h"
+
+// =============================================================================
+// KOMPAKTES BINÄRES STEUERPROTOKOLL (TLV)
+// =============================================================================
+//
+// Wird bei der Identifikation angeboten ("tlv" in capabilities) und vom
+// Server per {"type":"encoding","value":"tlv"} eingeschaltet. Ab dann trägt
+// jeder Binär-Frame ein Kind-Byte vor den Nutzdaten. Es ist die Id des
+// logischen Kanals; der Sender plant jeden Kanal mit eigener Queue:
+//
+//   Audio:       [WS_KIND_AUDIO][PCM ...]
+//   Steuerung:   [WS_KIND_CONTROL][Typ][Tag][Länge][Wert] ...
+//   Telemetrie:  [WS_KIND_TELEMETRY][Typ][Tag][Länge][Wert] ...
+//   Bulk:        [WS_KIND_BULK][Daten ...]
+//
+// Audio hat in beiden Richtungen dieselbe Id (Uplink Mikrofon, Downlink
+// Wiedergabe). Zahlen sind little-endian mit minimaler Länge (0..8 Bytes),
+// Strings ohne Nullbyte. Unbekannte Tags werden anhand der Länge übersprungen.
+
+#define WS_KIND_AUDIO      0x00
+#define WS_KIND_CONTROL    0x01
+#define WS_KIND_TELEMETRY  0x02     // Heartbeat, Fortschritt; veraltete Werte dürfen entfallen
+#define WS_KIND_BULK       0x03     // Große Übertragungen (Logs, Diagnose), niedrigste Priorität
+#define WS_KIND_COUNT      4
+#define WS_KIND_UNKNOWN    0xFF     // Erstes Nutzdaten-Byte noch nicht gelesen
+
+// Nachrichtentypen: X(Name, Id)
+#define CONTROL_MESSAGE_TYPES(X) \
+    X(EVENT,        0x01)  /* Client -> Server */ \
+    X(HEARTBEAT,    0x02) \
+    X(CREDIT,       0x03) \
+    X(COMMAND,      0x10)  /* Server -> Client */ \
+    X(CONFIG,       0x11) \
+    X(SESSION,      0x12)
+
+// Ereignisse: X(Name, Id, JSON-Name)
+#define CONTROL_EVENTS(X) \
+    X(BUTTON_PRESSED,    0x01, EVENT_BUTTON_PRESSED) \
+    X(BUTTON_RELEASED,   0x02, EVENT_BUTTON_RELEASED) \
+    X(UTTERANCE_END,     0x03, EVENT_UTTERANCE_END) \
+    X(STREAM_STARTED,    0x04, "stream_started") \
+    X(STREAM_STOPPED,    0x05, "stream_stopped") \
+    X(CLIP_STARTED,      0x06, EVENT_CLIP_STARTED) \
+    X(CLIP_FINISHED,     0x07, EVENT_CLIP_FINISHED) \
+    X(CLIP_REJECTED,     0x08, EVENT_CLIP_REJECTED) \
+    X(PLAYBACK_PROGRESS, 0x09, EVENT_PLAYBACK_PROGRESS) \
+    X(PLAYBACK_DONE,     0x0A, EVENT_PLAYBACK_DONE) \
+    X(BARGE_IN,          0x0B, EVENT_BARGE_IN) \
+    X(LATENCY_CONFIG,    0x0C, EVENT_LATENCY_CONFIG) \
+    X(UPLINK_CONFIG,     0x0D, EVENT_UPLINK_CONFIG)
+
+// Befehle: X(Name, Id, JSON-Name)
+#define CONTROL_COMMANDS(X) \
+    X(LED,               0x01, "led") \
+    X(START_STREAM,      0x02, "start_stream") \
+    X(STOP_STREAM,       0x03, "stop_stream") \
+    X(QUEUE_CLIP,        0x04, "queue_clip") \
+    X(CLIP_END,          0x05, "clip_end") \
+    X(LED_STATE,         0x06, "led_state") \
+    X(BRIGHTNESS,        0x07, "brightness") \
+    X(POWER_MODE,        0x08, "power_mode") \
+    X(SLEEP_TIMEOUT,     0x09, "sleep_timeout") \
+    X(SLEEP,             0x0A, "sleep") \
+    X(OTA_CHECK,         0x0B, "ota_check") \
+    X(OTA_START,         0x0C, "ota_start") \
+    X(OTA_URL,           0x0D, "ota_url") \
+    X(WIFI_RECONNECT,    0x0E, "wifi_reconnect") \
+    X(CONFIG,            0x0F, "config")      /* Nachrichtentyp config */
+
+// Zeitstempel der JSON-Hülle (Sendezeit in ms); kein Feldschlüssel darf ihn belegen
+#define CONTROL_JSON_TIME_KEY "timestamp"
+
+// Felder: X(Name, Tag, Typ, JSON-Schlüssel)
+#define CONTROL_FIELDS(X) \
+    X(EVENT,               0x01, UINT, "event") \
+    X(COMMAND,             0x02, UINT, "command") \
+    X(UPTIME_MS,           0x03, UINT, "uptimeMs") \
+    X(TIMESTAMP,           0x04, UINT, "eventTimeUs") \
+    X(SAMPLE_INDEX,        0x05, UINT, "sampleIndex") \
+    X(CAPTURE_TIMESTAMP,   0x06, UINT, "captureTimestamp") \
+    X(SAMPLE_RATE,         0x07, UINT, "sampleRate") \
+    X(CLIP_ID,             0x08, UINT, "clipId") \
+    X(CLIP_SAMPLE,         0x09, UINT, "clipSample") \
+    X(LAST_CLIP_ID,        0x0A, UINT, "lastClipId") \
+    X(SPEECH_START_SAMPLE, 0x0B, UINT, "speechStartSample") \
+    X(SPEECH_END_SAMPLE,   0x0C, UINT, "speechEndSample") \
+    X(TRAILING_SILENCE_MS, 0x0D, UINT, "trailingSilenceMs") \
+    X(PRESS_TO_CAPTURE_US, 0x0E, UINT, "pressToCaptureUs") \
+    X(TARGET,              0x0F, STR,  "target") \
+    X(DMA_BUF_COUNT,       0x10, UINT, "dmaBufCount") \
+    X(DMA_BUF_LEN,         0x11, UINT, "dmaBufLen") \
+    X(BUFFER_MS,           0x12, UINT, "bufferMs") \
+    X(JITTER_US,           0x13, UINT, "jitterUs") \
+    X(DROPOUTS,            0x14, UINT, "dropouts") \
+    X(RX,                  0x15, UINT, "rx") \
+    X(LIMIT,               0x16, UINT, "limit") \
+    X(DROPS,               0x17, UINT, "drops") \
+    X(SOURCE,              0x18, STR,  "source") \
+    X(CROSSFADE_MS,        0x19, UINT, "crossfadeMs") \
+    X(LENGTH,              0x1A, UINT, "length") \
+    X(NAME,                0x1B, STR,  "name") \
+    X(URL,                 0x1C, STR,  "url") \
+    X(COLOR,               0x1D, STR,  "color") \
+    X(EFFECT,              0x1E, STR,  "effect") \
+    X(TOKEN,               0x1F, STR,  "token") \
+    X(RESUMED,             0x20, BOOL, "resumed") \
+    X(BRIGHTNESS,          0x21, UINT, "brightness") \
+    X(STATE,               0x22, STR,  "state") \
+    X(MODE,                0x23, STR,  "mode") \
+    X(TIMEOUT_MS,          0x24, UINT, "timeoutMs") \
+    X(FRAME_MS,            0x25, UINT, "frameMs") \
+    X(FRAME_BYTES,         0x26, UINT, "frameBytes") \
+    X(OVERHEAD_PERMILLE,   0x27, UINT, "overheadPermille") \
+    X(SEND_LATENCY_US,     0x28, UINT, "sendLatencyUs") \
+    X(PIPELINING,          0x29, BOOL, "pipelining")
+
+// Generierte Aufzählungen
+#define CONTROL_ENUM_ENTRY(name, id, ...) name = id,
+
+enum class ControlType : uint8_t { CONTROL_MESSAGE_TYPES(CONTROL_ENUM_ENTRY) };
+enum class ControlEvent : uint8_t { CONTROL_EVENTS(CONTROL_ENUM_ENTRY) };
+enum class ControlCommand : uint8_t { CONTROL_COMMANDS(CONTROL_ENUM_ENTRY) };
+enum class ControlTag : uint8_t { CONTROL_FIELDS(CONTROL_ENUM_ENTRY) };
+
+enum class ControlValueType : uint8_t { UINT, STR, BOOL };
+
+// Typisiertes Feld eines Ereignisses. Tag (TLV) und Schlüssel (JSON) kommen
+// aus dem Schema, die Erzeuger schreiben ohne Zwischen-String in beide Kodierungen.
+struct EventField {
+    ControlTag tag;
+    int64_t number;             // UINT und BOOL
+    const char* text;           // STR, sonst nullptr
+    
+    EventField(ControlTag tag, int64_t number) : tag(tag), number(number), text(nullptr) {}
+    EventField(ControlTag tag, const char* text) : tag(tag), number(0), text(text) {}
+};
+
+// Schreibt einen kompletten Binär-Frame (Kind-Byte, Typ, Felder) in einen
+// Puffer des Aufrufers. Läuft der Puffer über, ist ok() false. Steuerung und
+// Telemetrie verwenden dasselbe Format, nur das Kind-Byte unterscheidet sie.
+class ControlWriter {
+private:
+    uint8_t* buffer;
+    size_t capacity;
+    size_t length;
+    bool overflow;
+
+public:
+    ControlWriter(uint8_t* buffer, size_t capacity, ControlType type, uint8_t kind = WS_KIND_CONTROL);
+    
+    void putUint(ControlTag tag, uint64_t value);
+    void putString(ControlTag tag, const char* value, size_t valueLength);
+    
+    // Ereignisfelder übernehmen; false bei negativer Zahl (nur in JSON darstellbar)
+    bool putFields(const EventField* fields, size_t count);
+    
+    bool ok() const { return !overflow; }
+    const uint8_t* data() const { return buffer; }
+    size_t size() const { return length; }
+};
+
+// Liest eine Steuer-Nachricht (ohne Kind-Byte) an Ort und Stelle
+class ControlReader {
+private:
+    const uint8_t* data;
+    size_t length;
+    size_t offset;
+
+public:
+    ControlReader(const uint8_t* data, size_t length);
+    
+    bool isValid() const { return length >= 1; }
+    ControlType type() const { return (ControlType)data[0]; }
+    
+    // Nächstes Feld; false am Ende oder bei abgeschnittenem Feld
+    bool next(ControlTag& tag, const uint8_t*& value, uint8_t& valueLength);
+    
+    static uint64_t toUint(const uint8_t* value, uint8_t valueLength);
+    static void toString(const uint8_t* value, uint8_t valueLength, char* out, size_t outSize);
+};
+
+// Ereignis-Id zum JSON-Namen; false, wenn das Schema das Ereignis nicht kennt
+bool controlEventId(const char* name, uint8_t& id);
+
+// Umkehrung für das Umkodieren nach JSON; nullptr, wenn das Schema Id bzw. Tag nicht kennt
+const char* controlEventName(uint8_t id);
+const char* controlFieldKey(ControlTag tag, ControlValueType& type);
+
+// Ereignisfelder unter ihren JSON-Schlüsseln ins aktuelle Objekt schreiben
+void controlWriteJsonFields(JsonWriter& json, const EventField* fields, size_t count);
+
+// Komplettes Ereignis als JSON-Objekt: Typ, Name, Felder, Client-Id und der
+// Zeitstempel der Hülle (Sendezeit in ms)
+void controlWriteJsonEvent(JsonWriter& json, const char* eventType, const EventField* fields, size_t count,
+                           const char* clientId, uint32_t timestampMs);
+
+// TLV-Nachricht (ohne Kind-Byte) als JSON-Objekt; die Uptime beim Einreihen
+// wird zum Zeitstempel der Hülle. false bei unbekanntem Typ, Ereignis oder Tag.
+bool controlWriteJsonMessage(JsonWriter& json, const uint8_t* message, size_t length, const char* clientId);
+
+#endif // CONTROL_PROTOCOL_H
@@ -0,0 +1,129 @@
+#include "JsonWriter.h"
+
+// =============================================================================
+// KONSTRUKTOR
+// =============================================================================
+
+JsonWriter::JsonWriter(char* buffer, size_t capacity)
+    : buffer(buffer), capacity(capacity), length(0), overflow(false), needComma(false) {
+}
+
+// =============================================================================
+// STRUKTUR
+// =============================================================================
+
+void JsonWriter::beginObject() {
+    if (needComma) {
+        append(',');
+    }
+    append('{');
+    needComma = false;
+}
+
+void JsonWriter::beginObject(const char* name) {
+    key(name);
+    append('{');
+    needComma = false;
+}
+
+void JsonWriter::endObject() {
+    append('}');
+    needComma = true;
+}
+
+// =============================================================================
+// FELDER
+// =============================================================================
+
+void JsonWriter::addString(const char* name, const char* value) {
+    key(name);
+    append('"');
+    appendEscaped(value);
+    append('"');
+}
+
+void JsonWriter::addUint(const char* name, uint64_t value) {
+    key(name);
+    appendUnsigned(value);
+}
+
+void JsonWriter::addInt(const char* name, int64_t value) {
+    key(name);
+    if (value < 0) {
+        append('-');
+        appendUnsigned((uint64_t)0 - (uint64_t)value);
+    } else {
+        appendUnsigned((uint64_t)value);
+    }
+}
+
+void JsonWriter::addBool(const char* name, bool value) {
+    key(name);
+    if (value) {
+        append("true", 4);
+    } else {
+        append("false", 5);
+    }
+}
+
+// =============================================================================
+// HILFSFUNKTIONEN
+// =============================================================================
+
+void JsonWriter::key(const char* name) {
+    if (needComma) {
+        append(',');
+    }
+    append('"');
+    appendEscaped(name);
+    append("\":", 2);
+    needComma = true;
+}
+
+void JsonWriter::append(char c) {
+    if (overflow || length + 1 > capacity) {
+        overflow = true;
+        return;
+    }
+    buffer[length++] = c;
+}
+
+void JsonWriter::append(const char* text, size_t textLength) {
+    if (overflow || length + textLength > capacity) {
+        overflow = true;
+        return;
+    }
+    memcpy(buffer + length, text, textLength);
+    length += textLength;
+}
+
+void JsonWriter::appendEscaped(const char* text) {
+    static const char hex[] = "0123456789abcdef";
+    
+    for (const char* p = text; *p != '\0'; p++) {
+        uint8_t c = (uint8_t)*p;
+        if (c == '"' || c == '\\') {
+            append('\\');
+            append((char)c);
+        } else if (c < 0x20) {
+            char escaped[6] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 0x0F] };
+            append(escaped, sizeof(escaped));
+        } else {
+            append((char)c);
+        }
+    }
+}
+
+void JsonWriter::appendUnsigned(uint64_t value) {
+    // Ziffern rückwärts in einen kleinen Puffer, statt String(value)
+    char digits[20];
+    size_t count = 0;
+    do {
+        digits[count++] = '0' + (value % 10);
+        value /= 10;
+    } while (value != 0);
+    
+    while (count > 0) {
+        append(digits[--count]);
+    }
+}
@@ -0,0 +1,40 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <Arduino.h>
+
+// Streamender JSON-Schreiber in einen festen Puffer des Aufrufers (z.B. den
+// Slot der Sende-Queue). Keine Heap-Allokation; läuft der Puffer über, wird
+// nicht weiter geschrieben und ok() ist false. Kommas setzt der Schreiber.
+class JsonWriter {
+private:
+    char* buffer;
+    size_t capacity;
+    size_t length;
+    bool overflow;
+    bool needComma;             // Im aktuellen Objekt steht schon ein Feld
+    
+    void append(char c);
+    void append(const char* text, size_t textLength);
+    void appendEscaped(const char* text);
+    void appendUnsigned(uint64_t value);
+    void key(const char* name);
+
+public:
+    JsonWriter(char* buffer, size_t capacity);
+    
+    void beginObject();
+    void beginObject(const char* name);     // Verschachteltes Objekt als Feld
+    void endObject();
+    
+    void addString(const char* name, const char* value);
+    void addUint(const char* name, uint64_t value);
+    void addInt(const char* name, int64_t value);
+    void addBool(const char* name, bool value);
+    
+    bool ok() const { return !overflow; }
+    const char* data() const { return buffer; }
+    size_t size() const { return length; }
+};
+
+#endif // JSON_WRITER_H
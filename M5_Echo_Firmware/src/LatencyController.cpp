@@ -0,0 +1,120 @@
+#include "LatencyController.h"
+
+static const DmaGeometry DMA_LEVELS[] = LATENCY_DMA_LEVELS;
+static const uint8_t DMA_LEVEL_COUNT = sizeof(DMA_LEVELS) / sizeof(DMA_LEVELS[0]);
+
+// =============================================================================
+// KONSTRUKTOR
+// =============================================================================
+
+LatencyController::LatencyController() {
+    mux = portMUX_INITIALIZER_UNLOCKED;
+    reset();
+}
+
+void LatencyController::reset() {
+    portENTER_CRITICAL(&mux);
+    level = LATENCY_DEFAULT_LEVEL < DMA_LEVEL_COUNT ? LATENCY_DEFAULT_LEVEL : DMA_LEVEL_COUNT - 1;
+    peakJitterUs = 0;
+    windowPeakJitterUs = 0;
+    windowSamples = 0;
+    windowDropouts = 0;
+    totalDropouts = 0;
+    stableWindows = 0;
+    portEXIT_CRITICAL(&mux);
+}
+
+// =============================================================================
+// MESSWERTE
+// =============================================================================
+
+void LatencyController::recordInterval(uint32_t actualUs, uint32_t expectedUs) {
+    // Nur Verspätung zählt, zu frühe Rückkehr heißt: DMA hatte noch Platz
+    uint32_t jitter = actualUs > expectedUs ? actualUs - expectedUs : 0;
+    
+    portENTER_CRITICAL(&mux);
+    if (jitter > windowPeakJitterUs) {
+        windowPeakJitterUs = jitter;
+    }
+    windowSamples++;
+    portEXIT_CRITICAL(&mux);
+}
+
+void LatencyController::recordDropout() {
+    portENTER_CRITICAL(&mux);
+    windowDropouts++;
+    totalDropouts++;
+    portEXIT_CRITICAL(&mux);
+}
+
+// =============================================================================
+// REGELUNG
+// =============================================================================
+
+bool LatencyController::update(uint32_t blockUs) {
+    portENTER_CRITICAL(&mux);
+    
+    // Zu wenige Messungen (kurze Äußerung): Stufe beibehalten
+    if (windowSamples < LATENCY_MIN_SAMPLES && windowDropouts == 0) {
+        portEXIT_CRITICAL(&mux);
+        return false;
+    }
+    
+    // Spitzenwert langsam abklingen lassen, neue Spitzen sofort übernehmen
+    uint32_t decayed = peakJitterUs - peakJitterUs / 8;
+    peakJitterUs = windowPeakJitterUs > decayed ? windowPeakJitterUs : decayed;
+    
+    uint32_t requiredUs = blockUs + LATENCY_JITTER_FACTOR * peakJitterUs + LATENCY_MARGIN_US;
+    uint8_t target = DMA_LEVEL_COUNT - 1;
+    for (uint8_t i = 0; i < DMA_LEVEL_COUNT; i++) {
+        if (capacityUs(i) >= requiredUs) {
+            target = i;
+            break;
+        }
+    }
+    
+    // Aussetzer: mindestens eine Stufe größer, unabhängig vom Jitter
+    if (windowDropouts > 0 && level + 1 < DMA_LEVEL_COUNT && target <= level) {
+        target = level + 1;
+    }
+    
+    uint8_t previous = level;
+    if (target > level) {
+        level = target;
+        stableWindows = 0;
+    } else if (target < level) {
+        // Nur schrittweise verkleinern, nach mehreren sauberen Fenstern
+        if (++stableWindows >= LATENCY_STABLE_WINDOWS) {
+            level--;
+            stableWindows = 0;
+        }
+    } else {
+        stableWindows = 0;
+    }
+    
+    windowPeakJitterUs = 0;
+    windowSamples = 0;
+    windowDropouts = 0;
+    
+    portEXIT_CRITICAL(&mux);
+    return level != previous;
+}
+
+DmaGeometry LatencyController::getGeometry() const {
+    return DMA_LEVELS[level];
+}
+
+LatencyStats LatencyController::getStats() const {
+    LatencyStats stats;
+    stats.level = level;
+    stats.geometry = DMA_LEVELS[level];
+    stats.bufferMs = capacityUs(level) / 1000;
+    stats.peakJitterUs = peakJitterUs;
+    stats.dropouts = totalDropouts;
+    return stats;
+}
+
+uint32_t LatencyController::capacityUs(uint8_t level) {
+    uint32_t frames = (uint32_t)DMA_LEVELS[level].bufCount * DMA_LEVELS[level].bufLen;
+    return (uint32_t)((uint64_t)frames * 1000000ULL / I2S_SAMPLE_RATE);
+}
@@ -0,0 +1,56 @@
+#ifndef LATENCY_CONTROLLER_H
+#define LATENCY_CONTROLLER_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include "config.h"
+
+// DMA-Geometrie eines I2S-Treibers
+struct DmaGeometry {
+    uint8_t bufCount;
+    uint16_t bufLen;            // Frames pro Puffer
+};
+
+// Zustand des Reglers für Diagnose und Server-Meldung
+struct LatencyStats {
+    DmaGeometry geometry;
+    uint8_t level;
+    uint32_t bufferMs;          // Kapazität der DMA
+    uint32_t peakJitterUs;      // Geglätteter Spitzen-Jitter
+    uint32_t dropouts;          // Unter-/Überläufe seit Start
+};
+
+// Wählt die kleinste DMA-Geometrie, die den gemessenen Scheduling-Jitter
+// sicher überbrückt. Messungen kommen aus den Audio-Tasks, update() wird
+// zwischen Äußerungen aufgerufen.
+class LatencyController {
+private:
+    uint8_t level;
+    uint32_t peakJitterUs;
+    uint32_t windowPeakJitterUs;
+    uint32_t windowSamples;
+    uint32_t windowDropouts;
+    uint32_t totalDropouts;
+    uint8_t stableWindows;
+    portMUX_TYPE mux;
+    
+    static uint32_t capacityUs(uint8_t level);
+
+public:
+    LatencyController();
+    
+    void reset();
+    
+    // Messwerte (aus den Audio-Tasks)
+    void recordInterval(uint32_t actualUs, uint32_t expectedUs);
+    void recordDropout();
+    
+    // Neue Stufe wählen; blockUs = Größe eines Lese-/Schreibblocks.
+    // Rückgabe true, wenn sich die Geometrie geändert hat.
+    bool update(uint32_t blockUs);
+    
+    DmaGeometry getGeometry() const;
+    LatencyStats getStats() const;
+};
+
+#endif // LATENCY_CONTROLLER_H
@@ -0,0 +1,107 @@
+#include "LinkMonitor.h"
+
+// =============================================================================
+// KONSTRUKTOR
+// =============================================================================
+
+LinkMonitor::LinkMonitor() {
+    mux = portMUX_INITIALIZER_UNLOCKED;
+    reset();
+}
+
+void LinkMonitor::reset() {
+    portENTER_CRITICAL(&mux);
+    memset(&quality, 0, sizeof(quality));
+    lastSentSeq = 0;
+    lastAckedSeq = 0;
+    portEXIT_CRITICAL(&mux);
+}
+
+// =============================================================================
+// PING / PONG
+// =============================================================================
+
+size_t LinkMonitor::buildPing(uint8_t* payload, int64_t nowUs) {
+    portENTER_CRITICAL(&mux);
+    if (lastSentSeq != lastAckedSeq && quality.missedPongs < 255) {
+        quality.missedPongs++;
+    }
+    uint32_t seq = ++lastSentSeq;
+    quality.pingsSent++;
+    portEXIT_CRITICAL(&mux);
+    
+    for (int i = 0; i < 4; i++) {
+        payload[i] = (seq >> (24 - i * 8)) & 0xFF;
+    }
+    for (int i = 0; i < 8; i++) {
+        payload[4 + i] = ((uint64_t)nowUs >> (56 - i * 8)) & 0xFF;
+    }
+    return LINK_PING_PAYLOAD_SIZE;
+}
+
+bool LinkMonitor::recordPong(const uint8_t* payload, size_t length, int64_t nowUs) {
+    // Unaufgeforderte Pongs (RFC 6455, 5.5.3) haben kein passendes Format
+    if (length != LINK_PING_PAYLOAD_SIZE) {
+        return false;
+    }
+    
+    uint32_t seq = 0;
+    for (int i = 0; i < 4; i++) {
+        seq = (seq << 8) | payload[i];
+    }
+    uint64_t sentUs = 0;
+    for (int i = 0; i < 8; i++) {
+        sentUs = (sentUs << 8) | payload[4 + i];
+    }
+    if ((int64_t)sentUs > nowUs) {
+        return false;
+    }
+    uint32_t rttUs = (uint32_t)(nowUs - (int64_t)sentUs);
+    
+    portENTER_CRITICAL(&mux);
+    
+    // Nur Antworten auf noch nicht bestätigte Pings der aktuellen Verbindung
+    if ((int32_t)(seq - lastAckedSeq) <= 0 || (int32_t)(seq - lastSentSeq) > 0) {
+        portEXIT_CRITICAL(&mux);
+        return false;
+    }
+    lastAckedSeq = seq;
+    quality.missedPongs = 0;
+    quality.pongsReceived++;
+    quality.lastRttUs = rttUs;
+    
+    // RFC 6298, 2.2/2.3: erste Messung setzt SRTT, danach alpha = 1/8, beta = 1/4
+    if (!quality.valid) {
+        quality.srttUs = rttUs;
+        quality.rttVarUs = rttUs / 2;
+        quality.minRttUs = rttUs;
+        quality.valid = true;
+    } else {
+        uint32_t deviation = quality.srttUs > rttUs ? quality.srttUs - rttUs : rttUs - quality.srttUs;
+        quality.rttVarUs = quality.rttVarUs - quality.rttVarUs / 4 + deviation / 4;
+        quality.srttUs = quality.srttUs - quality.srttUs / 8 + rttUs / 8;
+        if (rttUs < quality.minRttUs) {
+            quality.minRttUs = rttUs;
+        }
+    }
+    quality.rtoUs = quality.srttUs + 4 * quality.rttVarUs;
+    
+    portEXIT_CRITICAL(&mux);
+    return true;
+}
+
+// =============================================================================
+// STATUS
+// =============================================================================
+
+bool LinkMonitor::isPeerDead() const {
+    return quality.missedPongs >= WS_PONG_MAX_MISSED;
+}
+
+LinkQuality LinkMonitor::getQuality() const {
+    LinkQuality copy;
+    portENTER_CRITICAL(&mux);
+    copy = quality;
+    portEXIT_CRITICAL(&mux);
+    return copy;
+}
@@ -0,0 +1,49 @@
+#ifndef LINK_MONITOR_H
+#define LINK_MONITOR_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include "config.h"
+
+// Nutzdaten eines Pings: Sequenznummer und Sendezeitpunkt (Network Byte Order)
+#define LINK_PING_PAYLOAD_SIZE 12
+
+// Verbindungsqualität für andere Subsysteme (Jitter-Puffer, Chunk-Größe)
+struct LinkQuality {
+    bool valid;                 // Mindestens eine RTT-Messung seit Verbindungsaufbau
+    uint32_t srttUs;            // Geglättete RTT
+    uint32_t rttVarUs;          // Mittlere Abweichung (Jitter)
+    uint32_t lastRttUs;
+    uint32_t minRttUs;
+    uint32_t rtoUs;             // SRTT + 4 * RTTVAR
+    uint8_t missedPongs;        // Unbeantwortete Pings in Folge
+    uint32_t pingsSent;
+    uint32_t pongsReceived;
+};
+
+// RTT- und Jitter-Schätzung aus WebSocket-Ping/Pong nach RFC 6298.
+// Pings kommen aus der Netzwerk-Task, getQuality() ist von überall billig.
+class LinkMonitor {
+private:
+    LinkQuality quality;
+    uint32_t lastSentSeq;
+    uint32_t lastAckedSeq;
+    mutable portMUX_TYPE mux;
+
+public:
+    LinkMonitor();
+    
+    // Neue Verbindung: Schätzung verwerfen
+    void reset();
+    
+    // Nächsten Ping vorbereiten; zählt den vorigen als verpasst, falls offen
+    size_t buildPing(uint8_t* payload, int64_t nowUs);
+    
+    // Pong auswerten; false bei fremder oder veralteter Antwort
+    bool recordPong(const uint8_t* payload, size_t length, int64_t nowUs);
+    
+    bool isPeerDead() const;
+    LinkQuality getQuality() const;
+};
+
+#endif // LINK_MONITOR_H
@@ -54,6 +54,11 @@ OtaManager::OtaManager() {
     
     // LED-Manager Referenz
     ledManager = nullptr;
+    
+    // Aufträge
+    checkRequested = false;
+    updateRequested = false;
+    requestedUrl[0] = '\0';
 }
 
 OtaManager::~OtaManager() {
@@ -90,6 +95,22 @@ void OtaManager::begin() {
 }
 
 void OtaManager::update() {
+    // Aufträge aus anderen Tasks hier ausführen, Download blockiert nur die OTA-Task
+    if (checkRequested) {
+        checkRequested = false;
+        checkForUpdates();
+    }
+    if (updateRequested) {
+        if (requestedUrl[0] != '\0') {
+            updateFromUrl(String(requestedUrl));
+        } else if (isUpdateAvailable()) {
+            startUpdate();
+        } else {
+            Serial.println("OtaManager: Kein Update verfügbar");
+        }
+        updateRequested = false;
+    }
+    
     // Auto-Update-Check
     if (autoUpdateEnabled && currentStatus == OtaStatus::IDLE) {
         unsigned long currentTime = millis();
@@ -100,6 +121,24 @@ void OtaManager::update() {
     }
 }
 
+bool OtaManager::requestCheck() {
+    if (checkRequested || currentStatus != OtaStatus::IDLE) {
+        return false;
+    }
+    checkRequested = true;
+    return true;
+}
+
+bool OtaManager::requestUpdate(const char* url) {
+    // URL erst kopieren, dann freigeben; die OTA-Task liest sie erst danach
+    if (updateRequested || currentStatus != OtaStatus::IDLE) {
+        return false;
+    }
+    strlcpy(requestedUrl, url ? url : "", sizeof(requestedUrl));
+    updateRequested = true;
+    return true;
+}
+
 // =============================================================================
 // UPDATE-SERVER-KONFIGURATION
 // =============================================================================
@@ -72,6 +72,11 @@ private:
     // LED-Manager Integration
     LedManager* ledManager;
     
+    // Aufträge aus anderen Tasks (Server-Befehle), ausgeführt in update()
+    volatile bool checkRequested;
+    volatile bool updateRequested;
+    char requestedUrl[OTA_REQUEST_URL_SIZE];    // Leer: gefundenes Update installieren
+    
     // Private Methoden
     bool downloadUpdate();
     bool installUpdate();
@@ -135,6 +140,11 @@ public:
     bool updateFromFile(const String& filename);
     bool verifyUpdate(const String& checksum);
     
+    // Nicht blockierende Aufträge, z.B. aus der Netzwerk-Task; false, wenn
+    // bereits ein Auftrag aussteht
+    bool requestCheck();
+    bool requestUpdate(const char* url);
+    
     // LED-Manager Integration
     void setLedManager(LedManager* manager);
     void processOtaCommand(const String& command);
@@ -0,0 +1,281 @@
+#include "RtpTransport.h"
+#include <esp_system.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <lwip/sockets.h>
+#include <fcntl.h>
+
+// Bytes pro Abtastwert über alle Kanäle (RTP-Zeitstempel zählt Abtastwerte)
+#define RTP_BYTES_PER_SAMPLE ((I2S_BITS_PER_SAMPLE / 8) * I2S_CHANNELS)
+
+// =============================================================================
+// KONSTRUKTOR & DESTRUKTOR
+// =============================================================================
+
+RtpTransport::RtpTransport() {
+    sock = -1;
+    active = false;
+    senders = 0;
+    payloadType = RTP_PAYLOAD_TYPE;
+    localPort = 0;
+    ssrc = 0;
+    sequence = 0;
+    timestamp = 0;
+    packetsSent = 0;
+    sendErrors = 0;
+    remoteSynced = false;
+    remoteSsrc = 0;
+    highestSequence = 0;
+    lastTransit = 0;
+    jitter = 0;
+    memset(&stats, 0, sizeof(stats));
+}
+
+RtpTransport::~RtpTransport() {
+    stop();
+}
+
+// =============================================================================
+// SITZUNG
+// =============================================================================
+
+bool RtpTransport::start(uint32_t serverAddress, uint16_t serverPort, uint8_t type) {
+    stop();
+    
+    int udp = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (udp < 0) {
+        Serial.println("RtpTransport: Fehler beim Erstellen des UDP-Sockets");
+        return false;
+    }
+    
+    // Freier lokaler Port; connect() filtert fremde Absender und erlaubt send()
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = 0;
+    socklen_t addressLength = sizeof(address);
+    if (bind(udp, (struct sockaddr*)&address, sizeof(address)) < 0 ||
+        getsockname(udp, (struct sockaddr*)&address, &addressLength) < 0) {
+        Serial.println("RtpTransport: Fehler beim Binden des UDP-Sockets");
+        close(udp);
+        return false;
+    }
+    localPort = ntohs(address.sin_port);
+    
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = serverAddress;
+    address.sin_port = htons(serverPort);
+    if (connect(udp, (struct sockaddr*)&address, sizeof(address)) < 0) {
+        Serial.println("RtpTransport: Fehler beim Verbinden des UDP-Sockets");
+        close(udp);
+        return false;
+    }
+    fcntl(udp, F_SETFL, fcntl(udp, F_GETFL, 0) | O_NONBLOCK);
+    
+    // Zufällige Startwerte (RFC 3550, 5.1)
+    ssrc = esp_random();
+    sequence = (uint16_t)esp_random();
+    timestamp = esp_random();
+    payloadType = type;
+    remoteSynced = false;
+    jitter = 0;
+    memset(&stats, 0, sizeof(stats));
+    packetsSent = 0;
+    sendErrors = 0;
+    
+    // Paket ohne Nutzdaten: der Server lernt Adresse und Port, auch hinter NAT
+    uint8_t header[RTP_HEADER_SIZE];
+    writeHeader(header, sequence.fetch_add(1), timestamp.load());
+    send(udp, header, sizeof(header), MSG_DONTWAIT);
+    
+    // Erst jetzt für sendAudio() sichtbar
+    sock = udp;
+    active = true;
+    
+    Serial.printf("RtpTransport: Audio über UDP, lokaler Port %u, Server-Port %u, SSRC %08x\n",
+                  localPort, serverPort, ssrc);
+    return true;
+}
+
+void RtpTransport::stop() {
+    if (!active && sock < 0) {
+        return;
+    }
+    active = false;
+    
+    // Sender aus anderen Tasks verlassen den Socket, bevor er geschlossen wird;
+    // sonst ginge ein Paket an einen neu vergebenen Descriptor (z.B. TCP)
+    while (senders.load() > 0) {
+        vTaskDelay(1);
+    }
+    if (sock >= 0) {
+        close(sock);
+        sock = -1;
+    }
+    Serial.printf("RtpTransport: Beendet (gesendet %u, empfangen %u, verloren %u)\n",
+                  packetsSent.load(), stats.packetsReceived, stats.packetsLost);
+}
+
+// =============================================================================
+// UPLINK
+// =============================================================================
+
+void RtpTransport::writeHeader(uint8_t* header, uint16_t seq, uint32_t ts) {
+    header[0] = RTP_VERSION << 6;
+    header[1] = payloadType & 0x7F;     // Ohne Marker, ohne CSRC
+    header[2] = seq >> 8;
+    header[3] = seq & 0xFF;
+    header[4] = ts >> 24;
+    header[5] = (ts >> 16) & 0xFF;
+    header[6] = (ts >> 8) & 0xFF;
+    header[7] = ts & 0xFF;
+    header[8] = ssrc >> 24;
+    header[9] = (ssrc >> 16) & 0xFF;
+    header[10] = (ssrc >> 8) & 0xFF;
+    header[11] = ssrc & 0xFF;
+}
+
+bool RtpTransport::sendAudio(const uint8_t* data, size_t length) {
+    // Erst anmelden, dann prüfen: stop() sieht entweder den Sender oder der
+    // Sender sieht active == false
+    senders.fetch_add(1);
+    if (!active) {
+        senders.fetch_sub(1);
+        return false;
+    }
+    
+    const size_t maxPayload = (RTP_MAX_PACKET_SIZE - RTP_HEADER_SIZE) / RTP_BYTES_PER_SAMPLE * RTP_BYTES_PER_SAMPLE;
+    bool anySent = false;
+    
+    for (size_t offset = 0; offset < length; offset += maxPayload) {
+        size_t chunk = min(maxPayload, length - offset);
+    
+        // Sequenz und Zeitstempel atomar vergeben, Header und PCM ohne Kopie
+        uint8_t header[RTP_HEADER_SIZE];
+        writeHeader(header, sequence.fetch_add(1), timestamp.fetch_add(chunk / RTP_BYTES_PER_SAMPLE));
+    
+        struct iovec parts[2];
+        parts[0].iov_base = header;
+        parts[0].iov_len = sizeof(header);
+        parts[1].iov_base = (void*)(data + offset);
+        parts[1].iov_len = chunk;
+    
+        struct msghdr message;
+        memset(&message, 0, sizeof(message));
+        message.msg_iov = parts;
+        message.msg_iovlen = 2;
+    
+        // Kein Warten: ein verlorenes Paket ist besser als ein verspätetes.
+        // Nicht abbrechen, schon gesendete Pakete dürfen nicht erneut raus.
+        if (sendmsg(sock, &message, MSG_DONTWAIT) < 0) {
+            sendErrors.fetch_add(1);
+        } else {
+            packetsSent.fetch_add(1);
+            anySent = true;
+        }
+    }
+    
+    senders.fetch_sub(1);
+    return anySent;
+}
+
+// =============================================================================
+// DOWNLINK
+// =============================================================================
+
+size_t RtpTransport::receive(const uint8_t*& payload) {
+    while (active) {
+        int length = recv(sock, rxBuffer, sizeof(rxBuffer), MSG_DONTWAIT);
+        if (length <= 0) {
+            return 0; // Nichts mehr da (oder Fehler, den select() erneut meldet)
+        }
+    
+        if (!acceptPacket(rxBuffer, length)) {
+            continue;
+        }
+    
+        // CSRC-Liste, Erweiterung und Padding überspringen
+        size_t offset = RTP_HEADER_SIZE + 4 * (rxBuffer[0] & 0x0F);
+        if ((rxBuffer[0] & 0x10) && offset + 4 <= (size_t)length) {
+            offset += 4 + 4 * ((rxBuffer[offset + 2] << 8) | rxBuffer[offset + 3]);
+        }
+        size_t end = length;
+        if ((rxBuffer[0] & 0x20) && end > offset) {
+            end -= min((size_t)rxBuffer[end - 1], end - offset);
+        }
+        if (offset >= end) {
+            continue; // Keepalive ohne Nutzdaten
+        }
+    
+        payload = rxBuffer + offset;
+        return end - offset;
+    }
+    return 0;
+}
+
+bool RtpTransport::acceptPacket(const uint8_t* packet, size_t length) {
+    if (length < RTP_HEADER_SIZE || (packet[0] >> 6) != RTP_VERSION || (packet[1] & 0x7F) != payloadType) {
+        stats.packetsInvalid++;
+        return false;
+    }
+    
+    uint16_t seq = (packet[2] << 8) | packet[3];
+    uint32_t ts = ((uint32_t)packet[4] << 24) | ((uint32_t)packet[5] << 16) | ((uint32_t)packet[6] << 8) | packet[7];
+    uint32_t packetSsrc = ((uint32_t)packet[8] << 24) | ((uint32_t)packet[9] << 16) | ((uint32_t)packet[10] << 8) | packet[11];
+    
+    // Neue SSRC (Server hat den Stream neu gestartet): neu synchronisieren
+    if (!remoteSynced || packetSsrc != remoteSsrc) {
+        remoteSynced = true;
+        remoteSsrc = packetSsrc;
+        highestSequence = seq - 1;
+        lastTransit = transitTime(ts);
+        jitter = 0;
+    }
+    
+    // Ältere oder doppelte Pakete kommen zu spät für die Wiedergabe
+    int16_t delta = (int16_t)(seq - highestSequence);
+    if (delta <= 0) {
+        stats.packetsLate++;
+        return false;
+    }
+    stats.packetsLost += delta - 1;
+    highestSequence = seq;
+    stats.packetsReceived++;
+    
+    updateJitter(ts);
+    return true;
+}
+
+uint32_t RtpTransport::transitTime(uint32_t rtpTimestamp) {
+    // Ankunftszeit in Abtastwerten minus Zeitstempel; nur Differenzen zählen,
+    // 32 Bit wie der Zeitstempel, damit der Überlauf herausfällt
+    uint32_t arrival = (uint32_t)(esp_timer_get_time() * I2S_SAMPLE_RATE / 1000000);
+    return arrival - rtpTimestamp;
+}
+
+void RtpTransport::updateJitter(uint32_t rtpTimestamp) {
+    uint32_t transit = transitTime(rtpTimestamp);
+    int32_t d = (int32_t)(transit - lastTransit);
+    lastTransit = transit;
+    if (d < 0) {
+        d = -d;
+    }
+    
+    // J += (|D| - J) / 16, mit 4 Nachkommabits (RFC 3550, A.8)
+    jitter += (uint32_t)d - ((jitter + 8) >> 4);
+    stats.jitterUs = (uint32_t)(((uint64_t)(jitter >> 4) * 1000000) / I2S_SAMPLE_RATE);
+}
+
+// =============================================================================
+// STATUS
+// =============================================================================
+
+RtpStats RtpTransport::getStats() const {
+    RtpStats result = stats;
+    result.packetsSent = packetsSent.load();
+    result.sendErrors = sendErrors.load();
+    return result;
+}
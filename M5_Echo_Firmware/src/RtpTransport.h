@@ -0,0 +1,82 @@
+#ifndef RTP_TRANSPORT_H
+#define RTP_TRANSPORT_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "config.h"
+
+// RTP-Header ohne CSRC und Erweiterungen (RFC 3550, 5.1)
+#define RTP_HEADER_SIZE      12
+#define RTP_VERSION          2
+
+// Kennzahlen beider Richtungen
+struct RtpStats {
+    uint32_t packetsSent;
+    uint32_t sendErrors;            // sendmsg() fehlgeschlagen (z.B. kein Puffer frei), Paket verloren
+    uint32_t packetsReceived;
+    uint32_t packetsLost;           // Lücken in der Sequenznummer
+    uint32_t packetsLate;           // Verspätet oder doppelt, verworfen
+    uint32_t packetsInvalid;        // Falsche Version oder Payload-Typ, zu kurz
+    uint32_t jitterUs;              // Ankunfts-Jitter nach RFC 3550, 6.4.1
+};
+
+// Audio als RTP über UDP. Ausgehandelt und gesteuert wird über den
+// WebSocket; verlorene Pakete erzeugen nur eine kurze Lücke statt eines
+// TCP-Staus. Payload ist PCM wie auf dem WebSocket (dynamischer Payload-Typ).
+class RtpTransport {
+private:
+    int sock;
+    std::atomic<bool> active;
+    std::atomic<uint32_t> senders;      // sendAudio() gerade im Socket; stop() schließt erst danach
+    uint8_t payloadType;
+    uint16_t localPort;
+    
+    // Uplink (mehrere Aufrufer möglich)
+    uint32_t ssrc;
+    std::atomic<uint16_t> sequence;
+    std::atomic<uint32_t> timestamp;    // Abtastwerte seit Start
+    std::atomic<uint32_t> packetsSent;
+    std::atomic<uint32_t> sendErrors;
+    
+    // Downlink (nur Netzwerk-Task)
+    bool remoteSynced;              // Erstes Paket hat SSRC und Sequenz festgelegt
+    uint32_t remoteSsrc;
+    uint16_t highestSequence;
+    uint32_t lastTransit;           // Ankunft minus RTP-Zeitstempel, in Abtastwerten
+    uint32_t jitter;                // In Abtastwerten, 4 Nachkommabits
+    uint8_t rxBuffer[RTP_MAX_PACKET_SIZE];
+    
+    RtpStats stats;                 // Downlink-Zähler (nur Netzwerk-Task)
+    
+    void writeHeader(uint8_t* header, uint16_t seq, uint32_t ts);
+    bool acceptPacket(const uint8_t* packet, size_t length);
+    uint32_t transitTime(uint32_t rtpTimestamp);
+    void updateJitter(uint32_t rtpTimestamp);
+
+public:
+    RtpTransport();
+    ~RtpTransport();
+    
+    // UDP-Socket auf freiem Port öffnen und mit dem Server verbinden. start()
+    // und stop() nur aus der Netzwerk-Task; stop() wartet laufende Sender ab.
+    bool start(uint32_t serverAddress, uint16_t serverPort, uint8_t payloadType);
+    void stop();
+    
+    // PCM als ein oder mehrere Pakete senden; blockiert nicht, aus jeder Task.
+    // false nur, wenn kein Paket rausging (der Block darf erneut angeboten
+    // werden); ein einzelnes fehlgeschlagenes Paket zählt als verloren.
+    bool sendAudio(const uint8_t* data, size_t length);
+    
+    // Nächstes gültiges Paket lesen; 0 = keines mehr da. Payload ist bis zum
+    // nächsten Aufruf gültig.
+    size_t receive(const uint8_t*& payload);
+    
+    bool isActive() const { return active; }
+    int getSocket() const { return sock; }
+    uint16_t getLocalPort() const { return localPort; }
+    uint32_t getSsrc() const { return ssrc; }
+    uint8_t getPayloadType() const { return payloadType; }
+    RtpStats getStats() const;
+};
+
+#endif // RTP_TRANSPORT_H
@@ -0,0 +1,399 @@
+#include "TlsTransport.h"
+#include <mbedtls/ssl_internal.h>   // handshake->resume: Fortsetzung erkennen
+#include <mbedtls/net_sockets.h>
+#include <mbedtls/error.h>
+#include <mbedtls/sha256.h>
+#include <esp_attr.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#include <lwip/sockets.h>
+
+// Session überdauert den Deep Sleep (nicht aber Stromausfall oder Reset per Taste)
+RTC_DATA_ATTR static uint8_t rtcSession[WS_TLS_SESSION_MAX_SIZE];
+RTC_DATA_ATTR static uint16_t rtcSessionLength = 0;
+RTC_DATA_ATTR static char rtcSessionHost[WS_TLS_HOST_MAX_SIZE];
+
+// AES-GCM mit SHA-256 zuerst: Blockverschlüsselung und Hashes laufen auf den
+// AES- bzw. SHA-Beschleunigern des ESP32 (CONFIG_MBEDTLS_HARDWARE_AES/SHA)
+static const int tlsCiphersuites[] = {
+    MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256,
+    MBEDTLS_TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256,
+    MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_256_GCM_SHA384,
+    MBEDTLS_TLS_ECDHE_RSA_WITH_AES_256_GCM_SHA384,
+    MBEDTLS_TLS_RSA_WITH_AES_128_GCM_SHA256,
+    0
+};
+
+// =============================================================================
+// KONSTRUKTOR & DESTRUKTOR
+// =============================================================================
+
+TlsTransport::TlsTransport() {
+    configured = false;
+    active = false;
+    connected = false;
+    sock = -1;
+    pinned = false;
+    memset(pinnedKey, 0, sizeof(pinnedKey));
+    handshakeStartUs = 0;
+    resumeOffered = false;
+    resumed = false;
+    socketUs = 0;
+    memset(&stats, 0, sizeof(stats));
+}
+
+TlsTransport::~TlsTransport() {
+    stop();
+    if (configured) {
+        mbedtls_ssl_config_free(&conf);
+        mbedtls_x509_crt_free(&caCert);
+    }
+}
+
+bool TlsTransport::begin(const char* caPem, const char* pinSha256) {
+    // Ohne Vertrauensanker wäre jeder Server im Netz akzeptiert
+    if (!caPem && !pinSha256) {
+        Serial.println("TlsTransport: Weder CA-Zertifikat noch Key-Pin, Verbindung abgelehnt");
+        return false;
+    }
+    
+    if (pinSha256) {
+        if (strlen(pinSha256) != sizeof(pinnedKey) * 2) {
+            Serial.println("TlsTransport: Key-Pin ungültig (64 Hex-Zeichen erwartet)");
+            return false;
+        }
+        for (size_t i = 0; i < sizeof(pinnedKey); i++) {
+            char byteHex[3] = { pinSha256[i * 2], pinSha256[i * 2 + 1], 0 };
+            char* end = nullptr;
+            pinnedKey[i] = (uint8_t)strtoul(byteHex, &end, 16);
+            if (end != byteHex + 2) {
+                Serial.println("TlsTransport: Key-Pin ungültig (64 Hex-Zeichen erwartet)");
+                return false;
+            }
+        }
+        pinned = true;
+    }
+    
+    mbedtls_ssl_config_init(&conf);
+    mbedtls_x509_crt_init(&caCert);
+    configured = true;
+    
+    if (mbedtls_ssl_config_defaults(&conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM,
+                                    MBEDTLS_SSL_PRESET_DEFAULT) != 0) {
+        Serial.println("TlsTransport: Fehler bei der Konfiguration");
+        return false;
+    }
+    
+    if (caPem) {
+        // PEM-Länge inklusive Nullbyte
+        if (mbedtls_x509_crt_parse(&caCert, (const unsigned char*)caPem, strlen(caPem) + 1) != 0) {
+            Serial.println("TlsTransport: CA-Zertifikat ungültig");
+            return false;
+        }
+        mbedtls_ssl_conf_ca_chain(&conf, &caCert, nullptr);
+        mbedtls_ssl_conf_authmode(&conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+    } else {
+        // Nur Pin: Kette nicht prüfbar, der Key wird nach dem Handshake verglichen
+        mbedtls_ssl_conf_authmode(&conf, MBEDTLS_SSL_VERIFY_OPTIONAL);
+    }
+    
+    mbedtls_ssl_conf_rng(&conf, random, nullptr);
+    mbedtls_ssl_conf_ciphersuites(&conf, tlsCiphersuites);
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    mbedtls_ssl_conf_session_tickets(&conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#endif
+    return true;
+}
+
+// =============================================================================
+// HANDSHAKE
+// =============================================================================
+
+bool TlsTransport::start(int socket, const char* host) {
+    if (!configured) {
+        return false;
+    }
+    stop();
+    
+    mbedtls_ssl_init(&ssl);
+    if (mbedtls_ssl_setup(&ssl, &conf) != 0 || mbedtls_ssl_set_hostname(&ssl, host) != 0) {
+        mbedtls_ssl_free(&ssl);
+        return false;
+    }
+    
+    sock = socket;
+    mbedtls_ssl_set_bio(&ssl, this, bioSend, bioRecv, nullptr);
+    active = true;
+    connected = false;
+    resumed = false;
+    loadSession(host);
+    handshakeStartUs = esp_timer_get_time();
+    return true;
+}
+
+TlsResult TlsTransport::handshake(const char* host) {
+    if (!active) {
+        return TlsResult::FAILED;
+    }
+    if (connected) {
+        return TlsResult::DONE;
+    }
+    
+    // Schrittweise wie mbedtls_ssl_handshake(), um die Fortsetzung zu erkennen;
+    // die Handshake-Parameter werden beim Abschluss freigegeben
+    while (ssl.state != MBEDTLS_SSL_HANDSHAKE_OVER) {
+        int ret = mbedtls_ssl_handshake_step(&ssl);
+        if (ssl.handshake && ssl.handshake->resume) {
+            resumed = true;
+        }
+        if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+            return TlsResult::PENDING;
+        }
+        if (ret != 0) {
+            char message[96];
+            mbedtls_strerror(ret, message, sizeof(message));
+            Serial.printf("TlsTransport: Handshake fehlgeschlagen (-0x%04x: %s)\n", -ret, message);
+            stats.failedHandshakes++;
+            return TlsResult::FAILED;
+        }
+    }
+    
+    if (pinned && !checkPinnedKey()) {
+        Serial.println("TlsTransport: Server-Key passt nicht zum Pin, Verbindung abgelehnt");
+        stats.failedHandshakes++;
+        forgetSession();
+        return TlsResult::FAILED;
+    }
+    
+    connected = true;
+    recordHandshake();
+    
+    // Auch nach einer Fortsetzung speichern, der Server kann ein neues Ticket ausstellen
+    saveSession(host);
+    return TlsResult::DONE;
+}
+
+bool TlsTransport::checkPinnedKey() {
+    // Auch bei fortgesetzten Sessions vorhanden (Server-Zertifikat liegt in der Session)
+    const mbedtls_x509_crt* peer = mbedtls_ssl_get_peer_cert(&ssl);
+    if (!peer || !peer->pk_raw.p) {
+        return false;
+    }
+    
+    uint8_t hash[sizeof(pinnedKey)];
+    if (mbedtls_sha256_ret(peer->pk_raw.p, peer->pk_raw.len, hash, 0) != 0) {
+        return false;
+    }
+    
+    // Vergleich ohne vorzeitigen Abbruch
+    uint8_t diff = 0;
+    for (size_t i = 0; i < sizeof(hash); i++) {
+        diff |= hash[i] ^ pinnedKey[i];
+    }
+    return diff == 0;
+}
+
+void TlsTransport::recordHandshake() {
+    uint32_t elapsedMs = (uint32_t)((esp_timer_get_time() - handshakeStartUs) / 1000);
+    stats.lastHandshakeMs = elapsedMs;
+    
+    if (resumed) {
+        stats.resumedHandshakes++;
+        recordAverage(stats.avgResumedHandshakeMs, stats.resumedHandshakes, elapsedMs);
+    } else {
+        stats.fullHandshakes++;
+        recordAverage(stats.avgFullHandshakeMs, stats.fullHandshakes, elapsedMs);
+    }
+    
+    Serial.printf("TlsTransport: %s Handshake in %u ms (%s%s)\n",
+                  resumed ? "Fortgesetzter" : "Vollständiger", elapsedMs,
+                  mbedtls_ssl_get_ciphersuite(&ssl),
+                  resumeOffered && !resumed ? ", Session abgelehnt" : "");
+}
+
+// =============================================================================
+// SESSION IM RTC-SPEICHER
+// =============================================================================
+
+void TlsTransport::loadSession(const char* host) {
+    resumeOffered = false;
+    if (rtcSessionLength == 0 || strncmp(rtcSessionHost, host, sizeof(rtcSessionHost)) != 0) {
+        return;
+    }
+    
+    mbedtls_ssl_session session;
+    mbedtls_ssl_session_init(&session);
+    if (mbedtls_ssl_session_load(&session, rtcSession, rtcSessionLength) == 0 &&
+        mbedtls_ssl_set_session(&ssl, &session) == 0) {
+        resumeOffered = true;
+    } else {
+        // Beschädigt oder von einer anderen mbedtls-Version
+        forgetSession();
+    }
+    mbedtls_ssl_session_free(&session);
+}
+
+void TlsTransport::saveSession(const char* host) {
+    // Erst ungültig machen: ein Reset während des Schreibens hinterlässt keine halbe Session
+    rtcSessionLength = 0;
+    
+    mbedtls_ssl_session session;
+    mbedtls_ssl_session_init(&session);
+    size_t length = 0;
+    if (mbedtls_ssl_get_session(&ssl, &session) == 0 &&
+        mbedtls_ssl_session_save(&session, rtcSession, sizeof(rtcSession), &length) == 0) {
+        strlcpy(rtcSessionHost, host, sizeof(rtcSessionHost));
+        rtcSessionLength = length;
+    } else {
+        Serial.printf("TlsTransport: Session passt nicht in den RTC-Speicher (%u Bytes)\n", length);
+    }
+    mbedtls_ssl_session_free(&session);
+}
+
+void TlsTransport::forgetSession() {
+    rtcSessionLength = 0;
+}
+
+// =============================================================================
+// DATENÜBERTRAGUNG
+// =============================================================================
+
+size_t TlsTransport::write(const uint8_t* data, size_t length) {
+    if (!connected) {
+        return 0;
+    }
+    
+    int64_t startUs = esp_timer_get_time();
+    int64_t socketStartUs = socketUs;
+    
+    // Ein Frame ergibt einen Record (bis 16 KB); Socket ist blockierend
+    size_t written = 0;
+    while (written < length) {
+        int ret = mbedtls_ssl_write(&ssl, data + written, length - written);
+        if (ret <= 0) {
+            connected = false;
+            break;
+        }
+        written += ret;
+    }
+    
+    stats.framesWritten++;
+    recordAverage(stats.avgWriteCpuUs, stats.framesWritten,
+              esp_timer_get_time() - startUs - (socketUs - socketStartUs));
+    return written;
+}
+
+int TlsTransport::read(uint8_t* buffer, size_t length) {
+    if (!connected) {
+        return -1;
+    }
+    
+    // Liegt schon entschlüsselte Nutzlast vor, wird nur kopiert
+    bool decrypts = mbedtls_ssl_get_bytes_avail(&ssl) == 0;
+    int64_t startUs = esp_timer_get_time();
+    int64_t socketStartUs = socketUs;
+    
+    int ret = mbedtls_ssl_read(&ssl, buffer, length);
+    if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+        return 0;
+    }
+    if (ret <= 0) {
+        connected = false; // close_notify oder Fehler
+        return -1;
+    }
+    
+    if (decrypts) {
+        stats.recordsRead++;
+        recordAverage(stats.avgReadCpuUs, stats.recordsRead,
+                  esp_timer_get_time() - startUs - (socketUs - socketStartUs));
+    }
+    return ret;
+}
+
+int TlsTransport::available() {
+    if (!connected) {
+        return 0;
+    }
+    
+    size_t pending = mbedtls_ssl_get_bytes_avail(&ssl);
+    if (pending > 0) {
+        return pending;
+    }
+    
+    // Nächsten Record entschlüsseln, ohne Daten zu entnehmen
+    int64_t startUs = esp_timer_get_time();
+    int64_t socketStartUs = socketUs;
+    int ret = mbedtls_ssl_read(&ssl, nullptr, 0);
+    if (ret < 0 && ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+        connected = false;
+        return 0;
+    }
+    
+    pending = mbedtls_ssl_get_bytes_avail(&ssl);
+    if (pending > 0) {
+        stats.recordsRead++;
+        recordAverage(stats.avgReadCpuUs, stats.recordsRead,
+                  esp_timer_get_time() - startUs - (socketUs - socketStartUs));
+    }
+    return pending;
+}
+
+void TlsTransport::stop() {
+    // Ohne close_notify: bei toter Verbindung würde das Senden blockieren
+    if (active) {
+        mbedtls_ssl_free(&ssl);
+        active = false;
+    }
+    connected = false;
+    sock = -1;
+}
+
+// =============================================================================
+// SOCKET UND ZUFALL
+// =============================================================================
+
+int TlsTransport::bioSend(void* context, const unsigned char* data, size_t length) {
+    TlsTransport* transport = (TlsTransport*)context;
+    int64_t startUs = esp_timer_get_time();
+    int sent = send(transport->sock, data, length, 0);
+    transport->socketUs += esp_timer_get_time() - startUs;
+    
+    if (sent < 0) {
+        return (errno == EAGAIN || errno == EWOULDBLOCK) ? MBEDTLS_ERR_SSL_WANT_WRITE : MBEDTLS_ERR_NET_SEND_FAILED;
+    }
+    return sent;
+}
+
+int TlsTransport::bioRecv(void* context, unsigned char* data, size_t length) {
+    TlsTransport* transport = (TlsTransport*)context;
+    int64_t startUs = esp_timer_get_time();
+    
+    // Nie blockieren: fehlende Daten meldet select() auf dem Socket
+    int received = recv(transport->sock, data, length, MSG_DONTWAIT);
+    transport->socketUs += esp_timer_get_time() - startUs;
+    
+    if (received < 0) {
+        return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+            ? MBEDTLS_ERR_SSL_WANT_READ : MBEDTLS_ERR_NET_RECV_FAILED;
+    }
+    return received;
+}
+
+int TlsTransport::random(void* context, unsigned char* output, size_t length) {
+    // Hardware-Zufallsgenerator; bei aktivem WLAN echte Zufallszahlen
+    esp_fill_random(output, length);
+    return 0;
+}
+
+// =============================================================================
+// STATUS
+// =============================================================================
+
+void TlsTransport::recordAverage(uint32_t& average, uint32_t count, int64_t value) {
+    uint32_t sample = value > 0 ? (uint32_t)value : 0;
+    average = count == 1 ? sample : average + ((int32_t)(sample - average) >> 3);
+}
+
+TlsStats TlsTransport::getStats() const {
+    return stats;
+}
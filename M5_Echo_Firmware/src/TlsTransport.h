@@ -0,0 +1,96 @@
+#ifndef TLS_TRANSPORT_H
+#define TLS_TRANSPORT_H
+
+#include <Arduino.h>
+#include <mbedtls/ssl.h>
+#include <mbedtls/x509_crt.h>
+#include "config.h"
+
+// Zusatzbytes je Record mit AES-GCM: 5 Header, 8 expliziter Nonce, 16 Tag
+#define TLS_RECORD_OVERHEAD  29
+
+// Ergebnis eines Handshake-Schritts
+enum class TlsResult {
+    DONE,           // Handshake abgeschlossen
+    PENDING,        // Warten auf Daten vom Server (Socket lesbar)
+    FAILED
+};
+
+// Handshake-Zeiten und Verschlüsselungsaufwand
+struct TlsStats {
+    uint32_t fullHandshakes;
+    uint32_t resumedHandshakes;     // Per Session-Ticket bzw. Session-ID
+    uint32_t failedHandshakes;
+    uint32_t lastHandshakeMs;       // TCP verbunden bis Handshake fertig
+    uint32_t avgFullHandshakeMs;    // Geglättet
+    uint32_t avgResumedHandshakeMs;
+    uint32_t framesWritten;
+    uint32_t recordsRead;
+    uint32_t avgWriteCpuUs;         // Verschlüsseln je Frame, ohne Zeit im Socket
+    uint32_t avgReadCpuUs;          // Entschlüsseln je Record, ohne Zeit im Socket
+};
+
+// TLS über einen bereits verbundenen Socket (mbedtls). Der Handshake läuft
+// schrittweise in der Netzwerk-Task, Lesen blockiert nie. Die Session wird
+// im RTC-Speicher abgelegt und nach dem Deep Sleep wieder angeboten.
+class TlsTransport {
+private:
+    mbedtls_ssl_context ssl;
+    mbedtls_ssl_config conf;
+    mbedtls_x509_crt caCert;
+    uint8_t pinnedKey[32];          // SHA-256 des Server-Public-Keys (SubjectPublicKeyInfo)
+    bool pinned;
+    bool configured;
+    bool active;
+    bool connected;                 // Handshake abgeschlossen
+    int sock;
+    
+    // Handshake
+    int64_t handshakeStartUs;
+    bool resumeOffered;
+    bool resumed;
+    
+    // Zeit im Socket, wird von der Messung der Verschlüsselung abgezogen
+    int64_t socketUs;
+    TlsStats stats;
+    
+    static int bioSend(void* context, const unsigned char* data, size_t length);
+    static int bioRecv(void* context, unsigned char* data, size_t length);
+    static int random(void* context, unsigned char* output, size_t length);
+    
+    void loadSession(const char* host);
+    void saveSession(const char* host);
+    static void forgetSession();
+    void recordHandshake();
+    bool checkPinnedKey();
+    static void recordAverage(uint32_t& average, uint32_t count, int64_t value);
+
+public:
+    TlsTransport();
+    ~TlsTransport();
+    
+    // Einmalige Konfiguration; caCert = PEM der Server-CA, pinSha256 = SHA-256 des
+    // Server-Public-Keys (64 Hex-Zeichen). Mindestens eines muss gesetzt sein,
+    // ohne Vertrauensanker schlägt begin() fehl.
+    bool begin(const char* caCert, const char* pinSha256);
+    
+    // Neue Verbindung auf sock; bietet eine gespeicherte Session an
+    bool start(int sock, const char* host);
+    
+    // Handshake fortsetzen, sobald der Socket lesbar ist
+    TlsResult handshake(const char* host);
+    
+    // Wie WiFiClient: write() schreibt alles oder meldet weniger, read()/available() blockieren nicht
+    size_t write(const uint8_t* data, size_t length);
+    int read(uint8_t* buffer, size_t length);
+    int available();
+    
+    // Verbindungszustand freigeben (Socket schließt der Besitzer)
+    void stop();
+    
+    bool isActive() const { return active; }
+    bool isConnected() const { return connected; }
+    TlsStats getStats() const;
+};
+
+#endif // TLS_TRANSPORT_H
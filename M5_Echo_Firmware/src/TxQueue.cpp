@@ -0,0 +1,267 @@
+#include "TxQueue.h"
+#include <esp_timer.h>
+#include <new>
+
+// =============================================================================
+// KONSTRUKTOR & DESTRUKTOR
+// =============================================================================
+
+TxQueue::TxQueue() {
+    slots = nullptr;
+    slotData = nullptr;
+    slotSize = 0;
+    mask = 0;
+    policy = TxPolicy::BLOCK;
+    enqueuePos = 0;
+    dequeuePos = 0;
+    enqueuedCount = 0;
+    droppedCount = 0;
+    rejectedCount = 0;
+    maxDepth = 0;
+    sentCount = 0;
+    avgLatencyUs = 0;
+    maxLatencyUs = 0;
+}
+
+TxQueue::~TxQueue() {
+    end();
+}
+
+bool TxQueue::begin(size_t capacity, TxPolicy queuePolicy, size_t size) {
+    if (capacity < 2 || (capacity & (capacity - 1)) != 0) {
+        Serial.println("TxQueue: Kapazität muss eine Zweierpotenz sein");
+        return false;
+    }
+    
+    // Verwaltung und Nutzdaten getrennt, damit jede Queue ihre eigene Slot-Größe hat
+    slots = (TxSlot*)malloc(capacity * sizeof(TxSlot));
+    slotData = (uint8_t*)malloc(capacity * size);
+    if (!slots || !slotData) {
+        Serial.println("TxQueue: Fehler beim Allozieren der Slots");
+        end();
+        return false;
+    }
+    
+    // Slot i ist frei für Einreihung Nummer i
+    for (size_t i = 0; i < capacity; i++) {
+        new (&slots[i].sequence) std::atomic<uint32_t>(i);
+        slots[i].data = slotData + i * size;
+    }
+    slotSize = size;
+    mask = capacity - 1;
+    policy = queuePolicy;
+    enqueuePos = 0;
+    dequeuePos = 0;
+    return true;
+}
+
+void TxQueue::end() {
+    if (slots) {
+        free(slots);
+        slots = nullptr;
+    }
+    if (slotData) {
+        free(slotData);
+        slotData = nullptr;
+    }
+}
+
+// =============================================================================
+// EINREIHEN
+// =============================================================================
+
+TxSlot* TxQueue::tryReserve(uint32_t& ticket) {
+    uint32_t pos = enqueuePos.load(std::memory_order_relaxed);
+    
+    while (true) {
+        TxSlot* slot = &slots[pos & mask];
+        uint32_t seq = slot->sequence.load(std::memory_order_acquire);
+        int32_t diff = (int32_t)(seq - pos);
+    
+        if (diff == 0) {
+            // Slot frei: Position beanspruchen
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                ticket = pos;
+                return slot;
+            }
+        } else if (diff < 0) {
+            return nullptr; // Voll
+        } else {
+            pos = enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool TxQueue::push(uint8_t opcode, const uint8_t* data, size_t length) {
+    if (length > slotSize) {
+        rejectedCount++;
+        return false;
+    }
+    
+    uint32_t ticket;
+    TxSlot* slot = reserve(ticket);
+    if (!slot) {
+        return false;
+    }
+    
+    memcpy(slot->data, data, length);
+    commit(slot, ticket, opcode, length);
+    return true;
+}
+
+TxSlot* TxQueue::reserve(uint32_t& ticket) {
+    if (!slots) {
+        rejectedCount++;
+        return nullptr;
+    }
+    
+    TxSlot* slot = tryReserve(ticket);
+    
+    // Voll: bei DROP_OLDEST Platz schaffen. Begrenzt, da andere Produzenten
+    // den frei gewordenen Slot schneller belegen können.
+    for (uint32_t attempt = 0; !slot && policy == TxPolicy::DROP_OLDEST && attempt <= mask; attempt++) {
+        uint32_t oldTicket;
+        TxSlot* oldest = acquire(oldTicket);
+        if (oldest) {
+            release(oldest, oldTicket);
+            droppedCount++;
+        }
+        slot = tryReserve(ticket);
+    }
+    
+    if (!slot && policy == TxPolicy::REJECT) {
+        rejectedCount++;
+    }
+    return slot;
+}
+
+void TxQueue::commit(TxSlot* slot, uint32_t ticket, uint8_t opcode, size_t length) {
+    slot->opcode = opcode;
+    slot->length = length;
+    slot->enqueueUs = esp_timer_get_time();
+    
+    // Für den Sender sichtbar machen
+    slot->sequence.store(ticket + 1, std::memory_order_release);
+    enqueuedCount++;
+    
+    uint32_t depth = getDepth();
+    uint32_t peak = maxDepth.load(std::memory_order_relaxed);
+    while (depth > peak && !maxDepth.compare_exchange_weak(peak, depth, std::memory_order_relaxed)) {
+    }
+}
+
+// =============================================================================
+// ENTNEHMEN
+// =============================================================================
+
+TxSlot* TxQueue::acquire(uint32_t& ticket) {
+    if (!slots) {
+        return nullptr;
+    }
+    
+    uint32_t pos = dequeuePos.load(std::memory_order_relaxed);
+    
+    while (true) {
+        TxSlot* slot = &slots[pos & mask];
+        uint32_t seq = slot->sequence.load(std::memory_order_acquire);
+        int32_t diff = (int32_t)(seq - (pos + 1));
+    
+        if (diff == 0) {
+            if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                ticket = pos;
+                return slot;
+            }
+        } else if (diff < 0) {
+            return nullptr; // Leer
+        } else {
+            pos = dequeuePos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void TxQueue::release(TxSlot* slot, uint32_t ticket) {
+    // Slot für die Einreihung eine Runde später freigeben
+    slot->sequence.store(ticket + mask + 1, std::memory_order_release);
+}
+
+void TxQueue::recordSent(int64_t enqueueUs) {
+    uint32_t latencyUs = (uint32_t)(esp_timer_get_time() - enqueueUs);
+    
+    sentCount = sentCount + 1;
+    avgLatencyUs = sentCount == 1 ? latencyUs : avgLatencyUs + ((int32_t)(latencyUs - avgLatencyUs) >> 3);
+    if (latencyUs > maxLatencyUs) {
+        maxLatencyUs = latencyUs;
+    }
+}
+
+void TxQueue::recordDropped() {
+    droppedCount++;
+}
+
+void TxQueue::recordRejected() {
+    rejectedCount++;
+}
+
+void TxQueue::clear() {
+    uint32_t ticket;
+    TxSlot* slot;
+    while ((slot = acquire(ticket)) != nullptr) {
+        release(slot, ticket);
+        droppedCount++;
+    }
+}
+
+// =============================================================================
+// STATUS
+// =============================================================================
+
+TxPolicy TxQueue::getPolicy() const {
+    return policy;
+}
+
+size_t TxQueue::getSlotSize() const {
+    return slotSize;
+}
+
+uint32_t TxQueue::getCapacity() const {
+    return slots ? mask + 1 : 0;
+}
+
+bool TxQueue::isEmpty() const {
+    return getDepth() == 0;
+}
+
+uint32_t TxQueue::getDepth() const {
+    uint32_t head = dequeuePos.load(std::memory_order_relaxed);
+    uint32_t tail = enqueuePos.load(std::memory_order_relaxed);
+    // Momentaufnahme; reservierte, noch nicht gefüllte Slots zählen mit
+    return (int32_t)(tail - head) > 0 ? tail - head : 0;
+}
+
+uint32_t TxQueue::getFreeSlots() const {
+    if (!slots) {
+        return 0;
+    }
+    
+    // Nach den Sequenzen, nicht nach dequeuePos: der Sender gibt einen Slot
+    // erst nach dem Schreiben in den Socket frei (release)
+    uint32_t pos = enqueuePos.load(std::memory_order_relaxed);
+    uint32_t free = 0;
+    while (free <= mask && slots[(pos + free) & mask].sequence.load(std::memory_order_acquire) == pos + free) {
+        free++;
+    }
+    return free;
+}
+
+TxQueueStats TxQueue::getStats() const {
+    TxQueueStats stats;
+    stats.depth = getDepth();
+    stats.maxDepth = maxDepth.load(std::memory_order_relaxed);
+    stats.enqueued = enqueuedCount.load(std::memory_order_relaxed);
+    stats.sent = sentCount;
+    stats.dropped = droppedCount.load(std::memory_order_relaxed);
+    stats.rejected = rejectedCount.load(std::memory_order_relaxed);
+    stats.avgLatencyUs = avgLatencyUs;
+    stats.maxLatencyUs = maxLatencyUs;
+    return stats;
+}
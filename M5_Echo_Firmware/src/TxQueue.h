@@ -0,0 +1,98 @@
+#ifndef TX_QUEUE_H
+#define TX_QUEUE_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "config.h"
+
+// Verhalten bei voller Queue
+enum class TxPolicy : uint8_t {
+    BLOCK,          // Aufrufer wartet, solange der Sender leert (Steuer-Nachrichten)
+    DROP_OLDEST,    // Ältesten Eintrag verwerfen, neuer Eintrag gewinnt
+    REJECT          // Ablehnen, Aufrufer weicht aus (Audio -> ADPCM-Pre-Roll)
+};
+
+// Ein Frame in der Queue, Nutzdaten werden beim Einreihen kopiert
+struct TxSlot {
+    std::atomic<uint32_t> sequence;
+    uint8_t opcode;
+    uint16_t length;
+    int64_t enqueueUs;
+    uint8_t* data;              // slotSize Bytes im Datenblock der Queue
+};
+
+// Kennzahlen einer Queue
+struct TxQueueStats {
+    uint32_t depth;             // Aktuell eingereihte Frames
+    uint32_t maxDepth;          // Höchststand seit Start
+    uint32_t enqueued;
+    uint32_t sent;
+    uint32_t dropped;           // Verworfen (DROP_OLDEST, Verbindungsabbruch)
+    uint32_t rejected;          // Abgelehnt (REJECT, zu groß)
+    uint32_t avgLatencyUs;      // Einreihen bis Socket, geglättet
+    uint32_t maxLatencyUs;
+};
+
+// Begrenzte lock-freie MPMC-Queue (Vyukov). Mehrere Tasks reihen ein,
+// der Sender entnimmt; bei DROP_OLDEST entnehmen auch die Produzenten.
+class TxQueue {
+private:
+    TxSlot* slots;
+    uint8_t* slotData;
+    size_t slotSize;
+    uint32_t mask;
+    TxPolicy policy;
+    std::atomic<uint32_t> enqueuePos;
+    std::atomic<uint32_t> dequeuePos;
+    
+    // Zähler (mehrere Schreiber)
+    std::atomic<uint32_t> enqueuedCount;
+    std::atomic<uint32_t> droppedCount;
+    std::atomic<uint32_t> rejectedCount;
+    std::atomic<uint32_t> maxDepth;
+    
+    // Nur vom Sender geschrieben
+    volatile uint32_t sentCount;
+    volatile uint32_t avgLatencyUs;
+    volatile uint32_t maxLatencyUs;
+    
+    TxSlot* tryReserve(uint32_t& ticket);
+
+public:
+    TxQueue();
+    ~TxQueue();
+    
+    // capacity muss eine Zweierpotenz sein; slotSize = größter Frame
+    bool begin(size_t capacity, TxPolicy policy, size_t slotSize = WS_TX_SLOT_SIZE);
+    void end();
+    
+    // Einreihen nach Policy; false bei voller Queue (BLOCK/REJECT) oder zu großem Frame
+    bool push(uint8_t opcode, const uint8_t* data, size_t length);
+    
+    // Slot nach Policy reservieren und an Ort und Stelle füllen (ohne Kopie);
+    // jede Reservierung muss mit commit() abgeschlossen werden, length 0 = verwerfen
+    TxSlot* reserve(uint32_t& ticket);
+    void commit(TxSlot* slot, uint32_t ticket, uint8_t opcode, size_t length);
+    
+    // Ältesten Frame entnehmen; nach dem Senden mit release() freigeben
+    TxSlot* acquire(uint32_t& ticket);
+    void release(TxSlot* slot, uint32_t ticket);
+    
+    // Nach dem Senden: Latenz erfassen bzw. Fehlschlag zählen
+    void recordSent(int64_t enqueueUs);
+    void recordDropped();
+    void recordRejected();
+    
+    // Alle Frames verwerfen (Verbindungsabbruch)
+    void clear();
+    
+    TxPolicy getPolicy() const;
+    size_t getSlotSize() const;
+    uint32_t getCapacity() const;
+    bool isEmpty() const;
+    uint32_t getDepth() const;
+    uint32_t getFreeSlots() const;  // Sofort einreihbar; ein entnommener, noch nicht freigegebener Slot zählt nicht
+    TxQueueStats getStats() const;
+};
+
+#endif // TX_QUEUE_H
@@ -1,10 +1,51 @@
 #include "WebSocketClient.h"
+#include "CommandRegistry.h"
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 #include <freertos/queue.h>
 #include <freertos/semphr.h>
 #include <WiFiClient.h>
-#include "AudioManager.h"  // Für AudioChunk-Definition
+#include <sys/select.h>
+#include <unistd.h>
+#include <esp_timer.h>
+#include <esp_vfs_eventfd.h>
+#include <lwip/sockets.h>
+#include <mbedtls/sha1.h>
+#include <mbedtls/base64.h>
+#include <WiFi.h>
+#include <esp_attr.h>
+#include <esp_sleep.h>
+#include "AudioManager.h"  // Für PlayoutReservation und Downlink-Pfad
+
+// Verbindungs-Snapshot, überdauert den Deep Sleep (nicht aber Stromausfall)
+#define SNAPSHOT_MAGIC       0x57534E50
+#define WS_KEY_LENGTH        24     // Base64 von 16 Bytes
+#define WS_KEY_PLACEHOLDER   "AAAAAAAAAAAAAAAAAAAAAA=="
+
+struct ConnectionSnapshot {
+    uint32_t magic;
+    uint32_t serverAddress;         // Vor dem Deep Sleep aufgelöst
+    uint16_t serverPort;
+    char host[WS_TLS_HOST_MAX_SIZE];    // Für Host-Header und TLS
+    bool tls;
+    bool pipelining;                // Vom Server zugesagt (session)
+    bool resume;                    // Hello ist resume statt identification
+    uint32_t uplinkSeq;
+    char token[WS_SNAPSHOT_TOKEN_SIZE];
+    uint16_t keyOffset;             // Position des Sec-WebSocket-Key in der Anfrage
+    uint16_t upgradeLength;
+    char upgrade[WS_SNAPSHOT_UPGRADE_SIZE];
+    uint16_t helloLength;
+    char hello[WS_SNAPSHOT_HELLO_SIZE];
+};
+
+// wss:// ab Werk nur mit Vertrauensanker, sonst wäre der Server ungeprüft
+static_assert(!DEFAULT_SERVER_TLS || WS_TLS_CA_CERT != nullptr || WS_TLS_PIN_SHA256 != nullptr,
+              "DEFAULT_SERVER_TLS verlangt WS_TLS_CA_CERT oder WS_TLS_PIN_SHA256");
+
+RTC_DATA_ATTR static ConnectionSnapshot rtcSnapshot;
+RTC_DATA_ATTR static uint32_t rtcLastFirstUplinkUs = 0;
+RTC_DATA_ATTR static bool rtcLastSnapshot = false;
 
 // =============================================================================
 // KONSTRUKTOR & DESTRUKTOR
@@ -12,6 +53,14 @@
 
 WebSocketClient::WebSocketClient() {
     wifiClient = nullptr;
+    tlsEnabled = DEFAULT_SERVER_TLS;
+    tlsCaCert = WS_TLS_CA_CERT;
+    tlsPinSha256 = WS_TLS_PIN_SHA256;
+    serverIp = 0;
+    serverAddressHint = 0;
+    pendingServer = false;
+    pendingServerPort = 0;
+    pendingServerAddress = 0;
     currentStatus = WebSocketStatus::DISCONNECTED;
     
     // Server-Konfiguration
@@ -23,9 +72,27 @@ WebSocketClient::WebSocketClient() {
     // Verbindungsverwaltung
     lastReconnectAttempt = 0;
     lastHeartbeat = 0;
+    lastPingTime = 0;
     reconnectAttempts = 0;
+    reconnectDelay = 0;
     autoReconnect = true;
     
+    // Sitzung
+    sessionToken = "";
+    resumePending = false;
+    uplinkSeq = 0;
+    linkDownTime = 0;
+    streamResumePending = false;
+    memset(&reconnectStats, 0, sizeof(reconnectStats));
+    
+    // Schnellweg nach dem Deep Sleep
+    serverPipelining = false;
+    snapshotArmed = false;
+    earlyData = false;
+    memset(&wakeTiming, 0, sizeof(wakeTiming));
+    wakeTiming.previousFirstUplinkUs = rtcLastFirstUplinkUs;
+    wakeTiming.previousSnapshot = rtcLastSnapshot;
+    
     // Callback-Funktionen
     eventCallback = nullptr;
     messageCallback = nullptr;
@@ -37,8 +104,8 @@ WebSocketClient::WebSocketClient() {
     
     // FreeRTOS-Tasks und Synchronisation
     webSocketTaskHandle = nullptr;
+    txEventFd = -1;
     messageQueue = nullptr;
-    audioQueue = nullptr;
     webSocketMutex = nullptr;
     
     // Debug
@@ -49,7 +116,32 @@ WebSocketClient::WebSocketClient() {
     // WebSocket-spezifische Variablen
     frameBuffer = nullptr;
     frameBufferSize = 0;
+    txBuffer = nullptr;
     wsConnected = false;
+    tlvRx = false;
+    tlvTx = false;
+    schedIndex = 0;
+    schedCredit = WS_SCHED_WEIGHT_AUDIO;
+    FrameCallbacks frameCallbacks = { this, onMessageBegin, onMessageData, onMessageEnd,
+                                      onControlFrame, onProtocolError };
+    parser.setCallbacks(frameCallbacks);
+    resetFrameParser();
+    connectPhase = ConnectPhase::NONE;
+    connectRequested = false;
+    connectSocket = -1;
+    connectStartTime = 0;
+    handshakeMatch = 0;
+    memset(&loopStats, 0, sizeof(loopStats));
+    rxWakeUs = 0;
+    
+    // Manager-Integration
+    audioManager = nullptr;
+    commandRegistry = nullptr;
+    
+    // Downlink-Flusskontrolle
+    lastCreditLimit = 0;
+    lastCreditDrops = 0;
+    lastCreditTime = 0;
 }
 
 WebSocketClient::~WebSocketClient() {
@@ -58,16 +150,16 @@ WebSocketClient::~WebSocketClient() {
         vTaskDelete(webSocketTaskHandle);
         webSocketTaskHandle = nullptr;
     }
+    if (txEventFd >= 0) {
+        close(txEventFd);
+        txEventFd = -1;
+    }
     
     // Queues löschen
     if (messageQueue) {
         vQueueDelete(messageQueue);
         messageQueue = nullptr;
     }
-    if (audioQueue) {
-        vQueueDelete(audioQueue);
-        audioQueue = nullptr;
-    }
     
     // Mutex löschen
     if (webSocketMutex) {
@@ -86,6 +178,10 @@ WebSocketClient::~WebSocketClient() {
         free(frameBuffer);
         frameBuffer = nullptr;
     }
+    if (txBuffer) {
+        free(txBuffer);
+        txBuffer = nullptr;
+    }
 }
 
 // =============================================================================
@@ -109,24 +205,47 @@ void WebSocketClient::begin() {
         return;
     }
     
-    // Frame-Buffer allozieren
-    frameBufferSize = 4096;
+    // TLS-Konfiguration einmalig, jede Verbindung setzt darauf auf
+    if (tlsEnabled && !tls.begin(tlsCaCert, tlsPinSha256)) {
+        Serial.println("WebSocketClient: Fehler bei der TLS-Konfiguration");
+        return;
+    }
+    
+    // Frame-Buffer allozieren (Empfangspuffer für Bulk-Reads)
+    frameBufferSize = WS_BUFFER_SIZE;
     frameBuffer = (uint8_t*)malloc(frameBufferSize);
-    if (!frameBuffer) {
+    txBuffer = (uint8_t*)malloc(WS_TX_BUFFER_SIZE);
+    if (!frameBuffer || !txBuffer) {
         Serial.println("WebSocketClient: Fehler beim Allozieren des Frame-Buffers");
         return;
     }
     
     // Queues erstellen
     messageQueue = xQueueCreate(20, sizeof(WebSocketMessage));
-    audioQueue = xQueueCreate(10, sizeof(AudioChunk));
     
-    if (!messageQueue || !audioQueue) {
+    if (!messageQueue ||
+        !controlTx.begin(WS_TX_CONTROL_SLOTS, TxPolicy::BLOCK) ||
+        !audioTx.begin(WS_TX_AUDIO_SLOTS, WS_TX_AUDIO_POLICY, WS_PACKETIZER_MAX_BYTES) ||
+        !telemetryTx.begin(WS_TX_TELEMETRY_SLOTS, TxPolicy::DROP_OLDEST) ||
+        !bulkTx.begin(WS_TX_BULK_SLOTS, TxPolicy::REJECT) ||
+        !audioPacketizer.begin(&audioTx, WS_OPCODE_BINARY)) {
         Serial.println("WebSocketClient: Fehler beim Erstellen der Queues");
         return;
     }
     
-    // WebSocket-Task starten
+    // eventfd, damit Sendeaufträge das select() der Task beenden. Ohne
+    // eventfd fällt die Task auf kurze Timeouts zurück.
+    esp_vfs_eventfd_config_t eventfdConfig = ESP_VFS_EVENTD_CONFIG_DEFAULT();
+    esp_err_t err = esp_vfs_eventfd_register(&eventfdConfig);
+    if (err == ESP_OK || err == ESP_ERR_INVALID_STATE) {
+        txEventFd = eventfd(0, 0);
+    }
+    if (txEventFd < 0) {
+        Serial.println("WebSocketClient: eventfd nicht verfügbar, Senden per Timeout");
+    }
+    
+    // WebSocket-Task starten: einziger Schreiber auf den Socket für
+    // Nachrichten und Audio, wartet in select() auf Socket und Sendeaufträge
     BaseType_t result = xTaskCreatePinnedToCore(
         webSocketTask,
         "WebSocketTask",
@@ -147,19 +266,23 @@ void WebSocketClient::begin() {
 }
 
 void WebSocketClient::update() {
-    // Automatische Wiederverbindung
-    if (autoReconnect && currentStatus == WebSocketStatus::DISCONNECTED) {
+    // Server hat die TCP-Verbindung ohne Close-Frame beendet
+    if (currentStatus == WebSocketStatus::CONNECTED && wsConnected && !transportConnected()) {
+        lastError = "Verbindung vom Server geschlossen";
+        disconnect();
+    }
+    
+    // Automatische Wiederverbindung mit exponentiellem Backoff, ohne aufzugeben
+    if (autoReconnect && (currentStatus == WebSocketStatus::DISCONNECTED || currentStatus == WebSocketStatus::ERROR) &&
+        WiFi.isConnected()) {
         unsigned long currentTime = millis();
-        if (currentTime - lastReconnectAttempt > WS_RECONNECT_INTERVAL) {
-            if (reconnectAttempts < 5) {
-                Serial.println("WebSocketClient: Automatische Wiederverbindung...");
-                connect();
-                reconnectAttempts++;
-            } else {
-                Serial.println("WebSocketClient: Maximale Reconnect-Versuche erreicht");
-                currentStatus = WebSocketStatus::ERROR;
-            }
+        if (currentTime - lastReconnectAttempt >= reconnectDelay) {
+            reconnectAttempts++;
+            reconnectDelay = backoffDelay(reconnectAttempts);
             lastReconnectAttempt = currentTime;
+            Serial.printf("WebSocketClient: Automatische Wiederverbindung (Versuch %d, danach %lu ms)\n",
+                          reconnectAttempts, reconnectDelay);
+            connect();
         }
     }
     
@@ -171,6 +294,21 @@ void WebSocketClient::update() {
             lastHeartbeat = currentTime;
         }
     }
+    
+    // Protokoll-Ping: RTT messen und tote Gegenstelle erkennen
+    if (currentStatus == WebSocketStatus::CONNECTED) {
+        unsigned long currentTime = millis();
+        if (currentTime - lastPingTime >= WS_PING_INTERVAL_MS) {
+            lastPingTime = currentTime;
+            sendPing();
+            
+            if (linkMonitor.isPeerDead()) {
+                Serial.printf("WebSocketClient: %d Pongs ausgeblieben, Verbindung tot\n", WS_PONG_MAX_MISSED);
+                lastError = "Keine Pong-Antwort";
+                disconnect();
+            }
+        }
+    }
 }
 
 // =============================================================================
@@ -178,66 +316,85 @@ void WebSocketClient::update() {
 // =============================================================================
 
 bool WebSocketClient::connect(const String& host, int port) {
+    return connect(host, port, IPAddress((uint32_t)0));
+}
+
+bool WebSocketClient::connect(const String& host, int port, const IPAddress& address) {
     if (xSemaphoreTake(webSocketMutex, pdMS_TO_TICKS(100)) != pdTRUE) {
         return false;
     }
     
-    serverHost = host;
-    serverPort = port;
-    serverUrl = "ws://" + host + ":" + String(port);
+    requestConnectLocked(host, port, (uint32_t)address);
+    
+    xSemaphoreGive(webSocketMutex);
+    wakeNetworkTask();
+    return true;
+}
+
+bool WebSocketClient::connect() {
+    if (xSemaphoreTake(webSocketMutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+        return false;
+    }
     
-    Serial.printf("WebSocketClient: Verbinde mit %s...\n", serverUrl.c_str());
+    // Zwischenzeitlich per DNS-SD gefundener Server gilt ab diesem Versuch
+    if (pendingServer) {
+        pendingServer = false;
+        requestConnectLocked(pendingServerHost, pendingServerPort, pendingServerAddress);
+    } else {
+        requestConnectLocked(serverHost, serverPort, serverAddressHint);
+    }
     
-    currentStatus = WebSocketStatus::CONNECTING;
+    xSemaphoreGive(webSocketMutex);
+    wakeNetworkTask();
+    return true;
+}
+
+bool WebSocketClient::useDiscoveredServer(const String& host, int port, const IPAddress& address) {
+    if (xSemaphoreTake(webSocketMutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+        return false;
+    }
     
-    // TCP-Verbindung herstellen
-    if (!wifiClient->connect(host.c_str(), port)) {
-        Serial.println("WebSocketClient: TCP-Verbindung fehlgeschlagen");
-        currentStatus = WebSocketStatus::ERROR;
+    // Bestehende oder laufende Verbindung nicht abreißen, nur für den nächsten Versuch merken
+    if (currentStatus != WebSocketStatus::DISCONNECTED && currentStatus != WebSocketStatus::ERROR) {
+        pendingServerHost = host;
+        pendingServerPort = port;
+        pendingServerAddress = (uint32_t)address;
+        pendingServer = true;
         xSemaphoreGive(webSocketMutex);
+        Serial.printf("WebSocketClient: Server %s:%d gefunden, gilt ab dem nächsten Verbindungsversuch\n", host.c_str(), port);
         return false;
     }
     
-    // WebSocket-Handshake senden
-    String handshake = createWebSocketHandshake();
-    wifiClient->print(handshake);
-    
-    // Handshake-Antwort lesen
-    String response = "";
-    unsigned long timeout = millis() + 5000; // 5 Sekunden Timeout
+    pendingServer = false;
+    requestConnectLocked(host, port, (uint32_t)address);
     
-    while (millis() < timeout && !response.endsWith("\r\n\r\n")) {
-        if (wifiClient->available()) {
-            response += (char)wifiClient->read();
-        }
-        delay(1);
+    xSemaphoreGive(webSocketMutex);
+    wakeNetworkTask();
+    return true;
+}
+
+// Aufrufer hält webSocketMutex
+void WebSocketClient::requestConnectLocked(const String& host, int port, uint32_t address) {
+    // Anderer Server als im Snapshot: normaler Aufbau
+    if (host != serverHost || port != serverPort) {
+        snapshotArmed = false;
     }
+    serverHost = host;
+    serverPort = port;
+    serverAddressHint = address;
+    serverUrl = String(tlsEnabled ? "wss://" : "ws://") + host + ":" + String(port);
     
-    if (response.indexOf("101 Switching Protocols") > 0) {
-        Serial.println("WebSocketClient: WebSocket-Handshake erfolgreich");
-        currentStatus = WebSocketStatus::CONNECTED;
-        wsConnected = true;
-        reconnectAttempts = 0;
-        lastActivity = millis();
-        
-        // Identifikation senden
-        sendIdentification();
-        
-        if (eventCallback) {
-            eventCallback(WebSocketStatus::CONNECTED);
-        }
+    if (serverAddressHint != 0) {
+        Serial.printf("WebSocketClient: Verbinde mit %s (%s)...\n", serverUrl.c_str(), IPAddress(address).toString().c_str());
     } else {
-        Serial.println("WebSocketClient: WebSocket-Handshake fehlgeschlagen");
-        currentStatus = WebSocketStatus::ERROR;
-        wifiClient->stop();
+        Serial.printf("WebSocketClient: Verbinde mit %s...\n", serverUrl.c_str());
     }
     
-    xSemaphoreGive(webSocketMutex);
-    return currentStatus == WebSocketStatus::CONNECTED;
-}
-
-bool WebSocketClient::connect() {
-    return connect(serverHost, serverPort);
+    // Aufbau übernimmt die Netzwerk-Task ohne zu blockieren; bis dahin
+    // werden Nachrichten und Audio eingereiht
+    currentStatus = WebSocketStatus::CONNECTING;
+    connectRequested = true;
+    reconnectStats.attempts++;
 }
 
 void WebSocketClient::disconnect() {
@@ -245,13 +402,36 @@ void WebSocketClient::disconnect() {
         return;
     }
     
+    tls.stop();
     if (wifiClient) {
         wifiClient->stop();
     }
     
+    // Laufenden Verbindungsaufbau abbrechen
+    connectRequested = false;
+    connectPhase = ConnectPhase::NONE;
+    snapshotArmed = false;
+    earlyData = false;
+    if (connectSocket >= 0) {
+        close(connectSocket);
+        connectSocket = -1;
+    }
+    
     currentStatus = WebSocketStatus::DISCONNECTED;
     wsConnected = false;
+    
+    // Erster Versuch nach kurzer, gejitterter Pause
+    markLinkDown();
     reconnectAttempts = 0;
+    reconnectDelay = backoffDelay(0);
+    lastReconnectAttempt = millis();
+    
+    // Nicht gesendetes Audio, Telemetrie und Bulk gehören zur alten Verbindung;
+    // Steuer-Nachrichten bleiben wie bei failConnect() für die nächste
+    audioPacketizer.clear();
+    audioTx.clear();
+    telemetryTx.clear();
+    bulkTx.clear();
     
     xSemaphoreGive(webSocketMutex);
     Serial.println("WebSocketClient: Verbindung getrennt");
@@ -274,7 +454,15 @@ WebSocketStatus WebSocketClient::getStatus() const {
 void WebSocketClient::setServer(const String& host, int port) {
     serverHost = host;
     serverPort = port;
-    serverUrl = "ws://" + host + ":" + String(port);
+    serverAddressHint = 0;
+    serverUrl = String(tlsEnabled ? "wss://" : "ws://") + host + ":" + String(port);
+}
+
+void WebSocketClient::setTls(bool enabled, const char* caCert, const char* pinSha256) {
+    tlsEnabled = enabled;
+    tlsCaCert = caCert;
+    tlsPinSha256 = pinSha256;
+    serverUrl = String(tlsEnabled ? "wss://" : "ws://") + serverHost + ":" + String(serverPort);
 }
 
 void WebSocketClient::setClientId(const String& id) {
@@ -285,6 +473,10 @@ String WebSocketClient::getServerHost() const {
     return serverHost;
 }
 
+IPAddress WebSocketClient::getServerAddress() const {
+    return IPAddress(serverAddressHint);
+}
+
 int WebSocketClient::getServerPort() const {
     return serverPort;
 }
@@ -298,54 +490,273 @@ String WebSocketClient::getClientId() const {
 // =============================================================================
 
 bool WebSocketClient::sendMessage(const String& message) {
-    if (!(currentStatus == WebSocketStatus::CONNECTED && wifiClient && wifiClient->connected())) {
+    return enqueueControl(WS_OPCODE_TEXT, (const uint8_t*)message.c_str(), message.length());
+}
+
+bool WebSocketClient::enqueueControl(uint8_t opcode, const uint8_t* data, size_t length) {
+    if (length > WS_TX_SLOT_SIZE) {
+        Serial.printf("WebSocketClient: Nachricht zu groß (%u Bytes)\n", length);
         return false;
     }
     
-    if (xSemaphoreTake(webSocketMutex, pdMS_TO_TICKS(10)) != pdTRUE) {
+    uint32_t ticket;
+    TxSlot* slot = reserveSlot(controlTx, ticket);
+    if (!slot) {
         return false;
     }
-    
-    bool result = sendWebSocketFrame(message.c_str(), message.length(), 0x01); // Text-Frame
-    if (result) {
-        lastActivity = millis();
+    memcpy(slot->data, data, length);
+    return commitSlot(controlTx, slot, ticket, opcode, length);
+}
+
+TxSlot* WebSocketClient::reserveSlot(TxQueue& queue, uint32_t& ticket) {
+    // Steuer-Nachrichten (BLOCK) auch ohne Verbindung einreihen, sie folgen nach
+    // dem Reconnect; die übrigen Kanäle gehören zur Verbindung
+    bool block = queue.getPolicy() == TxPolicy::BLOCK;
+    if (!webSocketTaskHandle || !(block || isConnected() || currentStatus == WebSocketStatus::CONNECTING)) {
+        return nullptr;
     }
     
-    xSemaphoreGive(webSocketMutex);
-    return result;
+    // Nur einreihen, die Sende-Task schreibt. Bei voller Steuer-Queue warten,
+    // solange die Verbindung steht.
+    TxSlot* slot;
+    while ((slot = queue.reserve(ticket)) == nullptr) {
+        if (!block || !isConnected()) {
+            // Ohne Verbindung leert sich die Queue nicht, warten hilft nicht:
+            // ablehnen und zählen (getChannelStats, rejected)
+            if (block) {
+                queue.recordRejected();
+            }
+            return nullptr;
+        }
+        if (xTaskGetCurrentTaskHandle() == webSocketTaskHandle) {
+            sendNextFrame(); // Aufruf aus der Netzwerk-Task selbst: direkt leeren
+        } else {
+            wakeNetworkTask();
+            vTaskDelay(1);
+        }
+    }
+    return slot;
 }
 
-bool WebSocketClient::sendEvent(const String& eventType) {
-    String message = createEventMessage(eventType);
-    return sendMessage(message);
+bool WebSocketClient::commitSlot(TxQueue& queue, TxSlot* slot, uint32_t ticket, uint8_t opcode, size_t length) {
+    // Länge 0 gibt die Reservierung frei, der Sender überspringt den Slot
+    queue.commit(slot, ticket, opcode, length);
+    wakeNetworkTask();
+    return length > 0;
+}
+
+bool WebSocketClient::commitJson(TxQueue& queue, TxSlot* slot, uint32_t ticket, const JsonWriter& json) {
+    if (!json.ok()) {
+        Serial.println("WebSocketClient: Nachricht passt nicht in den Sende-Slot, verworfen");
+        return commitSlot(queue, slot, ticket, WS_OPCODE_TEXT, 0);
+    }
+    return commitSlot(queue, slot, ticket, WS_OPCODE_TEXT, json.size());
+}
+
+bool WebSocketClient::sendEvent(const char* eventType, const EventField* fields, size_t count) {
+    // Nur der Wiedergabe-Fortschritt läuft als Telemetrie: der nächste Stand
+    // ersetzt einen verworfenen. Zustandswechsel (latency_config, uplink_config)
+    // kommen selten und nur einmal, sie dürfen nicht hinter Fortschritt-Meldungen
+    // aus der Telemetrie-Queue fallen und gehen über die Steuerung.
+    bool telemetry = strcmp(eventType, EVENT_PLAYBACK_PROGRESS) == 0;
+    TxQueue& queue = telemetry ? telemetryTx : controlTx;
+    
+    // Nachricht direkt im Slot der Sende-Queue aufbauen, ohne String-Zwischenschritt
+    // und ohne Heap: die Felder sind typisiert, Schlüssel bzw. Tags kommen aus dem Schema
+    uint32_t ticket;
+    TxSlot* slot = reserveSlot(queue, ticket);
+    if (!slot) {
+        return false;
+    }
+    
+    if (tlvTx) {
+        // Kompakt: Ereignis-Id statt Name, Felder nach Schema. Kennt das Schema
+        // das Ereignis nicht oder ist eine Zahl negativ, geht die Nachricht als JSON.
+        ControlWriter writer(slot->data, WS_TLV_MAX_SIZE, ControlType::EVENT,
+                             telemetry ? WS_KIND_TELEMETRY : WS_KIND_CONTROL);
+        uint8_t eventId;
+        if (controlEventId(eventType, eventId)) {
+            writer.putUint(ControlTag::EVENT, eventId);
+            writer.putUint(ControlTag::UPTIME_MS, millis());
+            if (writer.putFields(fields, count)) {
+                return commitSlot(queue, slot, ticket, WS_OPCODE_BINARY, writer.size());
+            }
+        }
+    }
+    
+    JsonWriter json((char*)slot->data, WS_TX_SLOT_SIZE);
+    controlWriteJsonEvent(json, eventType, fields, count, clientId.c_str(), millis());
+    return commitJson(queue, slot, ticket, json);
 }
 
 bool WebSocketClient::sendAudio(const uint8_t* data, size_t length) {
-    if (!(currentStatus == WebSocketStatus::CONNECTED && wifiClient && wifiClient->connected()) || !data || length == 0) {
+    // Während des Verbindungsaufbaus weiter einreihen, false nur ohne Verbindung
+    if (!webSocketTaskHandle || !(isConnected() || currentStatus == WebSocketStatus::CONNECTING) ||
+        !data || length == 0) {
         return false;
     }
     
-    if (xSemaphoreTake(webSocketMutex, pdMS_TO_TICKS(10)) != pdTRUE) {
+    // RTP: direkt aus der aufrufenden Task, ohne Queue und ohne TCP-Stau
+    if (rtp.isActive()) {
+        if (!rtp.sendAudio(data, length)) {
+            return false;
+        }
+        recordFirstUplink();
+        uplinkSeq++;
+        return true;
+    }
+    
+    // Zu Frames gebündelt einreihen. Volle Queue: REJECT gibt false zurück
+    // (AudioManager puffert ADPCM im Pre-Roll), DROP_OLDEST verwirft den ältesten Frame
+    if (!audioPacketizer.append(data, length)) {
         return false;
     }
     
-    bool result = sendWebSocketFrame((const char*)data, length, 0x02); // Binary-Frame
-    if (result) {
-        lastActivity = millis();
+    wakeNetworkTask();
+    
+    if (audioPacketizer.adapt()) {
+        reportUplinkConfig();
     }
+    return true;
+}
+
+void WebSocketClient::reportUplinkConfig() {
+    PacketizerStats stats = audioPacketizer.getStats();
+    Serial.printf("WebSocketClient: Uplink-Frames %u ms (%u Bytes), Overhead %u.%u %%, Sendelatenz %u us\n",
+                  stats.frameMs, stats.frameBytes, stats.overheadPermille / 10, stats.overheadPermille % 10,
+                  stats.sendLatencyUs);
     
-    xSemaphoreGive(webSocketMutex);
-    return result;
+    EventField fields[] = {
+        { ControlTag::FRAME_MS, stats.frameMs },
+        { ControlTag::FRAME_BYTES, stats.frameBytes },
+        { ControlTag::OVERHEAD_PERMILLE, stats.overheadPermille },
+        { ControlTag::SEND_LATENCY_US, stats.sendLatencyUs },
+    };
+    sendEvent(EVENT_UPLINK_CONFIG, fields);
+}
+
+bool WebSocketClient::sendBulk(const uint8_t* data, size_t length) {
+    // Ohne TLV gibt es kein Kind-Byte, das Bulk-Daten von Audio unterscheidet
+    if (!tlvTx || !data || length == 0 || !isConnected()) {
+        return false;
+    }
+    
+    // Niedrigste Priorität; volle Queue lehnt ab, der Aufrufer wiederholt später
+    if (!bulkTx.push(WS_OPCODE_BINARY, data, length)) {
+        return false;
+    }
+    
+    wakeNetworkTask();
+    return true;
 }
 
 bool WebSocketClient::sendIdentification() {
-    String message = createIdentificationMessage();
-    return sendMessage(message);
+    uint32_t ticket;
+    TxSlot* slot = reserveSlot(controlTx, ticket);
+    if (!slot) {
+        return false;
+    }
+    
+    JsonWriter json((char*)slot->data, WS_TX_SLOT_SIZE);
+    writeIdentificationMessage(json);
+    return commitJson(controlTx, slot, ticket, json);
+}
+
+bool WebSocketClient::sendResume() {
+    // Eine Nachricht statt kompletter Identifikation; lehnt der Server ab,
+    // folgt die Identifikation (processSession)
+    uint32_t ticket;
+    TxSlot* slot = reserveSlot(controlTx, ticket);
+    if (!slot) {
+        return false;
+    }
+    
+    JsonWriter json((char*)slot->data, WS_TX_SLOT_SIZE);
+    writeResumeMessage(json);
+    return commitJson(controlTx, slot, ticket, json);
 }
 
 bool WebSocketClient::sendHeartbeat() {
-    String heartbeat = "{\"type\":\"heartbeat\",\"clientId\":\"" + clientId + "\",\"timestamp\":" + String(millis()) + "}";
-    return sendMessage(heartbeat);
+    uint32_t ticket;
+    TxSlot* slot = reserveSlot(telemetryTx, ticket);
+    if (!slot) {
+        return false;
+    }
+    
+    if (tlvTx) {
+        ControlWriter writer(slot->data, WS_TLV_MAX_SIZE, ControlType::HEARTBEAT, WS_KIND_TELEMETRY);
+        writer.putUint(ControlTag::UPTIME_MS, millis());
+        return commitSlot(telemetryTx, slot, ticket, WS_OPCODE_BINARY, writer.size());
+    }
+    
+    JsonWriter json((char*)slot->data, WS_TX_SLOT_SIZE);
+    json.beginObject();
+    json.addString("type", "heartbeat");
+    json.addString("clientId", clientId.c_str());
+    json.addUint(CONTROL_JSON_TIME_KEY, millis());
+    json.endObject();
+    return commitJson(telemetryTx, slot, ticket, json);
+}
+
+bool WebSocketClient::sendPing() {
+    // Direkt als Control-Frame, nicht hinter eingereihtem Audio
+    uint8_t payload[LINK_PING_PAYLOAD_SIZE];
+    size_t length = linkMonitor.buildPing(payload, esp_timer_get_time());
+    return sendControlFrame(WS_OPCODE_PING, payload, length);
+}
+
+bool WebSocketClient::sendFlowCredit() {
+    if (!audioManager) {
+        return false;
+    }
+    
+    // Kompakte Quittung: kumulativ empfangene Bytes und Sendegrenze
+    DownlinkCredit credit = audioManager->getDownlinkCredit();
+    uint32_t ticket;
+    TxSlot* slot = reserveSlot(controlTx, ticket);
+    if (!slot) {
+        return false;
+    }
+    
+    bool result;
+    if (tlvTx) {
+        ControlWriter writer(slot->data, WS_TLV_MAX_SIZE, ControlType::CREDIT);
+        writer.putUint(ControlTag::RX, credit.receivedBytes);
+        writer.putUint(ControlTag::LIMIT, credit.creditLimit);
+        writer.putUint(ControlTag::DROPS, credit.droppedBytes);
+        result = commitSlot(controlTx, slot, ticket, WS_OPCODE_BINARY, writer.size());
+    } else {
+        JsonWriter json((char*)slot->data, WS_TX_SLOT_SIZE);
+        json.beginObject();
+        json.addString("type", "credit");
+        json.addUint("rx", credit.receivedBytes);
+        json.addUint("limit", credit.creditLimit);
+        json.addUint("drops", credit.droppedBytes);
+        json.endObject();
+        result = commitJson(controlTx, slot, ticket, json);
+    }
+    if (result) {
+        lastCreditLimit = credit.creditLimit;
+        lastCreditDrops = credit.droppedBytes;
+        lastCreditTime = millis();
+    }
+    return result;
+}
+
+void WebSocketClient::updateFlowCredit() {
+    if (!audioManager || !isConnected()) {
+        return;
+    }
+    
+    DownlinkCredit credit = audioManager->getDownlinkCredit();
+    uint32_t delta = credit.creditLimit - lastCreditLimit;
+    bool changed = delta != 0 || credit.droppedBytes != lastCreditDrops;
+    
+    // Sofort bei spürbar freiem Platz, sonst periodisch solange sich etwas ändert
+    if (delta >= WS_CREDIT_MIN_DELTA ||
+        (changed && millis() - lastCreditTime >= WS_CREDIT_INTERVAL_MS)) {
+        sendFlowCredit();
+    }
 }
 
 // =============================================================================
@@ -384,6 +795,81 @@ bool WebSocketClient::isAutoReconnectEnabled() const {
     return autoReconnect;
 }
 
+void WebSocketClient::saveSnapshot() {
+    // Nur aus einer bestehenden Verbindung; sonst bleibt der vorige Snapshot
+    if (!WS_SNAPSHOT_ENABLED || !isConnected() || serverIp == 0) {
+        return;
+    }
+    if (xSemaphoreTake(webSocketMutex, pdMS_TO_TICKS(WS_TX_LOCK_TIMEOUT_MS)) != pdTRUE) {
+        return;
+    }
+    
+    // Upgrade-Anfrage mit Platzhalter, der Schlüssel wird beim Senden ersetzt
+    String request = createWebSocketHandshake(String(WS_KEY_PLACEHOLDER));
+    int keyOffset = request.indexOf("Sec-WebSocket-Key: ") + 19;
+    
+    // Hello ohne Zeitstempel, er wäre beim Aufwachen veraltet
+    char hello[WS_SNAPSHOT_HELLO_SIZE];
+    JsonWriter json(hello, sizeof(hello));
+    bool resume = sessionToken.length() > 0;
+    if (resume) {
+        writeResumeMessage(json, false);
+    } else {
+        writeIdentificationMessage(json, false);
+    }
+    
+    // Erst ungültig machen: ein Reset während des Schreibens hinterlässt keinen halben Snapshot
+    rtcSnapshot.magic = 0;
+    if (keyOffset < 19 || request.length() > sizeof(rtcSnapshot.upgrade) || !json.ok() ||
+        sessionToken.length() >= sizeof(rtcSnapshot.token) || serverHost.length() >= sizeof(rtcSnapshot.host)) {
+        xSemaphoreGive(webSocketMutex);
+        Serial.println("WebSocketClient: Snapshot passt nicht in den RTC-Speicher");
+        return;
+    }
+    
+    rtcSnapshot.serverAddress = serverIp;
+    rtcSnapshot.serverPort = serverPort;
+    strncpy(rtcSnapshot.host, serverHost.c_str(), sizeof(rtcSnapshot.host));
+    rtcSnapshot.tls = tlsEnabled;
+    rtcSnapshot.pipelining = serverPipelining;
+    rtcSnapshot.resume = resume;
+    rtcSnapshot.uplinkSeq = uplinkSeq;
+    strncpy(rtcSnapshot.token, sessionToken.c_str(), sizeof(rtcSnapshot.token));
+    rtcSnapshot.keyOffset = keyOffset;
+    rtcSnapshot.upgradeLength = request.length();
+    memcpy(rtcSnapshot.upgrade, request.c_str(), request.length());
+    rtcSnapshot.helloLength = json.size();
+    memcpy(rtcSnapshot.hello, hello, json.size());
+    rtcSnapshot.magic = SNAPSHOT_MAGIC;
+    xSemaphoreGive(webSocketMutex);
+    
+    Serial.printf("WebSocketClient: Snapshot gesichert (%s:%d, %s, Pipelining %s)\n",
+                  serverHost.c_str(), serverPort, resume ? "resume" : "identification",
+                  serverPipelining ? "ja" : "nein");
+}
+
+bool WebSocketClient::restoreSnapshot() {
+    // Nur nach dem Deep Sleep; nach Reset oder Stromausfall gilt der normale Weg
+    if (!WS_SNAPSHOT_ENABLED || rtcSnapshot.magic != SNAPSHOT_MAGIC ||
+        esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_UNDEFINED || rtcSnapshot.tls != tlsEnabled) {
+        return false;
+    }
+    
+    serverHost = rtcSnapshot.host;
+    serverPort = rtcSnapshot.serverPort;
+    serverAddressHint = rtcSnapshot.serverAddress;  // Auch ohne Snapshot-Aufbau keine Namensauflösung
+    sessionToken = rtcSnapshot.resume ? rtcSnapshot.token : "";
+    uplinkSeq = rtcSnapshot.uplinkSeq;
+    serverPipelining = rtcSnapshot.pipelining;
+    snapshotArmed = true;
+    wakeTiming.snapshot = true;
+    
+    Serial.printf("WebSocketClient: Snapshot geladen (%s, %s:%d, Pipelining %s)\n",
+                  IPAddress(rtcSnapshot.serverAddress).toString().c_str(), serverHost.c_str(), serverPort,
+                  serverPipelining ? "ja" : "nein");
+    return true;
+}
+
 // =============================================================================
 // UTILITY-METHODEN
 // =============================================================================
@@ -425,18 +911,118 @@ void WebSocketClient::printMessageStats() {
     Serial.printf("WebSocketClient: Reconnect-Versuche: %d, Letzte Aktivität: %lu ms\n",
                   reconnectAttempts,
                   lastActivity);
+    
+    // Latenz je Kanal = Head-of-Line-Verzögerung vom Einreihen bis zum Socket
+    const char* names[WS_KIND_COUNT] = { "Audio", "Steuerung", "Telemetrie", "Bulk" };
+    TxQueueStats queues[WS_KIND_COUNT];
+    for (int i = 0; i < WS_KIND_COUNT; i++) {
+        queues[i] = getChannelStats(i);
+        Serial.printf("WebSocketClient: TX %s: Tiefe %u (max %u), gesendet %u, verworfen %u, abgelehnt %u, HOL %u us (max %u us)\n",
+                      names[i], queues[i].depth, queues[i].maxDepth, queues[i].sent,
+                      queues[i].dropped, queues[i].rejected, queues[i].avgLatencyUs, queues[i].maxLatencyUs);
+    }
+    
+    PacketizerStats packetizer = audioPacketizer.getStats();
+    Serial.printf("WebSocketClient: Uplink-Frames %u ms (%u Bytes), %u gesendet, Overhead %u.%u %%, vergrößert %u, verkleinert %u\n",
+                  packetizer.frameMs, packetizer.frameBytes, packetizer.frames,
+                  packetizer.overheadPermille / 10, packetizer.overheadPermille % 10,
+                  packetizer.increases, packetizer.decreases);
+    
+    if (tlsEnabled) {
+        TlsStats tlsStats = tls.getStats();
+        Serial.printf("WebSocketClient: TLS Handshakes voll %u (%u ms), fortgesetzt %u (%u ms), fehlgeschlagen %u, CPU je Frame %u us senden, %u us empfangen\n",
+                      tlsStats.fullHandshakes, tlsStats.avgFullHandshakeMs,
+                      tlsStats.resumedHandshakes, tlsStats.avgResumedHandshakeMs,
+                      tlsStats.failedHandshakes, tlsStats.avgWriteCpuUs, tlsStats.avgReadCpuUs);
+    }
+    
+    if (rtp.isActive()) {
+        RtpStats rtpStats = rtp.getStats();
+        Serial.printf("WebSocketClient: RTP gesendet %u (Fehler %u), empfangen %u, verloren %u, verspätet %u, Jitter %u us\n",
+                      rtpStats.packetsSent, rtpStats.sendErrors, rtpStats.packetsReceived,
+                      rtpStats.packetsLost, rtpStats.packetsLate, rtpStats.jitterUs);
+    }
+    
+    if (wakeTiming.firstUplinkUs != 0) {
+        Serial.printf("WebSocketClient: Wakeup bis TCP %u ms, Upgrade %u ms, erstes Uplink-Byte %u ms (%s)\n",
+                      wakeTiming.tcpConnectedUs / 1000, wakeTiming.upgradedUs / 1000, wakeTiming.firstUplinkUs / 1000,
+                      wakeTiming.snapshot ? "Snapshot" : "ohne Snapshot");
+    }
+    
+    LinkQuality link = linkMonitor.getQuality();
+    Serial.printf("WebSocketClient: RTT %u us (Jitter %u us, min %u us), Pings %u, Pongs %u, verpasst %u\n",
+                  link.srttUs, link.rttVarUs, link.minRttUs, link.pingsSent, link.pongsReceived, link.missedPongs);
+    
+    Serial.printf("WebSocketClient: Aufwachen %u (Socket %u, Senden %u, Timer %u), Befehle %u, Latenz %u us (max %u us)\n",
+                  loopStats.wakeups, loopStats.socketWakeups, loopStats.txWakeups, loopStats.timerWakeups,
+                  loopStats.commands, loopStats.avgCommandLatencyUs, loopStats.maxCommandLatencyUs);
 }
 
 void WebSocketClient::enableDebug(bool enabled) {
     debugEnabled = enabled;
 }
 
+TxQueueStats WebSocketClient::getChannelStats(uint8_t channel) const {
+    switch (channel) {
+        case WS_KIND_CONTROL:   return controlTx.getStats();
+        case WS_KIND_TELEMETRY: return telemetryTx.getStats();
+        case WS_KIND_BULK:      return bulkTx.getStats();
+        default:                return audioTx.getStats();
+    }
+}
+
+NetworkLoopStats WebSocketClient::getLoopStats() const {
+    return loopStats;
+}
+
+LinkQuality WebSocketClient::getLinkQuality() const {
+    return linkMonitor.getQuality();
+}
+
+TlsStats WebSocketClient::getTlsStats() const {
+    return tls.getStats();
+}
+
+RtpStats WebSocketClient::getRtpStats() const {
+    return rtp.getStats();
+}
+
+PacketizerStats WebSocketClient::getPacketizerStats() const {
+    return audioPacketizer.getStats();
+}
+
+ReconnectStats WebSocketClient::getReconnectStats() const {
+    return reconnectStats;
+}
+
+WakeTiming WebSocketClient::getWakeTiming() const {
+    return wakeTiming;
+}
+
+void WebSocketClient::recordFirstUplink() {
+    if (wakeTiming.firstUplinkUs != 0) {
+        return;
+    }
+    wakeTiming.firstUplinkUs = (uint32_t)esp_timer_get_time();
+    
+    // Vergleichswert für den nächsten Wakeup
+    rtcLastFirstUplinkUs = wakeTiming.firstUplinkUs;
+    rtcLastSnapshot = wakeTiming.snapshot;
+    
+    Serial.printf("WebSocketClient: Wakeup bis erstes Uplink-Byte %u ms (TCP %u ms, Upgrade %u ms, %s)\n",
+                  wakeTiming.firstUplinkUs / 1000, wakeTiming.tcpConnectedUs / 1000, wakeTiming.upgradedUs / 1000,
+                  wakeTiming.snapshot ? "Snapshot" : "ohne Snapshot");
+    if (wakeTiming.previousFirstUplinkUs != 0) {
+        Serial.printf("WebSocketClient: Voriger Wakeup %u ms (%s)\n", wakeTiming.previousFirstUplinkUs / 1000,
+                      wakeTiming.previousSnapshot ? "Snapshot" : "ohne Snapshot");
+    }
+}
+
 // =============================================================================
 // PRIVATE METHODEN
 // =============================================================================
 
-String WebSocketClient::createWebSocketHandshake() {
-    String key = generateWebSocketKey();
+String WebSocketClient::createWebSocketHandshake(const String& key) {
     String handshake = "GET / HTTP/1.1\r\n";
     handshake += "Host: " + serverHost + ":" + String(serverPort) + "\r\n";
     handshake += "Upgrade: websocket\r\n";
@@ -448,69 +1034,48 @@ String WebSocketClient::createWebSocketHandshake() {
 }
 
 String WebSocketClient::generateWebSocketKey() {
-    // Einfache WebSocket-Key-Generierung
-    String key = "";
-    for (int i = 0; i < 16; i++) {
-        key += (char)(random(65, 91)); // A-Z
+    // 16 zufällige Bytes aus dem Hardware-RNG (RFC 6455, 4.1)
+    uint8_t nonce[16];
+    for (int i = 0; i < 16; i += 4) {
+        uint32_t word = esp_random();
+        memcpy(nonce + i, &word, sizeof(word));
     }
-    return base64Encode(key);
+    return base64Encode(nonce, sizeof(nonce));
 }
 
-String WebSocketClient::base64Encode(const String& input) {
-    // Vereinfachte Base64-Kodierung
-    const char* chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-    String result = "";
-    int i = 0;
-    
-    while (i < input.length()) {
-        uint32_t octet_a = i < input.length() ? input[i++] : 0;
-        uint32_t octet_b = i < input.length() ? input[i++] : 0;
-        uint32_t octet_c = i < input.length() ? input[i++] : 0;
-        
-        uint32_t triple = (octet_a << 16) + (octet_b << 8) + octet_c;
-        
-        result += chars[(triple >> 18) & 0x3F];
-        result += chars[(triple >> 12) & 0x3F];
-        result += chars[(triple >> 6) & 0x3F];
-        result += chars[triple & 0x3F];
+String WebSocketClient::computeAcceptKey(const String& key) {
+    // base64(SHA-1(Key + GUID)), RFC 6455, 4.2.2
+    String input = key + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+    uint8_t digest[20];
+    mbedtls_sha1_ret((const unsigned char*)input.c_str(), input.length(), digest);
+    return base64Encode(digest, sizeof(digest));
+}
+
+String WebSocketClient::base64Encode(const uint8_t* data, size_t length) {
+    char encoded[64];
+    size_t encodedLength = 0;
+    if (mbedtls_base64_encode((unsigned char*)encoded, sizeof(encoded), &encodedLength, data, length) != 0) {
+        return "";
     }
-    
-    return result;
+    return String(encoded);
 }
 
-bool WebSocketClient::sendWebSocketFrame(const char* data, size_t length, uint8_t opcode) {
-    if (!wifiClient || !wifiClient->connected()) {
+bool WebSocketClient::sendWebSocketFrame(const char* data, size_t length, uint8_t opcode, int kind) {
+    if (!transportConnected() || !txBuffer) {
         return false;
     }
     
-    // WebSocket-Frame erstellen
-    uint8_t frame[10];
-    int frameSize = 0;
+    // Client-Frames müssen maskiert sein (RFC 6455, 5.3), Schlüssel pro Frame neu
+    uint32_t maskWord = esp_random();
+    uint8_t maskKey[4];
+    memcpy(maskKey, &maskWord, sizeof(maskKey));
     
-    // FIN + RSV + Opcode
-    frame[frameSize++] = 0x80 | opcode;
-    
-    // Payload-Length
-    if (length < 126) {
-        frame[frameSize++] = length;
-    } else if (length < 65536) {
-        frame[frameSize++] = 126;
-        frame[frameSize++] = (length >> 8) & 0xFF;
-        frame[frameSize++] = length & 0xFF;
-    } else {
-        frame[frameSize++] = 127;
-        for (int i = 7; i >= 0; i--) {
-            frame[frameSize++] = (length >> (i * 8)) & 0xFF;
-        }
-    }
-    
-    // Frame senden
-    wifiClient->write(frame, frameSize);
-    
-    // Daten senden
-    wifiClient->write((uint8_t*)data, length);
-    
-    return true;
+    return wsWriteFrame(txBuffer, WS_TX_BUFFER_SIZE, (const uint8_t*)data, length, opcode, kind, maskKey,
+                        writeTransport, this);
+}
+
+size_t WebSocketClient::writeTransport(void* context, const uint8_t* data, size_t length) {
+    return ((WebSocketClient*)context)->transportWrite(data, length);
 }
 
 
@@ -525,8 +1090,8 @@ void WebSocketClient::processMessage(const String& message) {
     wsMessage.binaryLength = 0;
     wsMessage.binaryData = nullptr;
     
-    // Nachricht in Queue für Verarbeitung
-    if (messageQueue && xQueueSend(messageQueue, &wsMessage, pdMS_TO_TICKS(10)) == pdTRUE) {
+    // Nachricht in Queue für Verarbeitung (nicht blockieren, die Task leert sie)
+    if (messageQueue && xQueueSend(messageQueue, &wsMessage, 0) == pdTRUE) {
         // Nachricht erfolgreich in Queue gesendet
     }
     
@@ -546,27 +1111,27 @@ void WebSocketClient::processMessage(const String& message) {
         case MessageType::OTA:
             processOTA(message);
             break;
+        case MessageType::SESSION:
+            processSession(message);
+            break;
+        case MessageType::ENCODING:
+            processEncoding(message);
+            break;
+        case MessageType::TRANSPORT:
+            processTransport(message);
+            break;
         default:
             break;
     }
+    
+    recordCommandLatency();
 }
 
 void WebSocketClient::processBinaryMessage(uint8_t* data, size_t length) {
-    // Audio-Daten an AudioManager weiterleiten
+    // Audio-Daten an AudioManager weiterleiten (Daten sind nur während des Aufrufs gültig)
     if (audioCallback) {
         audioCallback(data, length);
     }
-    
-    // Audio-Chunk in Queue für Verarbeitung
-    AudioChunk audioChunk;
-    audioChunk.data = data;
-    audioChunk.length = length;
-    audioChunk.timestamp = millis();
-    audioChunk.isSilence = false;
-    
-    if (audioQueue && xQueueSend(audioQueue, &audioChunk, pdMS_TO_TICKS(10)) == pdTRUE) {
-        // Audio-Chunk erfolgreich in Queue gesendet
-    }
 }
 
 MessageType WebSocketClient::parseMessageType(const String& message) {
@@ -585,26 +1150,52 @@ MessageType WebSocketClient::parseMessageType(const String& message) {
         return MessageType::OTA;
     } else if (message.indexOf("\"type\":\"heartbeat\"") > 0) {
         return MessageType::HEARTBEAT;
+    } else if (message.indexOf("\"type\":\"session\"") > 0) {
+        return MessageType::SESSION;
+    } else if (message.indexOf("\"type\":\"encoding\"") > 0) {
+        return MessageType::ENCODING;
+    } else if (message.indexOf("\"type\":\"transport\"") > 0) {
+        return MessageType::TRANSPORT;
     } else {
         return MessageType::UNKNOWN;
     }
 }
 
-String WebSocketClient::createIdentificationMessage() {
-    String message = "{\"type\":\"identification\",\"clientId\":\"" + clientId + "\",";
-    message += "\"capabilities\":{\"audio\":true,\"led\":true,\"button\":true},";
-    message += "\"version\":\"1.0.0\",\"timestamp\":" + String(millis()) + "}";
-    return message;
+void WebSocketClient::writeIdentificationMessage(JsonWriter& json, bool withTimestamp) {
+    json.beginObject();
+    json.addString("type", "identification");
+    json.addString("clientId", clientId.c_str());
+    json.beginObject("capabilities");
+    json.addBool("audio", true);
+    json.addBool("led", true);
+    json.addBool("button", true);
+    json.addBool("downlinkCredit", true);
+    json.addBool("resume", true);
+    json.addBool("tlv", true);
+    json.addBool("rtp", RTP_AUDIO_ENABLED);
+    json.endObject();
+    json.addUint("uplinkSeq", uplinkSeq);
+    json.addString("version", "1.0.0");
+    if (withTimestamp) {
+        json.addUint(CONTROL_JSON_TIME_KEY, millis());
+    }
+    json.endObject();
 }
 
-String WebSocketClient::createEventMessage(const String& eventType) {
-    String message = "{\"type\":\"event\",\"event\":\"" + eventType + "\",";
-    message += "\"clientId\":\"" + clientId + "\",\"timestamp\":" + String(millis()) + "}";
-    return message;
+void WebSocketClient::writeResumeMessage(JsonWriter& json, bool withTimestamp) {
+    json.beginObject();
+    json.addString("type", "resume");
+    json.addString("clientId", clientId.c_str());
+    json.addString("token", sessionToken.c_str());
+    json.addUint("uplinkSeq", uplinkSeq);
+    if (withTimestamp) {
+        json.addUint(CONTROL_JSON_TIME_KEY, millis());
+    }
+    json.endObject();
 }
 
 bool WebSocketClient::isConnected() const {
-    return currentStatus == WebSocketStatus::CONNECTED && wifiClient && wifiClient->connected();
+    return currentStatus == WebSocketStatus::CONNECTED && transportConnected();
 }
 
 // =============================================================================
@@ -612,37 +1203,235 @@ bool WebSocketClient::isConnected() const {
 // =============================================================================
 
 void WebSocketClient::processCommand(const String& message) {
-    // JSON-Parsing für Befehle
-    DynamicJsonDocument doc(1024);
-    DeserializationError error = deserializeJson(doc, message);
-    
-    if (error) {
-        Serial.println("WebSocketClient: JSON-Parsing-Fehler");
+    // Befehle gehen über die Befehlstabelle direkt an die Manager
+    if (!commandRegistry) {
+        Serial.println("WebSocketClient: Befehl ohne CommandRegistry verworfen");
         return;
     }
-    
-    String command = doc["command"] | "";
-    String target = doc["target"] | "";
-    
-    if (command == "led") {
-        // LED-Befehl an LedManager weiterleiten
-        String color = doc["color"] | "";
-        String effect = doc["effect"] | "";
-        // Hier würde die Integration mit LedManager erfolgen
-        Serial.printf("WebSocketClient: LED-Befehl - Farbe: %s, Effekt: %s\n", color.c_str(), effect.c_str());
-    }
+    commandRegistry->dispatchJson(message.c_str(), message.length(), nullptr);
 }
 
-void WebSocketClient::processConfig(const String& message) {
-    // Konfigurationsänderungen verarbeiten
-    Serial.println("WebSocketClient: Konfiguration empfangen");
-    // Hier würde die Integration mit anderen Managern erfolgen
+void WebSocketClient::handleStartStream() {
+    if (!audioManager) {
+        Serial.println("WebSocketClient: start_stream ohne AudioManager");
+        return;
+    }
+    
+    // Aufnahme läuft bereits ("armed"), nur das Gate wird geöffnet
+    if (!audioManager->isRecording()) {
+        audioManager->startRecording();
+    }
+    StreamMark mark = audioManager->openStream();
+    
+    EventField fields[] = {
+        { ControlTag::SAMPLE_INDEX, (int64_t)mark.sampleIndex },
+        { ControlTag::CAPTURE_TIMESTAMP, mark.captureTimestampUs },
+        { ControlTag::SAMPLE_RATE, (int64_t)I2S_SAMPLE_RATE },
+    };
+    sendEvent("stream_started", fields);
+    
+    Serial.printf("WebSocketClient: Stream gestartet ab Sample %llu\n", (unsigned long long)mark.sampleIndex);
+}
+
+void WebSocketClient::handleStopStream() {
+    if (!audioManager) {
+        return;
+    }
+    
+    StreamMark mark = audioManager->closeStream();
+    
+    // Letzten angefangenen Frame nicht bis zur Flush-Frist zurückhalten
+    audioPacketizer.flush();
+    
+    EventField fields[] = {
+        { ControlTag::SAMPLE_INDEX, (int64_t)mark.sampleIndex },
+        { ControlTag::CAPTURE_TIMESTAMP, mark.captureTimestampUs },
+    };
+    sendEvent("stream_stopped", fields);
+    
+    Serial.printf("WebSocketClient: Stream gestoppt bei Sample %llu\n", (unsigned long long)mark.sampleIndex);
+}
+
+void WebSocketClient::handleQueueClip(uint32_t clipId, const char* source, uint16_t crossfadeMs, uint32_t length,
+                                      const char* name, const char* url) {
+    if (!audioManager) {
+        return;
+    }
+    
+    bool queued = false;
+    if (strcmp(source, "flash") == 0) {
+        queued = audioManager->queueFlashClip(clipId, name, crossfadeMs);
+    } else if (strcmp(source, "url") == 0) {
+        queued = audioManager->queueUrlClip(clipId, url, crossfadeMs);
+    } else {
+        // Länge optional, sonst beendet clip_end bzw. der nächste queue_clip den Clip
+        queued = audioManager->queueStreamClip(clipId, crossfadeMs, length);
+    }
+    
+    if (!queued) {
+        EventField fields[] = { { ControlTag::CLIP_ID, clipId } };
+        sendEvent(EVENT_CLIP_REJECTED, fields);
+    }
+    Serial.printf("WebSocketClient: Clip %u (%s) %s\n", (unsigned)clipId, source,
+                  queued ? "eingereiht" : "abgelehnt");
+}
+
+void WebSocketClient::processConfig(const String& message) {
+    // config-Nachrichten tragen keinen Befehlsnamen
+    if (!commandRegistry) {
+        Serial.println("WebSocketClient: Konfiguration ohne CommandRegistry verworfen");
+        return;
+    }
+    commandRegistry->dispatchJson(message.c_str(), message.length(), "config");
+}
+
+void WebSocketClient::processSession(const String& message) {
+    // {"type":"session","token":"...","resumed":true|false,"pipelining":true|false}
+    StaticJsonDocument<256> doc;
+    if (deserializeJson(doc, message)) {
+        Serial.println("WebSocketClient: JSON-Parsing-Fehler");
+        return;
+    }
+    
+    applySession(doc["token"] | "", doc["resumed"] | false, doc["pipelining"] | false);
+}
+
+void WebSocketClient::applySession(const char* token, bool resumed, bool pipelining) {
+    bool wasResume = resumePending;
+    resumePending = false;
+    
+    // Zusage gilt für den Schnellweg nach dem nächsten Deep Sleep (Snapshot)
+    serverPipelining = pipelining;
+    
+    if (wasResume && !resumed) {
+        // Sitzung unbekannt oder abgelaufen: vollständig identifizieren
+        Serial.println("WebSocketClient: Sitzung nicht fortgesetzt, sende Identifikation");
+        sessionToken = "";
+        sendIdentification();
+    } else if (wasResume) {
+        reconnectStats.resumed++;
+        Serial.println("WebSocketClient: Sitzung fortgesetzt");
+    }
+    
+    if (token[0] != '\0') {
+        sessionToken = token;
+    }
+}
+
+void WebSocketClient::processEncoding(const String& message) {
+    // {"type":"encoding","value":"tlv"|"json"}: gilt ab der nächsten Nachricht
+    // des Servers; die Bestätigung markiert denselben Punkt für den Uplink
+    StaticJsonDocument<64> doc;
+    if (deserializeJson(doc, message)) {
+        Serial.println("WebSocketClient: JSON-Parsing-Fehler");
+        return;
+    }
+    
+    bool tlv = strcmp(doc["value"] | "", "tlv") == 0;
+    tlvRx = tlv;
+    
+    // Bestätigung direkt senden und im selben Moment umschalten: die Kodierung
+    // jedes Frames entscheidet sich beim Senden, alles danach folgt der Bestätigung
+    static const char ackTlv[] = "{\"type\":\"encoding\",\"value\":\"tlv\"}";
+    static const char ackJson[] = "{\"type\":\"encoding\",\"value\":\"json\"}";
+    if (xSemaphoreTake(webSocketMutex, pdMS_TO_TICKS(WS_TX_LOCK_TIMEOUT_MS)) != pdTRUE) {
+        Serial.println("WebSocketClient: Socket belegt, Uplink bleibt bei der bisherigen Kodierung");
+        return;
+    }
+    bool sent = tlv ? sendWebSocketFrame(ackTlv, sizeof(ackTlv) - 1, WS_OPCODE_TEXT)
+                    : sendWebSocketFrame(ackJson, sizeof(ackJson) - 1, WS_OPCODE_TEXT);
+    if (sent) {
+        tlvTx = tlv;
+    }
+    xSemaphoreGive(webSocketMutex);
+    
+    Serial.printf("WebSocketClient: Steuer-Kodierung %s\n", tlv ? "TLV" : "JSON");
+}
+
+void WebSocketClient::processTransport(const String& message) {
+    // {"type":"transport","mode":"rtp","port":5004,"pt":96} bzw. {"type":"transport","mode":"websocket"}
+    StaticJsonDocument<128> doc;
+    if (deserializeJson(doc, message)) {
+        Serial.println("WebSocketClient: JSON-Parsing-Fehler");
+        return;
+    }
+    
+    bool useRtp = strcmp(doc["mode"] | "", "rtp") == 0;
+    uint16_t port = doc["port"] | 0;
+    uint8_t payloadType = doc["pt"] | RTP_PAYLOAD_TYPE;
+    if (useRtp && (!RTP_AUDIO_ENABLED || port == 0 || !rtp.start(serverIp, port, payloadType))) {
+        useRtp = false;
+    }
+    if (!useRtp) {
+        rtp.stop();
+    }
+    
+    // Antwort mit dem gewählten Transport; bei RTP lokaler Port und SSRC.
+    // Bereits eingereihte Audio-Blöcke gehen noch über den WebSocket.
+    uint32_t ticket;
+    TxSlot* slot = reserveSlot(controlTx, ticket);
+    if (slot) {
+        JsonWriter json((char*)slot->data, WS_TX_SLOT_SIZE);
+        json.beginObject();
+        json.addString("type", "transport");
+        json.addString("mode", useRtp ? "rtp" : "websocket");
+        if (useRtp) {
+            json.addUint("port", rtp.getLocalPort());
+            json.addUint("ssrc", rtp.getSsrc());
+            json.addUint("pt", rtp.getPayloadType());
+        }
+        json.endObject();
+        commitJson(controlTx, slot, ticket, json);
+    }
+    
+    Serial.printf("WebSocketClient: Audio-Transport %s\n", useRtp ? "RTP/UDP" : "WebSocket");
+}
+
+void WebSocketClient::processControlMessage(const uint8_t* data, size_t length) {
+    ControlReader reader(data, length);
+    if (!reader.isValid()) {
+        return;
+    }
+    
+    switch (reader.type()) {
+        case ControlType::COMMAND:
+        case ControlType::CONFIG:
+            if (commandRegistry) {
+                commandRegistry->dispatchControl(data, length);
+            } else {
+                Serial.println("WebSocketClient: TLV-Befehl ohne CommandRegistry verworfen");
+            }
+            break;
+        case ControlType::SESSION: {
+            char token[64] = "";
+            bool resumed = false;
+            bool pipelining = false;
+            ControlTag tag;
+            const uint8_t* value;
+            uint8_t valueLength;
+            while (reader.next(tag, value, valueLength)) {
+                if (tag == ControlTag::TOKEN) {
+                    ControlReader::toString(value, valueLength, token, sizeof(token));
+                } else if (tag == ControlTag::RESUMED) {
+                    resumed = ControlReader::toUint(value, valueLength) != 0;
+                } else if (tag == ControlTag::PIPELINING) {
+                    pipelining = ControlReader::toUint(value, valueLength) != 0;
+                }
+            }
+            applySession(token, resumed, pipelining);
+            break;
+        }
+        default:
+            Serial.printf("WebSocketClient: Unbekannte TLV-Nachricht 0x%02X\n", (unsigned)reader.type());
+            break;
+    }
+    
+    recordCommandLatency();
 }
 
 void WebSocketClient::processOTA(const String& message) {
-    // OTA-Update-Befehle verarbeiten
-    Serial.println("WebSocketClient: OTA-Update-Befehl empfangen");
-    // Hier würde die Integration mit OtaManager erfolgen
+    // {"type":"ota","command":"ota_check"|"ota_start"|"ota_url",...}
+    processCommand(message);
 }
 
 // =============================================================================
@@ -655,32 +1444,730 @@ void WebSocketClient::webSocketTask(void* parameter) {
     Serial.println("WebSocketClient: WebSocket-Task gestartet");
     
     while (true) {
+        // Reconnect und Heartbeat (fällige Timer)
+        client->update();
+        
+        // Verbindungsaufbau einen Schritt weiterführen
+        client->serviceConnect();
+        
         // WebSocket-Frames lesen
-        if (client->wifiClient && client->wifiClient->connected()) {
-            client->readWebSocketFrames();
+        size_t received = 0;
+        if (client->wsConnected && client->transportConnected()) {
+            received = client->readWebSocketFrames();
+        }
+        if (client->rtp.isActive()) {
+            received += client->readRtpPackets();
         }
         
         // Nachrichten aus Queue verarbeiten
         WebSocketMessage message;
-        if (client->messageQueue && xQueueReceive(client->messageQueue, &message, pdMS_TO_TICKS(10)) == pdTRUE) {
-            // Nachricht verarbeiten
+        while (client->messageQueue && xQueueReceive(client->messageQueue, &message, 0) == pdTRUE) {
             if (client->debugEnabled) {
                 Serial.printf("WebSocketClient: Verarbeite Nachricht vom Typ %d\n", (int)message.type);
             }
         }
         
-        // Audio-Chunks aus Queue verarbeiten
-        AudioChunk audioChunk;
-        if (client->audioQueue && xQueueReceive(client->audioQueue, &audioChunk, pdMS_TO_TICKS(10)) == pdTRUE) {
-            // Audio-Chunk an AudioManager weiterleiten
-            if (client->debugEnabled) {
-                Serial.printf("WebSocketClient: Verarbeite Audio-Chunk: %d Bytes\n", audioChunk.length);
+        // Downlink-Credits melden
+        client->updateFlowCredit();
+        
+        // Pre-Roll-Rückstand nach Tasten-Loslassen nachreichen, angefangenen
+        // Frame ohne Nachschub abschließen, dann alles senden
+        if (client->isConnected() && client->audioManager && client->audioManager->hasPreRollData()) {
+            client->audioManager->flushPreRollBacklog();
+        }
+        client->audioPacketizer.flushIfIdle();
+        while (client->sendNextFrame()) {
+        }
+        
+        // Lesebudget ausgeschöpft: ohne Warten weiterlesen
+        if (received >= WS_RX_BUDGET_BYTES) {
+            taskYIELD();
+            continue;
+        }
+        
+        client->waitForWork(client->nextWakeupMs());
+    }
+}
+
+uint32_t WebSocketClient::nextWakeupMs() {
+    unsigned long now = millis();
+    uint32_t waitMs = WS_IDLE_WAKEUP_MS;
+    
+    if (currentStatus == WebSocketStatus::DISCONNECTED || currentStatus == WebSocketStatus::ERROR) {
+        if (autoReconnect) {
+            unsigned long elapsed = now - lastReconnectAttempt;
+            waitMs = elapsed >= reconnectDelay ? 0 : min(waitMs, (uint32_t)(reconnectDelay - elapsed));
+        }
+        return waitMs;
+    }
+    
+    if (connectPhase != ConnectPhase::NONE) {
+        // Timeout des Verbindungsaufbaus
+        unsigned long elapsed = now - connectStartTime;
+        waitMs = elapsed > WS_CONNECT_TIMEOUT_MS ? 0 : min(waitMs, (uint32_t)(WS_CONNECT_TIMEOUT_MS - elapsed + 1));
+    }
+    
+    if (currentStatus == WebSocketStatus::CONNECTED) {
+        unsigned long elapsed = now - lastHeartbeat;
+        waitMs = elapsed > WS_HEARTBEAT_INTERVAL ? 0 : min(waitMs, (uint32_t)(WS_HEARTBEAT_INTERVAL - elapsed + 1));
+        elapsed = now - lastPingTime;
+        waitMs = elapsed >= WS_PING_INTERVAL_MS ? 0 : min(waitMs, (uint32_t)(WS_PING_INTERVAL_MS - elapsed));
+    }
+    
+    if (audioManager) {
+        // Wiedergabe gibt Puffer frei, ohne dass ein Socket-Ereignis folgt:
+        // so oft prüfen, wie das Abspielen eines Credit-Schritts dauert
+        if (audioManager->isPlaybackActive()) {
+            waitMs = min(waitMs, (uint32_t)WS_CREDIT_POLL_MS);
+        } else if (audioManager->hasPreRollData()) {
+            waitMs = min(waitMs, (uint32_t)WS_POLL_INTERVAL_MS);
+        }
+    }
+    
+    // Angefangener Frame: spätestens nach der Flush-Frist nachsehen
+    if (audioPacketizer.hasPending()) {
+        waitMs = min(waitMs, (uint32_t)WS_PACKETIZER_FLUSH_MS);
+    }
+    
+    return waitMs;
+}
+
+void WebSocketClient::waitForWork(uint32_t timeoutMs) {
+    // Daten im Empfangspuffer des WiFiClient bzw. bereits entschlüsselte
+    // TLS-Daten machen den Socket nicht lesbar
+    int sock = wifiClient && wifiClient->connected() ? wifiClient->fd() : -1;
+    if (sock >= 0 && transportAvailable() > 0) {
+        rxWakeUs = esp_timer_get_time();
+        return;
+    }
+    
+    // Während connect() läuft: auf Beschreibbarkeit des neuen Sockets warten
+    int pendingSock = connectPhase == ConnectPhase::TCP ? connectSocket : -1;
+    int rtpSock = rtp.isActive() ? rtp.getSocket() : -1;
+    
+    if (txEventFd < 0 && sock < 0 && pendingSock < 0 && rtpSock < 0) {
+        vTaskDelay(pdMS_TO_TICKS(min(timeoutMs, (uint32_t)WS_POLL_INTERVAL_MS)));
+        return;
+    }
+    
+    fd_set readSet;
+    fd_set writeSet;
+    FD_ZERO(&readSet);
+    FD_ZERO(&writeSet);
+    int maxFd = -1;
+    if (sock >= 0) {
+        FD_SET(sock, &readSet);
+        maxFd = sock;
+    }
+    if (pendingSock >= 0) {
+        FD_SET(pendingSock, &writeSet);
+        maxFd = max(maxFd, pendingSock);
+    }
+    if (rtpSock >= 0) {
+        FD_SET(rtpSock, &readSet);
+        maxFd = max(maxFd, rtpSock);
+    }
+    if (txEventFd >= 0) {
+        FD_SET(txEventFd, &readSet);
+        maxFd = max(maxFd, txEventFd);
+    }
+    
+    // Ohne eventfd bleibt das Senden an den Timeout gebunden
+    if (txEventFd < 0) {
+        timeoutMs = min(timeoutMs, (uint32_t)WS_POLL_INTERVAL_MS);
+    }
+    
+    struct timeval timeout;
+    timeout.tv_sec = timeoutMs / 1000;
+    timeout.tv_usec = (timeoutMs % 1000) * 1000;
+    
+    int ready = select(maxFd + 1, &readSet, &writeSet, nullptr, &timeout);
+    
+    loopStats.wakeups++;
+    if (ready <= 0) {
+        loopStats.timerWakeups++;
+        return;
+    }
+    if ((sock >= 0 && FD_ISSET(sock, &readSet)) || (pendingSock >= 0 && FD_ISSET(pendingSock, &writeSet)) ||
+        (rtpSock >= 0 && FD_ISSET(rtpSock, &readSet))) {
+        loopStats.socketWakeups++;
+        rxWakeUs = esp_timer_get_time();
+    }
+    if (txEventFd >= 0 && FD_ISSET(txEventFd, &readSet)) {
+        // Zähler zurücksetzen, mehrere Benachrichtigungen ergeben ein Aufwachen
+        uint64_t count;
+        read(txEventFd, &count, sizeof(count));
+        loopStats.txWakeups++;
+    }
+}
+
+void WebSocketClient::recordCommandLatency() {
+    if (rxWakeUs == 0) {
+        return;
+    }
+    
+    uint32_t latencyUs = (uint32_t)(esp_timer_get_time() - rxWakeUs);
+    loopStats.commands++;
+    loopStats.avgCommandLatencyUs = loopStats.commands == 1
+        ? latencyUs
+        : loopStats.avgCommandLatencyUs + ((int32_t)(latencyUs - loopStats.avgCommandLatencyUs) >> 3);
+    if (latencyUs > loopStats.maxCommandLatencyUs) {
+        loopStats.maxCommandLatencyUs = latencyUs;
+    }
+}
+
+void WebSocketClient::wakeNetworkTask() {
+    // Aus der Netzwerk-Task selbst nicht nötig, sie sendet vor dem Warten
+    if (txEventFd >= 0 && xTaskGetCurrentTaskHandle() != webSocketTaskHandle) {
+        uint64_t one = 1;
+        write(txEventFd, &one, sizeof(one));
+    }
+}
+
+bool WebSocketClient::sendNextFrame() {
+    // Während des Verbindungsaufbaus bleibt alles eingereiht. Ausnahme: Upgrade
+    // und Hello sind schon im Flug und der Server hat Pipelining zugesagt.
+    if (!wsConnected && !earlyData) {
+        return false;
+    }
+    
+    TxQueue* queue = nextQueue();
+    if (!queue) {
+        return false;
+    }
+    
+    // Mutex vor dem Entnehmen: bei belegtem Socket bleibt der Frame eingereiht
+    if (xSemaphoreTake(webSocketMutex, pdMS_TO_TICKS(WS_TX_LOCK_TIMEOUT_MS)) != pdTRUE) {
+        return false;
+    }
+    
+    uint32_t ticket;
+    TxSlot* slot = queue->acquire(ticket);
+    if (!slot) {
+        // Slot reserviert, aber noch nicht gefüllt; der Produzent benachrichtigt erneut
+        xSemaphoreGive(webSocketMutex);
+        return false;
+    }
+    
+    if (slot->length == 0) {
+        // Abgebrochene Reservierung (Nachricht passte nicht in den Slot)
+        queue->release(slot, ticket);
+        queue->recordDropped();
+        xSemaphoreGive(webSocketMutex);
+        return true;
+    }
+    
+    // Audio und Bulk bekommen im TLV-Modus ihr Kind-Byte, TLV-Steuer- und
+    // Telemetrie-Nachrichten tragen es bereits
+    int kind = (tlvTx && queue == &audioTx) ? WS_KIND_AUDIO : (queue == &bulkTx) ? WS_KIND_BULK : -1;
+    const char* data = (const char*)slot->data;
+    size_t dataLength = slot->length;
+    uint8_t opcode = slot->opcode;
+    
+    // Vor einem Verbindungsabbruch als TLV eingereiht, der Server erwartet JSON:
+    // umkodieren statt als Binär-Frame senden (er läse ihn als Audio). Bulk gibt
+    // es ohne TLV nicht.
+    if (opcode == WS_OPCODE_BINARY && queue != &audioTx && !tlvTx) {
+        JsonWriter json(jsonBuffer, sizeof(jsonBuffer));
+        if (queue == &bulkTx || !controlWriteJsonMessage(json, slot->data + 1, slot->length - 1, clientId.c_str())) {
+            queue->release(slot, ticket);
+            queue->recordDropped();
+            xSemaphoreGive(webSocketMutex);
+            return true;
+        }
+        data = jsonBuffer;
+        dataLength = json.size();
+        opcode = WS_OPCODE_TEXT;
+    }
+    
+    bool sent = sendWebSocketFrame(data, dataLength, opcode, kind);
+    int64_t enqueueUs = slot->enqueueUs;
+    size_t length = slot->length;
+    queue->release(slot, ticket);
+    
+    if (sent) {
+        queue->recordSent(enqueueUs);
+        lastActivity = millis();
+        
+        if (queue == &audioTx) {
+            // Overhead je Frame: Header mit Maske, Kind-Byte, bei wss:// ein TLS-Record
+            size_t payloadLength = length + (kind >= 0 ? 1 : 0);
+            size_t overhead = (payloadLength < 126 ? 6 : 8) + (kind >= 0 ? 1 : 0) +
+                              (tls.isActive() ? TLS_RECORD_OVERHEAD : 0);
+            audioPacketizer.recordSent(length, overhead);
+            recordFirstUplink();
+            
+            uplinkSeq++;
+            if (streamResumePending) {
+                // Verbindungsverlust bis wieder gestreamt wird
+                streamResumePending = false;
+                uint32_t elapsed = lastActivity - linkDownTime;
+                reconnectStats.lastReconnectToStreamMs = elapsed;
+                reconnectStats.maxReconnectToStreamMs = max(reconnectStats.maxReconnectToStreamMs, elapsed);
+                Serial.printf("WebSocketClient: Streaming %u ms nach Verbindungsverlust fortgesetzt\n", elapsed);
             }
         }
+    } else {
+        queue->recordDropped();
+    }
+    
+    xSemaphoreGive(webSocketMutex);
+    return true;
+}
+
+TxQueue* WebSocketClient::nextQueue() {
+    // Steuerung strikt zuerst: eine Steuer-Nachricht wartet höchstens auf den
+    // Frame, der beim Einreihen gerade geschrieben wird
+    if (!controlTx.isEmpty()) {
+        return &controlTx;
+    }
+    
+    // Übrige Kanäle gewichtet im Round-Robin; leere Kanäle geben ihren Rest ab
+    TxQueue* queues[3] = { &audioTx, &telemetryTx, &bulkTx };
+    static const uint8_t weights[3] = { WS_SCHED_WEIGHT_AUDIO, WS_SCHED_WEIGHT_TELEMETRY, WS_SCHED_WEIGHT_BULK };
+    
+    for (int visited = 0; visited <= 3; visited++) {
+        if (schedCredit > 0 && !queues[schedIndex]->isEmpty()) {
+            schedCredit--;
+            return queues[schedIndex];
+        }
+        schedIndex = (schedIndex + 1) % 3;
+        schedCredit = weights[schedIndex];
+    }
+    return nullptr;
+}
+
+// =============================================================================
+// VERBINDUNGSAUFBAU (NICHT BLOCKIEREND)
+// =============================================================================
+
+void WebSocketClient::serviceConnect() {
+    if (connectRequested) {
+        connectRequested = false;
+        
+        // Ziel unter dem Mutex kopieren, connect() kann es aus anderen Tasks neu setzen
+        if (xSemaphoreTake(webSocketMutex, pdMS_TO_TICKS(WS_TX_LOCK_TIMEOUT_MS)) != pdTRUE) {
+            connectRequested = true; // Im nächsten Durchlauf erneut
+            return;
+        }
+        String host = serverHost;
+        uint32_t addressHint = snapshotArmed ? rtcSnapshot.serverAddress : serverAddressHint;
+        xSemaphoreGive(webSocketMutex);
         
-        // Kurze Pause für andere Tasks
-        vTaskDelay(pdMS_TO_TICKS(10));
+        // Namensauflösung ohne Mutex; IP-Adressen, DNS-SD-Cache und Snapshot ohne DNS
+        IPAddress address;
+        if (addressHint != 0) {
+            address = IPAddress(addressHint);
+        } else if (!address.fromString(host.c_str()) && !WiFi.hostByName(host.c_str(), address)) {
+            failConnect("DNS-Auflösung fehlgeschlagen");
+            return;
+        }
+        
+        if (xSemaphoreTake(webSocketMutex, pdMS_TO_TICKS(WS_TX_LOCK_TIMEOUT_MS)) != pdTRUE) {
+            connectRequested = true; // Im nächsten Durchlauf erneut
+            return;
+        }
+        if (currentStatus != WebSocketStatus::CONNECTING) {
+            xSemaphoreGive(webSocketMutex); // Während der Namensauflösung getrennt
+            return;
+        }
+        bool started = startConnect((uint32_t)address);
+        xSemaphoreGive(webSocketMutex);
+        
+        if (!started) {
+            failConnect("TCP-Verbindung fehlgeschlagen");
+        }
+        return;
     }
+    
+    if (connectPhase == ConnectPhase::NONE) {
+        return;
+    }
+    
+    if (millis() - connectStartTime > WS_CONNECT_TIMEOUT_MS) {
+        failConnect(connectPhase == ConnectPhase::TCP ? "Timeout bei TCP-Verbindung" :
+                    connectPhase == ConnectPhase::TLS ? "Timeout beim TLS-Handshake" : "Timeout beim Handshake");
+        return;
+    }
+    
+    if (xSemaphoreTake(webSocketMutex, pdMS_TO_TICKS(WS_TX_LOCK_TIMEOUT_MS)) != pdTRUE) {
+        return;
+    }
+    
+    const char* error = nullptr;
+    bool opened = false;
+    size_t frameOffset = 0;
+    size_t bytesRead = 0;
+    
+    if (connectPhase == ConnectPhase::TCP) {
+        if (!checkTcpConnected()) {
+            error = "TCP-Verbindung fehlgeschlagen";
+        }
+    } else if (connectPhase == ConnectPhase::TLS) {
+        TlsResult result = tls.handshake(serverHost.c_str());
+        if (result == TlsResult::FAILED) {
+            error = "TLS-Handshake fehlgeschlagen";
+        } else if (result == TlsResult::DONE) {
+            if (!sendUpgradeRequest()) {
+                error = "Upgrade-Anfrage fehlgeschlagen";
+            }
+        } else if (!wifiClient->connected()) {
+            error = "Verbindung während des TLS-Handshakes geschlossen";
+        }
+    } else if (connectPhase == ConnectPhase::UPGRADE) {
+        bytesRead = readHandshakeResponse(frameOffset);
+        if (handshakeMatch == 4) {
+            if (validateUpgradeResponse()) {
+                opened = true;
+                currentStatus = WebSocketStatus::CONNECTED;
+                wsConnected = true;
+                connectPhase = ConnectPhase::NONE;
+                reconnectAttempts = 0;
+                lastActivity = millis();
+                lastPingTime = lastActivity;
+                linkMonitor.reset();
+                tlvRx = false; // Kodierung wird pro Verbindung neu ausgehandelt
+                tlvTx = false;
+                resetFrameParser();
+            } else {
+                error = "WebSocket-Handshake fehlgeschlagen";
+            }
+        } else if (handshakeResponse.length() > WS_HANDSHAKE_MAX_SIZE) {
+            error = "Upgrade-Antwort zu groß";
+        } else if (!wifiClient->connected()) {
+            error = "Verbindung während des Handshakes geschlossen";
+        }
+    }
+    
+    xSemaphoreGive(webSocketMutex);
+    
+    if (error) {
+        failConnect(error);
+        return;
+    }
+    
+    if (opened) {
+        openConnection();
+        
+        // Frames, die direkt hinter der Upgrade-Antwort kamen
+        if (frameOffset < bytesRead) {
+            parseFrameData(frameBuffer + frameOffset, bytesRead - frameOffset);
+        }
+    }
+}
+
+bool WebSocketClient::startConnect(uint32_t address) {
+    // Alte Verbindung schließen
+    tls.stop();
+    if (wifiClient) {
+        wifiClient->stop();
+    }
+    wsConnected = false;
+    if (connectSocket >= 0) {
+        close(connectSocket);
+        connectSocket = -1;
+    }
+    
+    int sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (sock < 0) {
+        return false;
+    }
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+    
+    serverIp = address;
+    
+    struct sockaddr_in serverAddress;
+    memset(&serverAddress, 0, sizeof(serverAddress));
+    serverAddress.sin_family = AF_INET;
+    serverAddress.sin_addr.s_addr = address;
+    serverAddress.sin_port = htons(serverPort);
+    
+    // Kehrt sofort zurück, Abschluss meldet select() über Beschreibbarkeit
+    int result = lwip_connect(sock, (struct sockaddr*)&serverAddress, sizeof(serverAddress));
+    if (result < 0 && errno != EINPROGRESS) {
+        close(sock);
+        return false;
+    }
+    
+    connectSocket = sock;
+    connectPhase = ConnectPhase::TCP;
+    connectStartTime = millis();
+    return true;
+}
+
+bool WebSocketClient::checkTcpConnected() {
+    fd_set writeSet;
+    FD_ZERO(&writeSet);
+    FD_SET(connectSocket, &writeSet);
+    struct timeval noWait = { 0, 0 };
+    if (select(connectSocket + 1, nullptr, &writeSet, nullptr, &noWait) <= 0) {
+        return true; // Noch nicht verbunden
+    }
+    
+    int socketError = 0;
+    socklen_t errorLength = sizeof(socketError);
+    getsockopt(connectSocket, SOL_SOCKET, SO_ERROR, &socketError, &errorLength);
+    if (socketError != 0) {
+        return false;
+    }
+    if (wakeTiming.tcpConnectedUs == 0) {
+        wakeTiming.tcpConnectedUs = (uint32_t)esp_timer_get_time();
+    }
+    
+    // Wie WiFiClient::connect wieder blockierend; WiFiClient übernimmt den Socket
+    fcntl(connectSocket, F_SETFL, fcntl(connectSocket, F_GETFL, 0) & ~O_NONBLOCK);
+    *wifiClient = WiFiClient(connectSocket);
+    connectSocket = -1;
+    
+    if (tlsEnabled) {
+        // ClientHello sofort (mit gespeicherter Session), weitere Schritte bei lesbarem Socket
+        if (!tls.start(wifiClient->fd(), serverHost.c_str())) {
+            return false;
+        }
+        connectPhase = ConnectPhase::TLS;
+        return tls.handshake(serverHost.c_str()) != TlsResult::FAILED;
+    }
+    return sendUpgradeRequest();
+}
+
+bool WebSocketClient::sendUpgradeRequest() {
+    handshakeResponse = "";
+    handshakeMatch = 0;
+    connectPhase = ConnectPhase::UPGRADE;
+    
+    if (snapshotArmed) {
+        return sendSnapshotUpgrade();
+    }
+    
+    // Upgrade-Anfrage; Antwort wird in Blöcken gelesen
+    String key = generateWebSocketKey();
+    expectedAccept = computeAcceptKey(key);
+    String request = createWebSocketHandshake(key);
+    return transportWrite((const uint8_t*)request.c_str(), request.length()) == request.length();
+}
+
+bool WebSocketClient::sendSnapshotUpgrade() {
+    // Gespeicherte Anfrage mit frischem Schlüssel (RFC 6455 verlangt ihn pro Verbindung)
+    String key = generateWebSocketKey();
+    expectedAccept = computeAcceptKey(key);
+    size_t length = rtcSnapshot.upgradeLength;
+    memcpy(txBuffer, rtcSnapshot.upgrade, length);
+    memcpy(txBuffer + rtcSnapshot.keyOffset, key.c_str(), WS_KEY_LENGTH);
+    
+    // Mit Zusage des Servers das Hello direkt dahinter: ein Segment bzw. ein
+    // TLS-Record, 101 und session kommen zusammen zurück
+    if (serverPipelining) {
+        uint32_t maskWord = esp_random();
+        uint8_t maskKey[4];
+        memcpy(maskKey, &maskWord, sizeof(maskKey));
+        length += wsBuildFrameHeader(txBuffer + length, rtcSnapshot.helloLength, WS_OPCODE_TEXT, maskKey);
+        wsMaskPayload(txBuffer + length, (const uint8_t*)rtcSnapshot.hello, rtcSnapshot.helloLength, maskKey, 0);
+        length += rtcSnapshot.helloLength;
+        earlyData = true;
+    }
+    return transportWrite(txBuffer, length) == length;
+}
+
+size_t WebSocketClient::readHandshakeResponse(size_t& frameOffset) {
+    int available = transportAvailable();
+    if (available <= 0) {
+        return 0;
+    }
+    
+    int bytesRead = transportRead(frameBuffer, min((size_t)available, frameBufferSize));
+    if (bytesRead <= 0) {
+        return 0;
+    }
+    
+    // Header-Ende suchen; was danach kommt, sind bereits WebSocket-Frames
+    static const char terminator[] = "\r\n\r\n";
+    size_t headerBytes = bytesRead;
+    for (int i = 0; i < bytesRead; i++) {
+        if (frameBuffer[i] == terminator[handshakeMatch]) {
+            handshakeMatch++;
+        } else {
+            handshakeMatch = frameBuffer[i] == '\r' ? 1 : 0;
+        }
+        if (handshakeMatch == 4) {
+            headerBytes = i + 1;
+            break;
+        }
+    }
+    
+    handshakeResponse.concat((const char*)frameBuffer, min(headerBytes, (size_t)WS_HANDSHAKE_MAX_SIZE + 1));
+    frameOffset = headerBytes;
+    return bytesRead;
+}
+
+bool WebSocketClient::validateUpgradeResponse() {
+    // Statuszeile: HTTP/1.1 101
+    int lineEnd = handshakeResponse.indexOf("\r\n");
+    String statusLine = handshakeResponse.substring(0, lineEnd);
+    if (!statusLine.startsWith("HTTP/1.1 101")) {
+        Serial.printf("WebSocketClient: Unerwartete Antwort: %s\n", statusLine.c_str());
+        return false;
+    }
+    
+    bool upgradeOk = false;
+    bool connectionOk = false;
+    bool acceptOk = false;
+    
+    // Header-Zeilen "Name: Wert", Namen ohne Beachtung der Groß-/Kleinschreibung
+    while (lineEnd >= 0) {
+        int lineStart = lineEnd + 2;
+        lineEnd = handshakeResponse.indexOf("\r\n", lineStart);
+        if (lineEnd < 0 || lineEnd == lineStart) {
+            break;
+        }
+        
+        String line = handshakeResponse.substring(lineStart, lineEnd);
+        int colon = line.indexOf(':');
+        if (colon <= 0) {
+            continue;
+        }
+        String name = line.substring(0, colon);
+        String value = line.substring(colon + 1);
+        name.trim();
+        value.trim();
+        
+        if (name.equalsIgnoreCase("Upgrade")) {
+            upgradeOk = value.equalsIgnoreCase("websocket");
+        } else if (name.equalsIgnoreCase("Connection")) {
+            value.toLowerCase();
+            connectionOk = value.indexOf("upgrade") >= 0;
+        } else if (name.equalsIgnoreCase("Sec-WebSocket-Accept")) {
+            acceptOk = value == expectedAccept;
+        }
+    }
+    
+    if (!upgradeOk || !connectionOk || !acceptOk) {
+        Serial.printf("WebSocketClient: Ungültige Upgrade-Header (Upgrade %d, Connection %d, Accept %d)\n",
+                      upgradeOk, connectionOk, acceptOk);
+        return false;
+    }
+    return true;
+}
+
+void WebSocketClient::openConnection() {
+    Serial.printf("WebSocketClient: WebSocket-Handshake erfolgreich (%lu ms)\n", millis() - connectStartTime);
+    
+    // Reconnect: Ausfallzeit erfassen; wartet Audio, wird auch die Zeit bis
+    // zum ersten gesendeten Frame gemessen
+    if (linkDownTime != 0) {
+        reconnectStats.reconnects++;
+        reconnectStats.lastOutageMs = millis() - linkDownTime;
+        streamResumePending = !audioTx.isEmpty() ||
+            (audioManager && (audioManager->isRecording() || audioManager->hasPreRollData()));
+        if (!streamResumePending) {
+            linkDownTime = 0;
+        }
+    }
+    reconnectDelay = 0;
+    
+    if (wakeTiming.upgradedUs == 0) {
+        wakeTiming.upgradedUs = (uint32_t)esp_timer_get_time();
+    }
+    
+    // Identifikation bzw. Fortsetzung zuerst: Steuer-Queue geht der während
+    // des Aufbaus eingereihten Audio-Queue vor. Das Hello aus dem Snapshot ist
+    // bei Pipelining schon gesendet.
+    if (snapshotArmed) {
+        if (!earlyData) {
+            enqueueControl(WS_OPCODE_TEXT, (const uint8_t*)rtcSnapshot.hello, rtcSnapshot.helloLength);
+        }
+        resumePending = rtcSnapshot.resume;
+        snapshotArmed = false;
+        earlyData = false;
+    } else if (sessionToken.length() > 0) {
+        resumePending = true;
+        sendResume();
+    } else {
+        sendIdentification();
+    }
+    
+    // Initiale Credits, damit der Server Audio senden darf
+    sendFlowCredit();
+    
+    if (eventCallback) {
+        eventCallback(WebSocketStatus::CONNECTED);
+    }
+}
+
+unsigned long WebSocketClient::backoffDelay(int attempt) {
+    // Verdoppeln bis zur Obergrenze, dann zufällig aus [d/2, d], damit viele
+    // Geräte nach einem Server-Neustart nicht gleichzeitig verbinden
+    unsigned long delayMs = WS_RECONNECT_BASE_MS;
+    for (int i = 0; i < attempt && delayMs < WS_RECONNECT_MAX_MS; i++) {
+        delayMs *= 2;
+    }
+    delayMs = min(delayMs, (unsigned long)WS_RECONNECT_MAX_MS);
+    return delayMs / 2 + esp_random() % (delayMs / 2 + 1);
+}
+
+void WebSocketClient::markLinkDown() {
+    if (linkDownTime == 0) {
+        linkDownTime = millis();
+    }
+    streamResumePending = false;
+    resumePending = false;
+    
+    // Kodierung wird pro Verbindung neu ausgehandelt; ab hier Eingereihtes
+    // entsteht als JSON, älteres TLV kodiert sendNextFrame um
+    tlvRx = false;
+    tlvTx = false;
+    
+    // RTP gehört zur Verbindung, nach dem Reconnect handelt der Server neu aus
+    rtp.stop();
+}
+
+void WebSocketClient::failConnect(const char* reason) {
+    Serial.printf("WebSocketClient: %s\n", reason);
+    lastError = reason;
+    
+    if (xSemaphoreTake(webSocketMutex, pdMS_TO_TICKS(WS_TX_LOCK_TIMEOUT_MS)) != pdTRUE) {
+        return;
+    }
+    
+    if (connectSocket >= 0) {
+        close(connectSocket);
+        connectSocket = -1;
+    }
+    tls.stop();
+    if (wifiClient) {
+        wifiClient->stop();
+    }
+    connectPhase = ConnectPhase::NONE;
+    wsConnected = false;
+    markLinkDown();
+    
+    // Schnellweg gescheitert: Snapshot verwerfen, weitere Versuche auf dem normalen Weg
+    if (snapshotArmed) {
+        snapshotArmed = false;
+        earlyData = false;
+        rtcSnapshot.magic = 0;
+    }
+    
+    // Eingereihte Frames bleiben für den nächsten Versuch; neue lehnt
+    // sendAudio ab, der AudioManager puffert dann im Pre-Roll
+    currentStatus = WebSocketStatus::DISCONNECTED;
+    
+    xSemaphoreGive(webSocketMutex);
+    
+    if (eventCallback) {
+        eventCallback(WebSocketStatus::DISCONNECTED);
+    }
+}
+
+// =============================================================================
+// MANAGER-INTEGRATION
+// =============================================================================
+
+void WebSocketClient::setAudioManager(AudioManager* manager) {
+    audioManager = manager;
+}
+
+void WebSocketClient::setCommandRegistry(CommandRegistry* registry) {
+    commandRegistry = registry;
 }
 
 // =============================================================================
@@ -700,28 +2187,262 @@ void WebSocketClient::sendAudioData(const uint8_t* data, size_t size) {
     }
 }
 
-void WebSocketClient::readWebSocketFrames() {
-    if (!wifiClient || !wifiClient->connected()) {
-        return;
-    }
+size_t WebSocketClient::readWebSocketFrames() {
+    size_t total = 0;
     
-    // Vereinfachte WebSocket-Frame-Verarbeitung
-    if (wifiClient->available()) {
-        uint8_t byte = wifiClient->read();
+    // Blockweise lesen, Budget begrenzt die Zeit pro Durchlauf
+    while (total < WS_RX_BUDGET_BYTES && transportConnected()) {
+        int available = transportAvailable();
+        if (available <= 0) {
+            break;
+        }
         
-        // Einfache Text-Nachrichten verarbeiten
-        if (byte >= 32 && byte <= 126) { // Druckbare ASCII-Zeichen
-            messageBuffer += (char)byte;
+        size_t consumed = 0;
+        bool binaryPayload = parser.inMessagePayload() && parser.getMessageOpcode() == WS_OPCODE_BINARY;
+        if (binaryPayload && rxMessageKind == WS_KIND_AUDIO && !parser.isMasked() && audioManager) {
+            // Audio-Nutzdaten direkt in den Wiedergabe-Puffer lesen
+            size_t remaining = (size_t)min((uint64_t)available, parser.payloadRemaining());
+            consumed = readBinaryPayload(remaining);
+        }
+        
+        if (consumed == 0) {
+            // Header nur bis zu seinem Ende und Nutzdaten nur bis zum Frame-Ende
+            // lesen, damit der nächste Binär-Frame den direkten Weg nehmen kann
+            // Im TLV-Modus zuerst nur das Kind-Byte, danach entscheidet es den Weg
+            size_t wanted = parser.inHeader()
+                ? parser.headerRemaining()
+                : (binaryPayload && rxMessageKind == WS_KIND_UNKNOWN)
+                ? 1
+                : (size_t)min((uint64_t)frameBufferSize, parser.payloadRemaining());
             
-            if (messageBuffer.endsWith("}")) {
-                // Vollständige JSON-Nachricht empfangen
-                processMessage(messageBuffer);
-                messageBuffer = "";
+            int bytesRead = transportRead(frameBuffer, min((size_t)available, wanted));
+            if (bytesRead <= 0) {
+                break;
+            }
+            consumed = bytesRead;
+            parseFrameData(frameBuffer, bytesRead);
+        }
+        
+        total += consumed;
+        lastActivity = millis();
+    }
+    
+    return total;
+}
+
+int WebSocketClient::transportAvailable() {
+    return tlsEnabled ? tls.available() : wifiClient->available();
+}
+
+int WebSocketClient::transportRead(uint8_t* buffer, size_t length) {
+    return tlsEnabled ? tls.read(buffer, length) : wifiClient->read(buffer, length);
+}
+
+size_t WebSocketClient::transportWrite(const uint8_t* data, size_t length) {
+    return tlsEnabled ? tls.write(data, length) : wifiClient->write(data, length);
+}
+
+bool WebSocketClient::transportConnected() const {
+    // Bei TLS auch nach close_notify bzw. Record-Fehler getrennt
+    return wifiClient && wifiClient->connected() && (!tlsEnabled || tls.isConnected());
+}
+
+size_t WebSocketClient::readRtpPackets() {
+    // Datagramme einzeln an die Wiedergabe; verlorene hinterlassen nur eine Lücke
+    size_t total = 0;
+    const uint8_t* payload;
+    size_t length;
+    while (total < WS_RX_BUDGET_BYTES && (length = rtp.receive(payload)) > 0) {
+        processBinaryMessage((uint8_t*)payload, length);
+        total += length;
+    }
+    if (total > 0) {
+        lastActivity = millis();
+    }
+    return total;
+}
+
+size_t WebSocketClient::readBinaryPayload(size_t maxBytes) {
+    // Puffer voll: 0 zurückgeben, der Aufrufer nimmt den Weg über frameBuffer
+    // (playChunk zählt die Bytes dann als verworfen)
+    PlayoutReservation reservation;
+    if (!audioManager->reservePlayout(maxBytes, reservation)) {
+        return 0;
+    }
+    
+    size_t received = 0;
+    for (int i = 0; i < 2 && reservation.length[i] > 0; i++) {
+        int bytesRead = transportRead(reservation.segment[i], reservation.length[i]);
+        if (bytesRead <= 0) {
+            break;
+        }
+        received += bytesRead;
+        if ((size_t)bytesRead < reservation.length[i]) {
+            break;
+        }
+    }
+    
+    audioManager->commitPlayout(reservation, received);
+    
+    parser.consumePayload(received);
+    return received;
+}
+
+// =============================================================================
+// FRAME-PARSER (RFC 6455)
+// =============================================================================
+
+void WebSocketClient::resetFrameParser() {
+    parser.reset();
+    rxMessageKind = WS_KIND_UNKNOWN;
+    rxTlvLength = 0;
+    messageBuffer = "";
+    messageBufferFull = false;
+}
+
+void WebSocketClient::parseFrameData(uint8_t* data, size_t length) {
+    parser.parse(data, length);
+}
+
+void WebSocketClient::beginMessage(uint8_t opcode, uint64_t payloadLength) {
+    rxMessageKind = tlvRx ? WS_KIND_UNKNOWN : WS_KIND_AUDIO;
+    rxTlvLength = 0;
+    if (opcode == WS_OPCODE_TEXT) {
+        messageBuffer = "";
+        messageBufferFull = payloadLength > WS_MAX_TEXT_MESSAGE_SIZE;
+        if (!messageBufferFull) {
+            messageBuffer.reserve(payloadLength);
+        }
+    }
+}
+
+void WebSocketClient::handleMessageData(uint8_t opcode, const uint8_t* data, size_t length) {
+    if (opcode == WS_OPCODE_BINARY) {
+        if (rxMessageKind == WS_KIND_UNKNOWN) {
+            // TLV-Modus: erstes Byte der Nachricht ist der Kanal. Bulk vom Server
+            // hat noch keinen Empfänger und wird wie unbekannte Kanäle verworfen.
+            rxMessageKind = data[0];
+            data++;
+            length--;
+        }
+        
+        if (rxMessageKind == WS_KIND_AUDIO) {
+            // Audio direkt an die Wiedergabe, ohne die Nachricht zusammenzusetzen
+            if (length > 0) {
+                processBinaryMessage((uint8_t*)data, length);
             }
+        } else if ((rxMessageKind == WS_KIND_CONTROL || rxMessageKind == WS_KIND_TELEMETRY) &&
+                   rxTlvLength <= WS_TLV_MAX_SIZE) {
+            if (rxTlvLength + length > WS_TLV_MAX_SIZE) {
+                rxTlvLength = WS_TLV_MAX_SIZE + 1;
+            } else {
+                memcpy(rxTlv + rxTlvLength, data, length);
+                rxTlvLength += length;
+            }
+        }
+    } else if (!messageBufferFull) {
+        if (messageBuffer.length() + length > WS_MAX_TEXT_MESSAGE_SIZE) {
+            messageBufferFull = true;
+            messageBuffer = "";
+        } else {
+            messageBuffer.concat((const char*)data, length);
         }
     }
 }
 
+void WebSocketClient::finishMessage(uint8_t opcode) {
+    if (opcode == WS_OPCODE_TEXT) {
+        if (messageBufferFull) {
+            Serial.println("WebSocketClient: Text-Nachricht zu groß, verworfen");
+        } else {
+            processMessage(messageBuffer);
+        }
+        messageBuffer = "";
+        messageBufferFull = false;
+    } else if (opcode == WS_OPCODE_BINARY &&
+               (rxMessageKind == WS_KIND_CONTROL || rxMessageKind == WS_KIND_TELEMETRY)) {
+        if (rxTlvLength > WS_TLV_MAX_SIZE) {
+            Serial.println("WebSocketClient: TLV-Nachricht zu groß, verworfen");
+        } else {
+            processControlMessage(rxTlv, rxTlvLength);
+        }
+    }
+    rxMessageKind = WS_KIND_UNKNOWN;
+}
+
+// Empfänger des Parsers; nach einem Close bzw. Abbruch bleibt der Rest des
+// Lesepuffers unausgewertet
+
+void WebSocketClient::onMessageBegin(void* context, uint8_t opcode, uint64_t payloadLength) {
+    ((WebSocketClient*)context)->beginMessage(opcode, payloadLength);
+}
+
+void WebSocketClient::onMessageData(void* context, uint8_t opcode, const uint8_t* data, size_t length) {
+    ((WebSocketClient*)context)->handleMessageData(opcode, data, length);
+}
+
+void WebSocketClient::onMessageEnd(void* context, uint8_t opcode) {
+    WebSocketClient* client = (WebSocketClient*)context;
+    client->finishMessage(opcode);
+    if (!client->wsConnected) {
+        client->parser.stop();
+    }
+}
+
+void WebSocketClient::onControlFrame(void* context, uint8_t opcode, const uint8_t* payload, size_t length) {
+    WebSocketClient* client = (WebSocketClient*)context;
+    client->handleControlFrame(opcode, payload, length);
+    if (!client->wsConnected) {
+        client->parser.stop();
+    }
+}
+
+void WebSocketClient::onProtocolError(void* context, uint16_t closeCode, const char* reason) {
+    ((WebSocketClient*)context)->failConnection(closeCode, reason);
+}
+
+void WebSocketClient::handleControlFrame(uint8_t opcode, const uint8_t* payload, size_t length) {
+    switch (opcode) {
+        case WS_OPCODE_PING:
+            sendControlFrame(WS_OPCODE_PONG, payload, length);
+            break;
+        case WS_OPCODE_PONG:
+            lastActivity = millis();
+            linkMonitor.recordPong(payload, length, esp_timer_get_time());
+            break;
+        case WS_OPCODE_CLOSE: {
+            uint16_t code = length >= 2 ? (payload[0] << 8) | payload[1] : 1005;
+            Serial.printf("WebSocketClient: Close-Frame vom Server (%u)\n", code);
+            
+            // Statuscode zurückschicken und TCP-Verbindung schließen
+            sendControlFrame(WS_OPCODE_CLOSE, payload, length >= 2 ? 2 : 0);
+            disconnect();
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void WebSocketClient::failConnection(uint16_t closeCode, const char* reason) {
+    Serial.printf("WebSocketClient: Protokollfehler: %s\n", reason);
+    lastError = reason;
+    
+    uint8_t payload[2] = { (uint8_t)(closeCode >> 8), (uint8_t)(closeCode & 0xFF) };
+    sendControlFrame(WS_OPCODE_CLOSE, payload, sizeof(payload));
+    disconnect();
+}
+
+bool WebSocketClient::sendControlFrame(uint8_t opcode, const uint8_t* payload, size_t length) {
+    if (xSemaphoreTake(webSocketMutex, pdMS_TO_TICKS(10)) != pdTRUE) {
+        return false;
+    }
+    
+    bool result = sendWebSocketFrame((const char*)payload, length, opcode);
+    xSemaphoreGive(webSocketMutex);
+    return result;
+}
+
 // =============================================================================
 // FEHLENDE MEMBER-VARIABLEN IN HEADER HINZUFÜGEN
 // =============================================================================
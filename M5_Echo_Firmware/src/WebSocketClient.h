@@ -9,6 +9,17 @@
 #include <freertos/queue.h>
 #include <freertos/semphr.h>
 #include "config.h"
+#include "TxQueue.h"
+#include "LinkMonitor.h"
+#include "ControlProtocol.h"
+#include "JsonWriter.h"
+#include "TlsTransport.h"
+#include "RtpTransport.h"
+#include "AudioPacketizer.h"
+#include "WebSocketFrame.h"
+
+class AudioManager;
+class CommandRegistry;
 
 // WebSocket-Verbindungsstatus
 enum class WebSocketStatus {
@@ -19,6 +30,14 @@ enum class WebSocketStatus {
     ERROR            // Fehler aufgetreten
 };
 
+// Phase des Verbindungsaufbaus (nicht blockierend, Netzwerk-Task)
+enum class ConnectPhase {
+    NONE,           // Kein Aufbau aktiv
+    TCP,            // connect() läuft, warten auf Beschreibbarkeit
+    TLS,            // TLS-Handshake (nur wss://), Schritte bei lesbarem Socket
+    UPGRADE         // HTTP-Upgrade gesendet, warten auf 101-Antwort
+};
+
 // WebSocket-Nachrichten-Typen
 enum class MessageType {
     IDENTIFICATION,  // Client-Identifikation
@@ -28,9 +47,43 @@ enum class MessageType {
     CONFIG,         // Konfiguration
     OTA,            // OTA-Update
     HEARTBEAT,      // Herzschlag
+    SESSION,        // Sitzungs-Token vom Server
+    ENCODING,       // Umschaltung der Steuer-Kodierung (JSON/TLV)
+    TRANSPORT,      // Audio-Transport (WebSocket oder RTP/UDP)
     UNKNOWN         // Unbekannte Nachricht
 };
 
+// Kennzahlen der Netzwerk-Task
+struct NetworkLoopStats {
+    uint32_t wakeups;               // Rückkehr aus select()
+    uint32_t socketWakeups;         // Socket lesbar
+    uint32_t txWakeups;             // Sende-Benachrichtigung
+    uint32_t timerWakeups;          // Timeout (Reconnect, Heartbeat, Credits)
+    uint32_t commands;              // Verarbeitete Server-Nachrichten
+    uint32_t avgCommandLatencyUs;   // Aufwachen bis Nachricht verarbeitet, geglättet
+    uint32_t maxCommandLatencyUs;
+};
+
+// Zeiten ab Start der Firmware (nach dem Deep Sleep = Wakeup), erste Verbindung
+struct WakeTiming {
+    uint32_t tcpConnectedUs;
+    uint32_t upgradedUs;            // 101-Antwort verarbeitet
+    uint32_t firstUplinkUs;         // Erstes Audio im Socket
+    uint32_t previousFirstUplinkUs; // Voriger Wakeup, 0 = unbekannt
+    bool snapshot;                  // Dieser Wakeup nutzte den Verbindungs-Snapshot
+    bool previousSnapshot;
+};
+
+// Wiederverbindung und Sitzungsfortsetzung
+struct ReconnectStats {
+    uint32_t attempts;              // Verbindungsversuche gesamt
+    uint32_t reconnects;            // Erfolgreich nach Verbindungsverlust
+    uint32_t resumed;               // Davon mit fortgesetzter Sitzung
+    uint32_t lastOutageMs;          // Verbindungsverlust bis Handshake
+    uint32_t lastReconnectToStreamMs;   // Verbindungsverlust bis erstes Audio auf dem Socket
+    uint32_t maxReconnectToStreamMs;
+};
+
 // WebSocket-Nachricht
 struct WebSocketMessage {
     MessageType type;
@@ -40,14 +93,15 @@ struct WebSocketMessage {
     uint8_t* binaryData;
 };
 
-    // AudioChunk wird aus AudioManager.h verwendet
-
 // Callback-Funktionen für Events
 typedef void (*WebSocketEventCallback)(WebSocketStatus status);
 typedef void (*WebSocketMessageCallback)(const WebSocketMessage& message);
 typedef void (*WebSocketAudioCallback)(const uint8_t* data, size_t length);
 
 class WebSocketClient {
+    // Stream- und Clip-Befehle brauchen den Sendepfad des Clients
+    friend class CommandRegistry;
+    
 private:
     WebSocketStatus currentStatus;
     
@@ -60,9 +114,26 @@ private:
     // Verbindungsverwaltung
     unsigned long lastReconnectAttempt;
     unsigned long lastHeartbeat;
+    unsigned long lastPingTime;
+    LinkMonitor linkMonitor;
     int reconnectAttempts;
+    unsigned long reconnectDelay;   // Gejitterte Wartezeit bis zum nächsten Versuch
     bool autoReconnect;
     
+    // Sitzung: Token vom Server, Uplink-Sequenz läuft über Reconnects weiter
+    String sessionToken;
+    bool resumePending;             // resume gesendet, Antwort steht aus
+    volatile uint32_t uplinkSeq;    // Gesendete Audio-Frames
+    unsigned long linkDownTime;     // Zeitpunkt des Verbindungsverlusts, 0 = verbunden
+    bool streamResumePending;       // Erstes Audio nach Reconnect noch nicht gesendet
+    ReconnectStats reconnectStats;
+    
+    // Schnellweg nach dem Deep Sleep
+    bool serverPipelining;          // Server nimmt Frames direkt hinter der Upgrade-Anfrage an
+    bool snapshotArmed;             // Nächster Aufbau nutzt den Snapshot
+    bool earlyData;                 // Upgrade und Hello in einem Flug, 101 steht aus
+    WakeTiming wakeTiming;
+    
     // Callback-Funktionen
     WebSocketEventCallback eventCallback;
     WebSocketMessageCallback messageCallback;
@@ -74,8 +145,8 @@ private:
     
     // FreeRTOS-Tasks und Synchronisation
     TaskHandle_t webSocketTaskHandle;
+    int txEventFd;                  // eventfd: weckt die Netzwerk-Task zum Senden
     QueueHandle_t messageQueue;
-    QueueHandle_t audioQueue;
     SemaphoreHandle_t webSocketMutex;
     
     // Debug und Status
@@ -84,32 +155,150 @@ private:
     String lastError;
     
     // WebSocket-spezifische Variablen
-    WiFiClient* wifiClient;
+    WiFiClient* wifiClient;         // Besitzt den Socket; bei TLS nur für connected()/fd()/stop()
+    TlsTransport tls;
+    bool tlsEnabled;
+    const char* tlsCaCert;
+    const char* tlsPinSha256;
+    RtpTransport rtp;               // Audio über UDP, solange der Server es aushandelt
+    uint32_t serverIp;              // Aufgelöste Server-Adresse, Ziel für RTP
+    uint32_t serverAddressHint;     // Bekannte Adresse zu serverHost (DNS-SD), 0 = auflösen
+    String pendingServerHost;       // Per DNS-SD gefunden, gilt ab dem nächsten Verbindungsversuch
+    int pendingServerPort;
+    uint32_t pendingServerAddress;
+    bool pendingServer;
     uint8_t* frameBuffer;
     size_t frameBufferSize;
+    uint8_t* txBuffer;              // Header + maskierte Nutzdaten (geschützt durch webSocketMutex)
+    TxQueue controlTx;              // Steuer-Nachrichten (JSON bzw. TLV), überdauern Reconnects
+    TxQueue audioTx;                // Mikrofon-Audio, Policy WS_TX_AUDIO_POLICY
+    TxQueue telemetryTx;            // Heartbeat und Fortschritt, älteste werden verworfen
+    TxQueue bulkTx;                 // Große Übertragungen, nur im TLV-Modus
+    AudioPacketizer audioPacketizer;    // Bündelt Mikrofon-Audio zu Frames für audioTx
+    
+    // Gewichtetes Round-Robin über Audio, Telemetrie und Bulk
+    uint8_t schedIndex;             // Aktueller Kanal der Runde
+    uint8_t schedCredit;            // Verbleibende Frames des Kanals in dieser Runde
+    
+    // Verbindungsaufbau
+    ConnectPhase connectPhase;
+    volatile bool connectRequested;
+    int connectSocket;              // Nicht blockierender Socket bis zum TCP-Connect
+    unsigned long connectStartTime;
+    String expectedAccept;          // Sec-WebSocket-Accept zum gesendeten Key
+    String handshakeResponse;       // Header der Upgrade-Antwort
+    uint8_t handshakeMatch;         // Bereits gefundene Zeichen von "\r\n\r\n"
+    
+    // Steuer-Kodierung: pro Richtung ab der encoding-Nachricht TLV statt JSON,
+    // gilt nur für die aktuelle Verbindung. tlvTx wechselt mit dem Senden der
+    // Bestätigung; eingereihte TLV-Nachrichten werden beim Senden nach JSON
+    // umkodiert, solange der Server JSON erwartet.
+    volatile bool tlvRx;            // Server sendet Binär-Frames mit Kind-Byte
+    volatile bool tlvTx;            // Client sendet Ereignisse/Credits als TLV, Audio mit Kind-Byte
+    char jsonBuffer[WS_TLV_JSON_SIZE];  // Umkodierte TLV-Nachricht (nur Netzwerk-Task)
+    
+    // Netzwerk-Task
+    NetworkLoopStats loopStats;
+    int64_t rxWakeUs;               // Aufwachen mit lesbarem Socket
     bool wsConnected;
+    FrameParser parser;
+    uint8_t rxMessageKind;          // Kind-Byte der Binär-Nachricht (TLV-Modus), WS_KIND_UNKNOWN = noch offen
+    uint8_t rxTlv[WS_TLV_MAX_SIZE]; // Binäre Steuer-Nachricht ohne Kind-Byte
+    size_t rxTlvLength;             // > WS_TLV_MAX_SIZE: zu groß, wird verworfen
+    
+    // Manager-Integration
+    AudioManager* audioManager;
+    CommandRegistry* commandRegistry;   // Server-Befehle an die Manager
+    
+    // Downlink-Flusskontrolle (zuletzt gemeldeter Credit-Stand)
+    uint32_t lastCreditLimit;
+    uint32_t lastCreditDrops;
+    unsigned long lastCreditTime;
     
     // Private Methoden
     void processMessage(const String& message);
     void processBinaryMessage(uint8_t* data, size_t length);
     MessageType parseMessageType(const String& message);
-    String createIdentificationMessage();
-    String createEventMessage(const String& eventType);
+    void writeIdentificationMessage(JsonWriter& json, bool withTimestamp = true);
+    void writeResumeMessage(JsonWriter& json, bool withTimestamp = true);
     
     // FreeRTOS-Task-Funktionen
     static void webSocketTask(void* parameter);
+    uint32_t nextWakeupMs();
+    void serviceConnect();
+    void waitForWork(uint32_t timeoutMs);
+    void recordCommandLatency();
+    
+    // Sende-Queues
+    void wakeNetworkTask();
+    bool sendNextFrame();
+    TxQueue* nextQueue();
+    bool enqueueControl(uint8_t opcode, const uint8_t* data, size_t length);
+    TxSlot* reserveSlot(TxQueue& queue, uint32_t& ticket);
+    bool commitSlot(TxQueue& queue, TxSlot* slot, uint32_t ticket, uint8_t opcode, size_t length);
+    bool commitJson(TxQueue& queue, TxSlot* slot, uint32_t ticket, const JsonWriter& json);
     
     // Nachrichtenverarbeitung
     void processCommand(const String& message);
     void processConfig(const String& message);
     void processOTA(const String& message);
+    void processSession(const String& message);
+    void processEncoding(const String& message);
+    void processTransport(const String& message);
+    void processControlMessage(const uint8_t* data, size_t length);
+    void applySession(const char* token, bool resumed, bool pipelining);
+    unsigned long backoffDelay(int attempt);
+    void markLinkDown();
+    void handleStartStream();
+    void handleStopStream();
+    void handleQueueClip(uint32_t clipId, const char* source, uint16_t crossfadeMs, uint32_t length,
+                         const char* name, const char* url);
+    void updateFlowCredit();
+    void reportUplinkConfig();
+    
+    // Verbindungsaufbau
+    void requestConnectLocked(const String& host, int port, uint32_t address);
+    bool startConnect(uint32_t address);
+    bool checkTcpConnected();
+    bool sendUpgradeRequest();
+    bool sendSnapshotUpgrade();
+    size_t readHandshakeResponse(size_t& frameOffset);
+    bool validateUpgradeResponse();
+    void openConnection();
+    void failConnect(const char* reason);
     
     // WebSocket-spezifische Methoden
-    String createWebSocketHandshake();
+    String createWebSocketHandshake(const String& key);
     String generateWebSocketKey();
-    String base64Encode(const String& input);
-    bool sendWebSocketFrame(const char* data, size_t length, uint8_t opcode);
-    void readWebSocketFrames();
+    static String computeAcceptKey(const String& key);
+    static String base64Encode(const uint8_t* data, size_t length);
+    bool sendWebSocketFrame(const char* data, size_t length, uint8_t opcode, int kind = -1);
+    static size_t writeTransport(void* context, const uint8_t* data, size_t length);
+    size_t readWebSocketFrames();
+    size_t readRtpPackets();
+    void recordFirstUplink();
+    
+    // Socket-Zugriff, bei wss:// über TLS
+    int transportAvailable();
+    int transportRead(uint8_t* buffer, size_t length);
+    size_t transportWrite(const uint8_t* data, size_t length);
+    bool transportConnected() const;
+    size_t readBinaryPayload(size_t maxBytes);
+    
+    // Frame-Parser (WebSocketFrame.h) und seine Empfänger
+    void resetFrameParser();
+    void parseFrameData(uint8_t* data, size_t length);
+    void beginMessage(uint8_t opcode, uint64_t payloadLength);
+    void handleMessageData(uint8_t opcode, const uint8_t* data, size_t length);
+    void finishMessage(uint8_t opcode);
+    void handleControlFrame(uint8_t opcode, const uint8_t* payload, size_t length);
+    static void onMessageBegin(void* context, uint8_t opcode, uint64_t payloadLength);
+    static void onMessageData(void* context, uint8_t opcode, const uint8_t* data, size_t length);
+    static void onMessageEnd(void* context, uint8_t opcode);
+    static void onControlFrame(void* context, uint8_t opcode, const uint8_t* payload, size_t length);
+    static void onProtocolError(void* context, uint16_t closeCode, const char* reason);
+    void failConnection(uint16_t closeCode, const char* reason);
+    bool sendControlFrame(uint8_t opcode, const uint8_t* payload, size_t length);
 
 public:
     // Konstruktor & Destruktor
@@ -122,24 +311,44 @@ public:
     
     // Verbindungssteuerung
     bool connect(const String& host, int port);
+    // host für Host:, SNI und TLS-Prüfung; verbunden wird ohne Namensauflösung mit address
+    bool connect(const String& host, int port, const IPAddress& address);
     bool connect();
+    // Gefundenen Server nur im Zustand DISCONNECTED/ERROR sofort nutzen, sonst beim nächsten Versuch
+    bool useDiscoveredServer(const String& host, int port, const IPAddress& address);
     void disconnect();
     void reconnect();
     WebSocketStatus getStatus() const;
     
     // Server-Konfiguration
     void setServer(const String& host, int port);
+    void setTls(bool enabled, const char* caCert, const char* pinSha256 = nullptr);   // Vor begin(); CA-PEM und/oder Key-Pin, eines ist Pflicht
     void setClientId(const String& id);
     String getServerHost() const;
+    IPAddress getServerAddress() const;     // 0.0.0.0 = wird beim Connect aufgelöst
     int getServerPort() const;
     String getClientId() const;
     
     // Nachrichten senden
     bool sendMessage(const String& message);
-    bool sendEvent(const String& eventType);
+    // Ereignis mit typisierten Feldern, direkt im Sende-Slot kodiert (ohne Heap)
+    bool sendEvent(const char* eventType, const EventField* fields = nullptr, size_t count = 0);
+    template <size_t N>
+    bool sendEvent(const char* eventType, const EventField (&fields)[N]) {
+        return sendEvent(eventType, fields, N);
+    }
     bool sendAudio(const uint8_t* data, size_t length);
+    bool sendBulk(const uint8_t* data, size_t length);     // Nur im TLV-Modus, false bei voller Queue
     bool sendIdentification();
+    bool sendResume();
+    
+    // Verbindungs-Snapshot (RTC-Speicher): vor dem Deep Sleep sichern, nach
+    // dem Wakeup vor connect() laden. restoreSnapshot() setzt Server und Sitzung.
+    void saveSnapshot();
+    bool restoreSnapshot();
     bool sendHeartbeat();
+    bool sendFlowCredit();
+    bool sendPing();
     
     // Callback-Registrierung
     void setEventCallback(WebSocketEventCallback callback);
@@ -162,6 +371,20 @@ public:
     void printConnectionStatus();
     void printMessageStats();
     void enableDebug(bool enabled);
+    TxQueueStats getChannelStats(uint8_t channel) const;   // WS_KIND_*; Latenz = Head-of-Line-Verzögerung
+    NetworkLoopStats getLoopStats() const;
+    
+    // RTT/Jitter aus Ping/Pong (billig, aus jeder Task)
+    LinkQuality getLinkQuality() const;
+    TlsStats getTlsStats() const;
+    RtpStats getRtpStats() const;
+    PacketizerStats getPacketizerStats() const;
+    ReconnectStats getReconnectStats() const;
+    WakeTiming getWakeTiming() const;
+    
+    // Manager-Integration
+    void setAudioManager(AudioManager* manager);
+    void setCommandRegistry(CommandRegistry* registry);
     
     // Event-Integration
     void sendAudioData(const uint8_t* data, size_t size);
@@ -0,0 +1,274 @@
+#include "WebSocketFrame.h"
+
+// =============================================================================
+// KONSTRUKTOR
+// =============================================================================
+
+FrameParser::FrameParser() {
+    memset(&callbacks, 0, sizeof(callbacks));
+    reset();
+}
+
+void FrameParser::setCallbacks(const FrameCallbacks& callbacks) {
+    this->callbacks = callbacks;
+}
+
+void FrameParser::reset() {
+    state = FrameParseState::HEADER;
+    headerLength = 0;
+    headerNeeded = 2;
+    opcode = 0;
+    fin = false;
+    masked = false;
+    payloadLength = 0;
+    payloadOffset = 0;
+    messageOpcode = 0;
+    stopped = false;
+}
+
+// =============================================================================
+// PARSER
+// =============================================================================
+
+bool FrameParser::parse(uint8_t* data, size_t length) {
+    size_t offset = 0;
+    
+    while (offset < length && !stopped) {
+        if (state == FrameParseState::HEADER) {
+            header[headerLength++] = data[offset++];
+            
+            // Nach zwei Bytes steht die Header-Länge fest
+            if (headerLength == 2) {
+                uint8_t lengthCode = header[1] & 0x7F;
+                masked = (header[1] & 0x80) != 0;
+                headerNeeded = 2 + (lengthCode == 126 ? 2 : lengthCode == 127 ? 8 : 0) + (masked ? 4 : 0);
+            }
+            
+            if (headerLength >= 2 && headerLength == headerNeeded) {
+                if (!beginFrame()) {
+                    return false;
+                }
+                if (payloadLength == 0) {
+                    finishFrame();
+                }
+            }
+            continue;
+        }
+        
+        // Nutzdaten: so viel wie vorhanden am Stück verarbeiten
+        size_t chunk = (size_t)min((uint64_t)(length - offset), payloadLength - payloadOffset);
+        uint8_t* payload = data + offset;
+        
+        if (masked) {
+            wsMaskPayload(payload, payload, chunk, maskKey, (size_t)payloadOffset);
+        }
+        
+        if (opcode & 0x08) {
+            memcpy(control + payloadOffset, payload, chunk);
+        } else if (chunk > 0 && callbacks.messageData) {
+            callbacks.messageData(callbacks.context, messageOpcode, payload, chunk);
+        }
+        payloadOffset += chunk;
+        offset += chunk;
+        
+        if (payloadOffset == payloadLength) {
+            finishFrame();
+        }
+    }
+    
+    return !stopped;
+}
+
+void FrameParser::consumePayload(size_t length) {
+    payloadOffset += length;
+    if (payloadOffset == payloadLength) {
+        finishFrame();
+    }
+}
+
+bool FrameParser::beginFrame() {
+    fin = (header[0] & 0x80) != 0;
+    opcode = header[0] & 0x0F;
+    
+    // Nutzdatenlänge (7 Bit, 16 Bit oder 64 Bit, Network Byte Order)
+    uint8_t lengthCode = header[1] & 0x7F;
+    size_t pos = 2;
+    if (lengthCode == 126) {
+        payloadLength = ((uint64_t)header[2] << 8) | header[3];
+        pos = 4;
+    } else if (lengthCode == 127) {
+        payloadLength = 0;
+        for (int i = 0; i < 8; i++) {
+            payloadLength = (payloadLength << 8) | header[2 + i];
+        }
+        pos = 10;
+    } else {
+        payloadLength = lengthCode;
+    }
+    if (masked) {
+        memcpy(maskKey, header + pos, 4);
+    }
+    payloadOffset = 0;
+    headerLength = 0;
+    headerNeeded = 2;
+    state = FrameParseState::PAYLOAD;
+    
+    // Keine Extensions ausgehandelt: RSV-Bits müssen 0 sein
+    if (header[0] & 0x70) {
+        return fail(1002, "RSV-Bits gesetzt");
+    }
+    
+    if (opcode & 0x08) {
+        // Control-Frames: nicht fragmentiert, höchstens 125 Bytes
+        if (!fin || payloadLength > 125) {
+            return fail(1002, "Ungültiger Control-Frame");
+        }
+        if (opcode != WS_OPCODE_CLOSE && opcode != WS_OPCODE_PING && opcode != WS_OPCODE_PONG) {
+            return fail(1002, "Unbekannter Control-Opcode");
+        }
+        return true;
+    }
+    
+    if (opcode == WS_OPCODE_CONTINUATION) {
+        if (messageOpcode == 0) {
+            return fail(1002, "Fortsetzung ohne Nachricht");
+        }
+    } else if (opcode == WS_OPCODE_TEXT || opcode == WS_OPCODE_BINARY) {
+        if (messageOpcode != 0) {
+            return fail(1002, "Neue Nachricht vor Ende der Fragmentierung");
+        }
+        messageOpcode = opcode;
+        if (callbacks.messageBegin) {
+            callbacks.messageBegin(callbacks.context, opcode, payloadLength);
+        }
+    } else {
+        return fail(1002, "Unbekannter Opcode");
+    }
+    
+    return !stopped;
+}
+
+void FrameParser::finishFrame() {
+    state = FrameParseState::HEADER;
+    
+    if (opcode & 0x08) {
+        if (callbacks.controlFrame) {
+            callbacks.controlFrame(callbacks.context, opcode, control, (size_t)payloadLength);
+        }
+        return;
+    }
+    
+    if (!fin) {
+        return; // Weitere Fragmente folgen
+    }
+    
+    uint8_t finished = messageOpcode;
+    messageOpcode = 0;
+    if (callbacks.messageEnd) {
+        callbacks.messageEnd(callbacks.context, finished);
+    }
+}
+
+bool FrameParser::fail(uint16_t closeCode, const char* reason) {
+    stopped = true;
+    if (callbacks.protocolError) {
+        callbacks.protocolError(callbacks.context, closeCode, reason);
+    }
+    return false;
+}
+
+// =============================================================================
+// CLIENT-FRAMES
+// =============================================================================
+
+size_t wsBuildFrameHeader(uint8_t* header, size_t length, uint8_t opcode, const uint8_t maskKey[4]) {
+    size_t headerLength = 0;
+    
+    // FIN + RSV + Opcode
+    header[headerLength++] = 0x80 | opcode;
+    
+    // Payload-Length mit gesetztem Mask-Bit
+    if (length < 126) {
+        header[headerLength++] = 0x80 | length;
+    } else if (length < 65536) {
+        header[headerLength++] = 0x80 | 126;
+        header[headerLength++] = (length >> 8) & 0xFF;
+        header[headerLength++] = length & 0xFF;
+    } else {
+        header[headerLength++] = 0x80 | 127;
+        for (int i = 7; i >= 0; i--) {
+            header[headerLength++] = ((uint64_t)length >> (i * 8)) & 0xFF;
+        }
+    }
+    
+    memcpy(header + headerLength, maskKey, 4);
+    return headerLength + 4;
+}
+
+void wsMaskPayload(uint8_t* dst, const uint8_t* src, size_t length, const uint8_t maskKey[4], size_t keyOffset) {
+    // Schlüssel passend zur Position im Frame rotieren
+    uint8_t key[4];
+    for (int i = 0; i < 4; i++) {
+        key[i] = maskKey[(keyOffset + i) & 3];
+    }
+    uint32_t keyWord;
+    memcpy(&keyWord, key, sizeof(keyWord));
+    
+    // 32 Bit pro Schritt; der Schlüssel wiederholt sich alle 4 Bytes, daher
+    // passt die Byte-Reihenfolge im Speicher unabhängig von der Endianness.
+    // memcpy statt Zeiger-Cast, da src nicht ausgerichtet sein muss.
+    size_t i = 0;
+    for (; i + 4 <= length; i += 4) {
+        uint32_t word;
+        memcpy(&word, src + i, sizeof(word));
+        word ^= keyWord;
+        memcpy(dst + i, &word, sizeof(word));
+    }
+    for (; i < length; i++) {
+        dst[i] = src[i] ^ key[i & 3];
+    }
+}
+
+bool wsWriteFrame(uint8_t* buffer, size_t bufferSize, const uint8_t* data, size_t length, uint8_t opcode,
+                  int kind, const uint8_t maskKey[4], FrameWriteFunction write, void* context) {
+    // Optionales Kind-Byte (TLV-Modus) wird erst hier vorangestellt, damit
+    // eingereihtes Audio unabhängig von der Kodierung bleibt
+    size_t prefixLength = kind >= 0 ? 1 : 0;
+    
+    // Header rechtsbündig vor die Nutzdaten, damit Frame und Daten zusammenhängen
+    uint8_t header[14];
+    size_t headerLength = wsBuildFrameHeader(header, prefixLength + length, opcode, maskKey);
+    uint8_t* payload = buffer + WS_FRAME_HEADROOM;
+    size_t capacity = bufferSize - WS_FRAME_HEADROOM;
+    
+    if (prefixLength + length <= capacity) {
+        // Regelfall: ein write() pro Frame, ein TCP-Segment pro Audio-Chunk
+        uint8_t* frame = payload - headerLength;
+        memcpy(frame, header, headerLength);
+        if (prefixLength) {
+            payload[0] = (uint8_t)kind ^ maskKey[0];
+        }
+        wsMaskPayload(payload + prefixLength, data, length, maskKey, prefixLength);
+        size_t frameLength = headerLength + prefixLength + length;
+        return write(context, frame, frameLength) == frameLength;
+    }
+    
+    // Übergroße Frames abschnittsweise maskieren und senden
+    if (write(context, header, headerLength) != headerLength) {
+        return false;
+    }
+    if (prefixLength) {
+        payload[0] = (uint8_t)kind ^ maskKey[0];
+        if (write(context, payload, 1) != 1) {
+            return false;
+        }
+    }
+    for (size_t offset = 0; offset < length; offset += capacity) {
+        size_t chunk = min(capacity, length - offset);
+        wsMaskPayload(payload, data + offset, chunk, maskKey, prefixLength + offset);
+        if (write(context, payload, chunk) != chunk) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,114 @@
+#ifndef WEB_SOCKET_FRAME_H
+#define WEB_SOCKET_FRAME_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// RFC-6455-Opcodes
+#define WS_OPCODE_CONTINUATION  0x00
+#define WS_OPCODE_TEXT          0x01
+#define WS_OPCODE_BINARY        0x02
+#define WS_OPCODE_CLOSE         0x08
+#define WS_OPCODE_PING          0x09
+#define WS_OPCODE_PONG          0x0A
+
+// Zustand des Frame-Parsers. Frames dürfen beliebig über Lesevorgänge
+// verteilt sein, Control-Frames dürfen fragmentierte Nachrichten unterbrechen.
+enum class FrameParseState {
+    HEADER,         // 2..14 Header-Bytes
+    PAYLOAD         // Nutzdaten
+};
+
+// Empfänger des Parsers. Alle Aufrufe kommen synchron aus parse() bzw.
+// consumePayload(); context wird unverändert durchgereicht.
+struct FrameCallbacks {
+    void* context;
+    
+    // Erstes Fragment einer Text- oder Binär-Nachricht
+    void (*messageBegin)(void* context, uint8_t opcode, uint64_t payloadLength);
+    
+    // Entmaskierte Nutzdaten der laufenden Nachricht, stückweise
+    void (*messageData)(void* context, uint8_t opcode, const uint8_t* data, size_t length);
+    
+    // Letztes Fragment vollständig
+    void (*messageEnd)(void* context, uint8_t opcode);
+    
+    // Vollständiger Control-Frame (Close, Ping, Pong)
+    void (*controlFrame)(void* context, uint8_t opcode, const uint8_t* payload, size_t length);
+    
+    // Protokollfehler; closeCode nach RFC 6455, 7.4.1. Danach ist der Parser gestoppt.
+    void (*protocolError)(void* context, uint16_t closeCode, const char* reason);
+};
+
+// Streamender Frame-Parser (RFC 6455) ohne eigene Puffer für Daten-Frames:
+// Nutzdaten gehen direkt aus dem Lesepuffer an den Empfänger.
+class FrameParser {
+private:
+    FrameCallbacks callbacks;
+    FrameParseState state;
+    uint8_t header[14];
+    size_t headerLength;        // Bereits gelesene Header-Bytes
+    size_t headerNeeded;        // Vollständige Header-Länge, sobald bekannt
+    uint8_t opcode;
+    bool fin;
+    bool masked;
+    uint8_t maskKey[4];
+    uint64_t payloadLength;
+    uint64_t payloadOffset;
+    uint8_t messageOpcode;      // Opcode der laufenden (fragmentierten) Nachricht, 0 = keine
+    uint8_t control[125];       // Nutzdaten des aktuellen Control-Frames
+    bool stopped;               // Protokollfehler oder stop(): keine weiteren Bytes bis reset()
+    
+    bool beginFrame();
+    void finishFrame();
+    bool fail(uint16_t closeCode, const char* reason);
+
+public:
+    FrameParser();
+    
+    void setCallbacks(const FrameCallbacks& callbacks);
+    
+    // Neue Verbindung
+    void reset();
+    
+    // Beliebig zerteilte Bytes vom Socket; maskierte Nutzdaten werden an Ort
+    // und Stelle entmaskiert. false, sobald der Parser gestoppt ist.
+    bool parse(uint8_t* data, size_t length);
+    
+    // Aus einem Callback: Rest des Puffers nicht mehr auswerten (z.B. nach Close)
+    void stop() { stopped = true; }
+    bool isStopped() const { return stopped; }
+    
+    // Direktes Lesen von Nutzdaten am Parser vorbei (Audio in den Wiedergabe-Puffer)
+    bool inHeader() const { return state == FrameParseState::HEADER; }
+    bool inMessagePayload() const { return state == FrameParseState::PAYLOAD && !(opcode & 0x08); }
+    uint8_t getMessageOpcode() const { return messageOpcode; }
+    bool isMasked() const { return masked; }
+    size_t headerRemaining() const { return headerNeeded - headerLength; }
+    uint64_t payloadRemaining() const { return payloadLength - payloadOffset; }
+    
+    // Am Parser vorbei gelesene Nutzdaten verbuchen; beendet ggf. den Frame
+    void consumePayload(size_t length);
+};
+
+// =============================================================================
+// CLIENT-FRAMES (RFC 6455, 5.3: immer maskiert)
+// =============================================================================
+
+// Header mit gesetztem Mask-Bit und Schlüssel; liefert die Länge (6..14 Bytes)
+size_t wsBuildFrameHeader(uint8_t* header, size_t length, uint8_t opcode, const uint8_t maskKey[4]);
+
+// XOR mit dem Schlüssel, 32 Bit pro Schritt. keyOffset ist die Position von
+// src im Frame. dst darf src sein (Entmaskieren an Ort und Stelle).
+void wsMaskPayload(uint8_t* dst, const uint8_t* src, size_t length, const uint8_t maskKey[4], size_t keyOffset);
+
+// Schreibt an den Socket; liefert die geschriebenen Bytes
+typedef size_t (*FrameWriteFunction)(void* context, const uint8_t* data, size_t length);
+
+// Maskierter Frame über buffer (WS_FRAME_HEADROOM vor den Nutzdaten). Passen
+// Kind-Byte (kind >= 0) und Daten hinein, genügt ein write(); größere Frames
+// gehen abschnittsweise hinaus.
+bool wsWriteFrame(uint8_t* buffer, size_t bufferSize, const uint8_t* data, size_t length, uint8_t opcode,
+                  int kind, const uint8_t maskKey[4], FrameWriteFunction write, void* context);
+
+#endif // WEB_SOCKET_FRAME_H
@@ -1,6 +1,20 @@
 #include "WifiManager.h"
+#include <ESPmDNS.h>
+#include <esp_attr.h>
 // #include "EventManager.h"  // Temporär deaktiviert
 
+// Zuletzt gefundener Server, überdauert den Deep Sleep; nach Kaltstart aus NVS
+#define SERVER_CACHE_MAGIC 0x53455256
+
+struct ServerCache {
+    uint32_t magic;
+    uint32_t address;
+    uint16_t port;
+    char host[MDNS_HOST_MAX_SIZE];  // Für Host:, SNI und die Zertifikatsprüfung
+};
+
+RTC_DATA_ATTR static ServerCache rtcServer;
+
 // =============================================================================
 // KONSTRUKTOR & DESTRUKTOR
 // =============================================================================
@@ -14,6 +28,11 @@ WifiManager::WifiManager() {
     lastReconnectAttempt = 0;
     reconnectAttempts = 0;
     
+    discoveryRequested = false;
+    lastDiscovery = 0;
+    mdnsStarted = false;
+    serverDiscoveredCallback = nullptr;
+    
     // Standard-Konfiguration
     config.ssid = "";
     config.password = "";
@@ -85,6 +104,14 @@ void WifiManager::update() {
             lastReconnectAttempt = currentTime;
         }
     }
+    
+    // Server-Suche nur auf Anforderung und höchstens alle MDNS_REVALIDATE_MS
+    if (discoveryRequested && isConnected() &&
+        (lastDiscovery == 0 || millis() - lastDiscovery >= MDNS_REVALIDATE_MS)) {
+        discoveryRequested = false;
+        lastDiscovery = millis();
+        discoverServer();
+    }
 }
 
 // =============================================================================
@@ -265,6 +292,7 @@ void WifiManager::resetConfig() {
     config.staticGateway = "";
     config.staticSubnet = "";
     config.useStaticIP = false;
+    rtcServer.magic = 0;    // Server-Cache gehört zur Konfiguration
     Serial.println("WifiManager: Konfiguration zurückgesetzt");
 }
 
@@ -611,6 +639,124 @@ bool WifiManager::saveConfigToNVS() {
     return true;
 }
 
+// =============================================================================
+// SERVER-SUCHE (DNS-SD)
+// =============================================================================
+
+bool WifiManager::getServerEndpoint(String& host, IPAddress& address, uint16_t& port) {
+    // Wakeup aus dem Deep Sleep: RTC-Speicher, ohne NVS und ohne Namensauflösung
+    if (rtcServer.magic != SERVER_CACHE_MAGIC) {
+        if (!preferences) {
+            return false;
+        }
+        uint32_t cachedAddress = preferences->getUInt(NVS_KEY_SERVER_ADDR, 0);
+        uint16_t cachedPort = preferences->getUShort(NVS_KEY_SERVER_PORT, 0);
+        String cachedHost = preferences->getString(NVS_KEY_SERVER_NAME, "");
+        if (cachedAddress == 0 || cachedPort == 0 || cachedHost.length() == 0 ||
+            cachedHost.length() >= sizeof(rtcServer.host)) {
+            return false;
+        }
+        rtcServer.address = cachedAddress;
+        rtcServer.port = cachedPort;
+        strlcpy(rtcServer.host, cachedHost.c_str(), sizeof(rtcServer.host));
+        rtcServer.magic = SERVER_CACHE_MAGIC;
+    }
+    
+    host = rtcServer.host;
+    address = IPAddress(rtcServer.address);
+    port = rtcServer.port;
+    return true;
+}
+
+void WifiManager::requestServerDiscovery() {
+    discoveryRequested = true;
+}
+
+void WifiManager::setServerDiscoveredCallback(ServerDiscoveredCallback callback) {
+    serverDiscoveredCallback = callback;
+}
+
+bool WifiManager::discoverServer() {
+    // mDNS erst bei Bedarf starten, der normale Wakeup kommt ohne aus
+    if (!mdnsStarted) {
+        String mac = WiFi.macAddress();
+        mac.replace(":", "");
+        String hostname = MDNS_HOSTNAME_PREFIX + mac.substring(6);
+        hostname.toLowerCase();
+        if (!MDNS.begin(hostname.c_str())) {
+            Serial.println("WifiManager: mDNS konnte nicht gestartet werden");
+            return false;
+        }
+        mdnsStarted = true;
+    }
+    
+    unsigned long startTime = millis();
+    int count = MDNS.queryService(MDNS_SERVICE_NAME, MDNS_SERVICE_PROTO);
+    
+    // Bisherigen Server bevorzugen, solange er noch angeboten wird
+    int chosen = -1;
+    for (int i = 0; i < count; i++) {
+        uint32_t address = (uint32_t)MDNS.IP(i);
+        if (address == 0) {
+            continue;
+        }
+        if (chosen < 0) {
+            chosen = i;
+        }
+        if (rtcServer.magic == SERVER_CACHE_MAGIC && address == rtcServer.address && MDNS.port(i) == rtcServer.port) {
+            chosen = i;
+            break;
+        }
+    }
+    
+    if (chosen < 0) {
+        Serial.printf("WifiManager: Kein _%s._%s-Dienst gefunden (%lu ms)\n",
+                      MDNS_SERVICE_NAME, MDNS_SERVICE_PROTO, millis() - startTime);
+        return false;
+    }
+    
+    IPAddress address = MDNS.IP(chosen);
+    uint16_t port = MDNS.port(chosen);
+    
+    // Der Name, nicht die IP, gehört in Host:, SNI und die Zertifikatsprüfung
+    String host = MDNS.hostname(chosen);
+    if (host.length() > 0 && host.indexOf('.') < 0) {
+        host += ".local";
+    }
+    if (host.length() == 0 || host.length() >= sizeof(rtcServer.host)) {
+        Serial.printf("WifiManager: Hostname des Servers unbrauchbar (%s), verwende IP\n", host.c_str());
+        host = address.toString();
+    }
+    Serial.printf("WifiManager: Server %s gefunden: %s:%u (%lu ms)\n",
+                  host.c_str(), address.toString().c_str(), port, millis() - startTime);
+    
+    // Unverändert: der Server selbst ist nicht erreichbar, der Backoff läuft weiter
+    if (rtcServer.magic == SERVER_CACHE_MAGIC && rtcServer.address == (uint32_t)address && rtcServer.port == port &&
+        host == rtcServer.host) {
+        return true;
+    }
+    
+    storeServerEndpoint(host, (uint32_t)address, port);
+    if (serverDiscoveredCallback) {
+        serverDiscoveredCallback(host, address, port);
+    }
+    return true;
+}
+
+void WifiManager::storeServerEndpoint(const String& host, uint32_t address, uint16_t port) {
+    rtcServer.address = address;
+    rtcServer.port = port;
+    strlcpy(rtcServer.host, host.c_str(), sizeof(rtcServer.host));
+    rtcServer.magic = SERVER_CACHE_MAGIC;
+    
+    // NVS nur bei Änderung beschreiben (Flash-Verschleiß)
+    if (preferences) {
+        preferences->putUInt(NVS_KEY_SERVER_ADDR, address);
+        preferences->putUShort(NVS_KEY_SERVER_PORT, port);
+        preferences->putString(NVS_KEY_SERVER_NAME, host);
+    }
+}
+
 void WifiManager::handleDNSServer() {
     if (dnsServer) {
         dnsServer->processNextRequest();
@@ -12,6 +12,10 @@
 // Forward-Deklaration (temporär deaktiviert)
 // class EventManager;
 
+// Neuer Server per DNS-SD gefunden (aus der WiFi-Task); host für Host:/SNI,
+// address ist das Verbindungsziel
+typedef void (*ServerDiscoveredCallback)(const String& host, const IPAddress& address, uint16_t port);
+
 // WLAN-Verbindungsstatus
 enum class WifiStatus {
     DISCONNECTED,    // Nicht verbunden
@@ -43,6 +47,12 @@ private:
     int reconnectAttempts;
     // EventManager* eventManager;  // Temporär deaktiviert
     
+    // Server-Suche (DNS-SD)
+    volatile bool discoveryRequested;
+    unsigned long lastDiscovery;    // 0 = noch nicht gesucht
+    bool mdnsStarted;
+    ServerDiscoveredCallback serverDiscoveredCallback;
+    
     // Private Methoden
     void startAccessPoint();
     void stopAccessPoint();
@@ -56,6 +66,8 @@ private:
     bool loadConfigFromNVS();
     bool saveConfigToNVS();
     void handleDNSServer();
+    bool discoverServer();
+    void storeServerEndpoint(const String& host, uint32_t address, uint16_t port);
 
 public:
     // Konstruktor & Destruktor
@@ -84,6 +96,15 @@ public:
     bool loadConfig();
     bool saveConfig();
     
+    // Server aus dem Cache: RTC-Speicher nach Deep Sleep, sonst NVS. host ist
+    // der Name für Host:/SNI, address das Ziel ohne Namensauflösung.
+    // false = noch kein Server gefunden.
+    bool getServerEndpoint(String& host, IPAddress& address, uint16_t& port);
+    
+    // Nach fehlgeschlagenem Connect: Suche läuft im Hintergrund in update()
+    void requestServerDiscovery();
+    void setServerDiscoveredCallback(ServerDiscoveredCallback callback);
+    
     // Netzwerk-Informationen
     String getLocalIP() const;
     String getSSID() const;
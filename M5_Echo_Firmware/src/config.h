@@ -69,18 +69,136 @@
 #define WIFI_RECONNECT_INTERVAL 30000      // 30 Sekunden zwischen Reconnect-Versuchen
 #define WIFI_MAX_RECONNECT_ATTEMPTS 5      // Maximale Anzahl Reconnect-Versuche
 
+// Server-Suche per DNS-SD (mDNS), Dienst _m5echo._tcp. Gesucht wird nur nach
+// einem fehlgeschlagenen Connect, der Wakeup nutzt die zwischengespeicherte Adresse.
+#define MDNS_SERVICE_NAME   "m5echo"
+#define MDNS_SERVICE_PROTO  "tcp"
+#define MDNS_HOSTNAME_PREFIX "m5echo-"         // Plus die letzten drei MAC-Bytes
+#define MDNS_REVALIDATE_MS  30000              // Frühestens dann erneut suchen
+#define MDNS_HOST_MAX_SIZE  64                 // Hostname des Servers (Host:, SNI, TLS-Prüfung)
+
 // WebSocket-Konfiguration
-#define WS_RECONNECT_INTERVAL 5000  // 5 Sekunden
+#define WS_RECONNECT_BASE_MS 500    // Erste Wartezeit, verdoppelt sich pro Fehlversuch
+#define WS_RECONNECT_MAX_MS  30000  // Obergrenze der Wartezeit (kein endgültiges Aufgeben)
 #define WS_HEARTBEAT_INTERVAL 30000 // 30 Sekunden
+#define WS_PING_INTERVAL_MS  2000   // Ping mit Zeitstempel für RTT-Messung
+#define WS_PONG_MAX_MISSED   3      // Verbindung gilt nach so vielen fehlenden Pongs als tot
 #define WS_BUFFER_SIZE       4096   // WebSocket Buffer
+#define WS_MAX_TEXT_MESSAGE_SIZE 4096   // Größere Text-Nachrichten werden verworfen
+#define WS_RX_BUDGET_BYTES   16384  // Max. Bytes pro Lesedurchlauf der Task
+#define WS_POLL_INTERVAL_MS  5      // Kurzes Warten ohne eventfd bzw. mit Pre-Roll-Rückstand
+#define WS_FRAME_HEADROOM    16     // Platz für den Frame-Header (max. 14 Bytes), Nutzdaten 4-Byte-ausgerichtet
+#define WS_TX_BUFFER_SIZE    (WS_FRAME_HEADROOM + 4096)  // Frames bis 4 KB mit einem write()
+
+// Sende-Queues: Aufrufer reihen nur ein, die Sende-Task schreibt in den Socket
+#define WS_TX_SLOT_SIZE      I2S_BUFFER_SIZE  // Größter Frame der übrigen Kanäle (Text-Nachricht, Bulk)
+#define WS_TX_CONTROL_SLOTS  8      // Zweierpotenz; überdauern Reconnects, voll ohne Verbindung: abgelehnt
+#define WS_TX_AUDIO_SLOTS    8      // Zweierpotenz; Slots zu WS_PACKETIZER_MAX_BYTES, 25 KB
+#define WS_TX_AUDIO_POLICY   TxPolicy::REJECT  // REJECT: ADPCM-Pre-Roll übernimmt, DROP_OLDEST: ältesten Block verwerfen
+#define WS_TX_TELEMETRY_SLOTS 4     // Zweierpotenz; Heartbeat, playback_progress; voll: älteste verwerfen
+#define WS_TX_BULK_SLOTS     4      // Zweierpotenz; voll: ablehnen, Aufrufer wiederholt
+
+// Sende-Scheduler: Steuerung strikt vor allem anderen, die übrigen Kanäle
+// gewichtet im Round-Robin (Frames je Runde)
+#define WS_SCHED_WEIGHT_AUDIO     4
+#define WS_SCHED_WEIGHT_TELEMETRY 1
+#define WS_SCHED_WEIGHT_BULK      1
+
+// Uplink-Packetizer: Mikrofon-Audio wird zu Frames von 10-100 ms gebündelt,
+// die Frame-Dauer folgt Sendelatenz und Tiefe der Audio-Queue
+#define WS_PACKETIZER_MIN_MS      10
+#define WS_PACKETIZER_MAX_MS      100
+#define WS_PACKETIZER_START_MS    40      // Startwert, nahe am 32-ms-Block der I2S
+#define WS_PACKETIZER_STEP_MS     10      // Vergrößern in Schritten, Verkleinern halbiert
+#define WS_PACKETIZER_BUDGET_MS   120     // Frame-Dauer plus Sendelatenz; darüber wird verkleinert
+#define WS_PACKETIZER_BACKLOG_FRAMES 2    // Ab dieser Queue-Tiefe: größere Frames, weniger Overhead
+#define WS_PACKETIZER_ADAPT_MS    500     // Regelintervall
+#define WS_PACKETIZER_FLUSH_MS    64      // Angefangenen Frame ohne Nachschub spätestens dann senden
+#define WS_PACKETIZER_MAX_BYTES   (WS_PACKETIZER_MAX_MS * (I2S_SAMPLE_RATE / 1000) * (I2S_BITS_PER_SAMPLE / 8) * I2S_CHANNELS)
+#define WS_TX_LOCK_TIMEOUT_MS 100   // Warten der Netzwerk-Task auf den Socket
+#define WS_CONNECT_TIMEOUT_MS 5000  // TCP-Connect plus Upgrade-Handshake
+#define WS_HANDSHAKE_MAX_SIZE 1024  // Größte akzeptierte Upgrade-Antwort (Header)
+#define WS_TLV_MAX_SIZE      256    // Größte binäre Steuer-Nachricht (ControlProtocol)
+#define WS_TLV_JSON_SIZE     512    // Dieselbe Nachricht beim Senden nach JSON umkodiert
+
+// TLS (wss://): Session-Ticket bzw. Session-ID überdauert den Deep Sleep im RTC-Speicher
+// Vertrauensanker: CA und/oder Key-Pin; ohne beides baut der Client kein wss:// auf
+#define WS_TLS_CA_CERT       nullptr    // PEM der Server-CA (prüft Kette und Hostname)
+#define WS_TLS_PIN_SHA256    nullptr    // SHA-256 des Server-Public-Keys als Hex, z.B. per
+                                        // openssl x509 -pubkey | openssl pkey -pubin -outform der | sha256sum
+#define WS_TLS_SESSION_MAX_SIZE 1536    // Serialisierte Session inkl. Server-Zertifikat
+#define WS_TLS_HOST_MAX_SIZE 64         // Session gilt nur für denselben Host
+
+// Verbindungs-Snapshot im RTC-Speicher: Server-Adresse, vorbereitete Upgrade-
+// Anfrage und Hello-Frame (resume bzw. identification), Sitzung. Nach dem
+// Deep Sleep ohne DNS und NVS; mit Zusage des Servers in einem Flug gesendet.
+#define WS_SNAPSHOT_ENABLED      true   // false: Vergleichsmessung ohne Schnellweg
+#define WS_SNAPSHOT_UPGRADE_SIZE 256    // HTTP-Upgrade-Anfrage
+#define WS_SNAPSHOT_HELLO_SIZE   384    // JSON von resume bzw. identification
+#define WS_SNAPSHOT_TOKEN_SIZE   64     // Sitzungs-Token inkl. Nullbyte
+
+// Audio über RTP/UDP (per "transport"-Nachricht ausgehandelt, WebSocket bleibt Steuerkanal)
+#define RTP_AUDIO_ENABLED    true       // "rtp" in den Fähigkeiten anbieten
+#define RTP_PAYLOAD_TYPE     96         // Dynamisch: PCM wie auf dem WebSocket (16 Bit LE, mono)
+#define RTP_MAX_PACKET_SIZE  1472       // Größtes Datagramm ohne IP-Fragmentierung
+
+// Netzwerk-Task wartet in select() auf Socket, Sendeaufträge und Timer
+#define WS_IDLE_WAKEUP_MS    1000   // Längste Wartezeit ohne fälligen Timer
+#define WS_CREDIT_POLL_MS    ((WS_CREDIT_MIN_DELTA * 1000) / (I2S_SAMPLE_RATE * 2))  // Abspieldauer eines Credit-Schritts (32 ms)
+
+// Downlink-Flusskontrolle: Gerät meldet Credits für den Wiedergabe-Puffer
+#define WS_CREDIT_MIN_DELTA     1024    // Neue Credits ab dieser Änderung sofort melden
+#define WS_CREDIT_INTERVAL_MS   250     // Spätestens dann bei Änderung melden
 
 // =============================================================================
 // AUDIO-STREAMING-KONFIGURATION
 // =============================================================================
 
-#define AUDIO_CHUNK_SIZE    512     // Größe der Audio-Chunks
 #define AUDIO_RING_BUFFER_SIZE 8192 // Ring-Puffer für Audio
 #define AUDIO_SILENCE_THRESHOLD 100 // Schwellwert für Stille
+#define AUDIO_DOWNLINK_TARGET_BYTES 6144 // Ziel-Füllstand des Wiedergabe-Puffers (192 ms)
+
+// Pre-Roll: Audio vor dem Verbindungsaufbau wird IMA-ADPCM-komprimiert (4:1)
+// gepuffert und erst beim Flush wieder zu PCM dekodiert
+#define AUDIO_PREROLL_MS            2000    // Maximale Pre-Roll-Dauer
+#define AUDIO_PREROLL_BLOCK_SAMPLES 256     // Samples pro ADPCM-Block
+#define AUDIO_PREROLL_BLOCK_SIZE    (sizeof(AdpcmBlockHeader) + (AUDIO_PREROLL_BLOCK_SAMPLES / 2))
+#define AUDIO_PREROLL_BLOCK_COUNT   ((AUDIO_PREROLL_MS * (I2S_SAMPLE_RATE / 1000) + AUDIO_PREROLL_BLOCK_SAMPLES - 1) / AUDIO_PREROLL_BLOCK_SAMPLES)
+#define AUDIO_PREROLL_LOCK_MS       20      // Recording-Task wartet auf einen laufenden Nachschub der Netzwerk-Task
+#define AUDIO_RECORDING_EXIT_MS     200     // Warten auf das Ende der Recording-Task (laufendes i2s_read)
+
+// Wiedergabe-Queue: Clips (Stream, Flash, URL) werden lückenlos aneinandergereiht
+#define AUDIO_PLAYBACK_QUEUE_SIZE       8       // Clips in der Queue
+#define AUDIO_FLASH_CLIP_MAX            8       // Registrierbare Flash-Clips
+#define AUDIO_CLIP_NAME_MAX             24
+#define AUDIO_CLIP_URL_MAX              160
+#define AUDIO_MAX_CROSSFADE_MS          30      // Muss in einen I2S-Block passen
+#define AUDIO_PREFETCH_BUFFER_SIZE      16384   // Vorab-Puffer für URL-Clips (512 ms)
+#define AUDIO_PLAYBACK_IDLE_TIMEOUT_MS  500     // Lautsprecher aus, wenn Queue leer
+#define AUDIO_PLAYBACK_STALL_TIMEOUT_MS 5000    // Queue verwerfen, wenn Daten ausbleiben
+
+// Wiedergabe-Position: gezählt über I2S-TX_DONE-Ereignisse (abgespielte DMA-Puffer)
+#define AUDIO_I2S_EVENT_QUEUE_SIZE      16
+#define AUDIO_PLAYBACK_MARK_QUEUE_SIZE  32      // Ausstehende Clip-Marken bis zur Ausgabe
+#define AUDIO_PLAYBACK_PROGRESS_MS      250     // Intervall der Fortschrittsmeldungen
+#define AUDIO_BARGE_IN_HOLDOFF_MS       1000    // Downlink ohne queue_clip nach Barge-in verwerfen
+
+// Endpointing: Äußerungsende per Energie/VAD und Nachlauf-Stille erkennen
+#define ENDPOINT_FRAME_MS               10      // Analyse-Frame
+#define ENDPOINT_MIN_SPEECH_MS          200     // Mindest-Sprachdauer einer Äußerung
+#define ENDPOINT_TRAILING_SILENCE_MS    700     // Stille bis "utterance_end"
+#define ENDPOINT_MIN_ENERGY             150     // Absolute Sprachschwelle (mittlerer Betrag)
+#define ENDPOINT_SPEECH_RATIO           3.0f    // Sprache: Energie > Grundpegel * Faktor
+#define ENDPOINT_MAX_ZCR_PERCENT        50      // Höhere Nulldurchgangsrate = Rauschen
+
+// Latenz-Regler: DMA-Geometrie (Puffer x Frames) nach gemessenem Jitter.
+// Stufen aufsteigend nach Kapazität, gewechselt wird nur zwischen Äußerungen.
+#define LATENCY_DMA_LEVELS              {{4, 128}, {4, 256}, {6, 256}, {8, 256}, {6, 512}, {8, 512}, {8, 1024}}
+#define LATENCY_DEFAULT_LEVEL           3       // 8 x 256 Frames = 128 ms
+#define LATENCY_JITTER_FACTOR           2       // Reserve = Faktor x Spitzen-Jitter
+#define LATENCY_MARGIN_US               10000   // Zusätzliche feste Reserve
+#define LATENCY_MIN_SAMPLES             32      // Messungen pro Fenster für eine Entscheidung
+#define LATENCY_STABLE_WINDOWS          3       // Saubere Fenster vor einer Stufe nach unten
 
 // =============================================================================
 // LED-KONFIGURATION
@@ -109,6 +227,7 @@
 #define DEEP_SLEEP_TIMEOUT  30000000 // 30 Sekunden in Mikrosekunden
 #define BUTTON_WAKEUP_PIN   GPIO_NUM_39
 #define BUTTON_WAKEUP_LEVEL 0        // Low-Level Wakeup
+#define BUTTON_DEBOUNCE_MS  20       // Entprellzeit des Tasters
 
 // =============================================================================
 // NVS-KONFIGURATION
@@ -119,6 +238,8 @@
 #define NVS_KEY_WIFI_PASS   "wifi_pass"
 #define NVS_KEY_SERVER_HOST "server_host"
 #define NVS_KEY_SERVER_PORT "server_port"
+#define NVS_KEY_SERVER_ADDR "server_addr"   // Per DNS-SD gefundene IPv4-Adresse
+#define NVS_KEY_SERVER_NAME "server_name"   // Zugehöriger Hostname (.local)
 #define NVS_KEY_CLIENT_ID   "client_id"
 #define NVS_KEY_MIC_MODE    "mic_mode"
 #define NVS_KEY_STATIC_IP   "static_ip"
@@ -138,10 +259,20 @@
 #define WS_MSG_COMMAND       "command"
 #define WS_MSG_CONFIG        "config"
 #define WS_MSG_OTA           "ota"
+#define WS_MSG_TRANSPORT     "transport"
 
 // Event-Typen
 #define EVENT_BUTTON_PRESSED "pressed"
 #define EVENT_BUTTON_RELEASED "released"
+#define EVENT_UTTERANCE_END  "utterance_end"
+#define EVENT_CLIP_STARTED   "clip_started"
+#define EVENT_CLIP_FINISHED  "clip_finished"
+#define EVENT_CLIP_REJECTED  "clip_rejected"
+#define EVENT_PLAYBACK_PROGRESS "playback_progress"
+#define EVENT_PLAYBACK_DONE  "playback_done"
+#define EVENT_BARGE_IN       "barge_in"
+#define EVENT_LATENCY_CONFIG "latency_config"
+#define EVENT_UPLINK_CONFIG  "uplink_config"
 
 // =============================================================================
 // MANAGER-INTEGRATION & EVENTS
@@ -197,6 +328,8 @@ struct ManagerEvent {
 #define POWER_TASK_PRIORITY        1
 #define OTA_TASK_PRIORITY          2
 #define EVENT_TASK_PRIORITY        3
+#define BUTTON_TASK_PRIORITY       4
+#define PREFETCH_TASK_PRIORITY     2
 
 // =============================================================================
 // STACK-GRÖSSEN FÜR TASKS
@@ -209,6 +342,8 @@ struct ManagerEvent {
 #define POWER_TASK_STACK_SIZE      4096
 #define OTA_TASK_STACK_SIZE        8192
 #define EVENT_TASK_STACK_SIZE      8192
+#define BUTTON_TASK_STACK_SIZE     4096
+#define PREFETCH_TASK_STACK_SIZE   8192
 
 // =============================================================================
 // DEBUG-KONFIGURATION
@@ -230,8 +365,10 @@ struct ManagerEvent {
 
 #define DEFAULT_CLIENT_ID   "m5echo_001"
 #define DEFAULT_UPDATE_SERVER_URL "http://192.168.1.100:8080/ota"
+#define OTA_REQUEST_URL_SIZE 256   // Update-URL aus einem Server-Befehl (ota_url)
 #define DEFAULT_SERVER_HOST "192.168.1.100"
 #define DEFAULT_SERVER_PORT 8080
+#define DEFAULT_SERVER_TLS  false      // true: wss:// (Port typischerweise 443), verlangt WS_TLS_CA_CERT oder WS_TLS_PIN_SHA256
 #define DEFAULT_MIC_MODE    "on_button_press"  // "always_on" oder "on_button_press"
 
 #endif // CONFIG_H
@@ -4,6 +4,7 @@
 #include <freertos/queue.h>
 #include <freertos/semphr.h>
 #include <Preferences.h>
+#include <esp_timer.h>
 #include "config.h"
 #include "LedManager.h"
 #include "WifiManager.h"
@@ -11,6 +12,7 @@
 #include "WebSocketClient.h"
 #include "PowerManager.h"
 #include "OtaManager.h"
+#include "CommandRegistry.h"
 // #include "EventManager.h"  // Temporär deaktiviert
 
 // =============================================================================
@@ -23,6 +25,7 @@ AudioManager audioManager;
 WebSocketClient webSocketClient;
 PowerManager powerManager;
 OtaManager otaManager;
+CommandRegistry commandRegistry;
 // EventManager eventManager;  // Temporär deaktiviert
 
 // =============================================================================
@@ -32,9 +35,10 @@ OtaManager otaManager;
 TaskHandle_t ledTaskHandle = nullptr;
 TaskHandle_t wifiTaskHandle = nullptr;
 // audioTaskHandle entfernt - AudioManager verwaltet seine eigenen Tasks
-TaskHandle_t websocketTaskHandle = nullptr;
+// websocketTaskHandle entfernt - WebSocketClient wartet ereignisgesteuert in seiner eigenen Task
 TaskHandle_t powerTaskHandle = nullptr;
 TaskHandle_t otaTaskHandle = nullptr;
+TaskHandle_t buttonTaskHandle = nullptr;
 
 // =============================================================================
 // ANWENDUNGSZUSTAND
@@ -51,6 +55,87 @@ enum class AppState {
 
 AppState currentAppState = AppState::BOOTING;
 
+// Mikrofon-Modus aus NVS ("always_on" oder "on_button_press")
+String micMode = DEFAULT_MIC_MODE;
+bool buttonPressed = false;
+volatile int64_t buttonEdgeUs = 0;     // Zeitpunkt der letzten Flanke (ISR)
+
+// =============================================================================
+// CALLBACKS
+// =============================================================================
+
+bool onCapturedAudio(const uint8_t* data, size_t length) {
+    // Schlägt fehl ohne Verbindung oder bei voller Sende-Queue -> AudioManager puffert im Pre-Roll;
+    // während des Verbindungsaufbaus wird weiter eingereiht
+    return webSocketClient.sendAudio(data, length);
+}
+
+void onAudioEvent(const char* event, const EventField* fields, size_t count) {
+    webSocketClient.sendEvent(event, fields, count);
+}
+
+void onDownlinkAudio(const uint8_t* data, size_t length) {
+    // Server sendet im Rahmen der gemeldeten Credits, der Puffer läuft nicht über
+    audioManager.playChunk(data, length);
+}
+
+void onWebSocketEvent(WebSocketStatus status) {
+    // Connect fehlgeschlagen: Server könnte umgezogen sein, im Hintergrund neu suchen
+    if (status == WebSocketStatus::DISCONNECTED) {
+        wifiManager.requestServerDiscovery();
+    }
+}
+
+void onServerDiscovered(const String& host, const IPAddress& address, uint16_t port) {
+    // Getrennt: neue Adresse sofort nutzen statt auf den nächsten Backoff-Versuch
+    // zu warten; eine bestehende Verbindung bleibt, der Fund gilt dann beim
+    // nächsten Versuch. Der Name bleibt für Host: und TLS, verbunden wird mit der IP
+    webSocketClient.useDiscoveredServer(host, port, address);
+}
+
+void onSleep() {
+    // Verbindung für den Schnellweg nach dem Wakeup festhalten, solange sie besteht
+    webSocketClient.saveSnapshot();
+}
+
+void onButtonPressed() {
+    // Barge-in: laufende Antwort abbrechen, bevor die Aufnahme startet
+    PlaybackPosition position;
+    bool bargeIn = audioManager.bargeIn(&position);
+    
+    if (micMode == "on_button_press") {
+        audioManager.startRecording();
+    }
+    int64_t pressToCaptureUs = esp_timer_get_time() - buttonEdgeUs;
+    
+    powerManager.registerButtonActivity();
+    ledManager.setState(LedState::LISTENING);
+    
+    if (bargeIn) {
+        EventField fields[] = {
+            { ControlTag::CLIP_ID, (int64_t)position.clipId },
+            { ControlTag::CLIP_SAMPLE, (int64_t)position.clipSample },
+            { ControlTag::SAMPLE_INDEX, (int64_t)position.playedSamples },
+            { ControlTag::TIMESTAMP, (int64_t)buttonEdgeUs },
+            { ControlTag::PRESS_TO_CAPTURE_US, pressToCaptureUs },
+        };
+        webSocketClient.sendEvent(EVENT_BARGE_IN, fields);
+        Serial.printf("Main: Barge-in bei Clip %u, Aufnahme nach %lld µs\n",
+                      (unsigned)position.clipId, (long long)pressToCaptureUs);
+    }
+    webSocketClient.sendEvent(EVENT_BUTTON_PRESSED);
+}
+
+void onButtonReleased() {
+    powerManager.registerButtonActivity();
+    
+    if (micMode == "on_button_press") {
+        audioManager.stopRecording();
+    }
+    webSocketClient.sendEvent(EVENT_BUTTON_RELEASED);
+    ledManager.setState(webSocketClient.isConnected() ? LedState::CONNECTED : LedState::WIFI_CONNECTING);
+}
+
 // =============================================================================
 // TASK-FUNKTIONEN
 // =============================================================================
@@ -83,15 +168,6 @@ void wifiTask(void* parameter) {
 
 // Audio-Task entfernt - AudioManager verwaltet seine eigenen Tasks
 
-void websocketTask(void* parameter) {
-    Serial.println("Main: WebSocket-Task gestartet");
-    
-    while (true) {
-        webSocketClient.update();
-        vTaskDelay(pdMS_TO_TICKS(100));
-    }
-}
-
 void powerTask(void* parameter) {
     Serial.println("Main: Power-Task gestartet");
     
@@ -109,6 +185,36 @@ void powerTask(void* parameter) {
     }
 }
 
+void buttonTask(void* parameter) {
+    Serial.println("Main: Button-Task gestartet");
+    
+    while (true) {
+        // Wartet auf Flanke aus der ISR
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        
+        // Drücken sofort auswerten (Barge-in), Prellen danach ausblenden
+        if (!buttonPressed && digitalRead(BUTTON_PIN) == LOW) {
+            buttonPressed = true;
+            onButtonPressed();
+        }
+        
+        vTaskDelay(pdMS_TO_TICKS(BUTTON_DEBOUNCE_MS));
+        ulTaskNotifyTake(pdTRUE, 0);
+        
+        bool pressed = digitalRead(BUTTON_PIN) == LOW;
+        if (pressed == buttonPressed) {
+            continue;
+        }
+        buttonPressed = pressed;
+        
+        if (pressed) {
+            onButtonPressed();
+        } else {
+            onButtonReleased();
+        }
+    }
+}
+
 void otaTask(void* parameter) {
     Serial.println("Main: OTA-Task gestartet");
     
@@ -123,8 +229,15 @@ void otaTask(void* parameter) {
 // =============================================================================
 
 void IRAM_ATTR buttonISR() {
-    // Button-Press an EventManager senden
-    // eventManager.sendButtonPressed();  // Temporär deaktiviert
+    // Auswertung und Entprellung in der Button-Task
+    buttonEdgeUs = esp_timer_get_time();
+    if (buttonTaskHandle) {
+        BaseType_t higherPriorityTaskWoken = pdFALSE;
+        vTaskNotifyGiveFromISR(buttonTaskHandle, &higherPriorityTaskWoken);
+        if (higherPriorityTaskWoken) {
+            portYIELD_FROM_ISR();
+        }
+    }
 }
 
 // =============================================================================
@@ -178,15 +291,8 @@ void createTasks() {
     
     // Audio-Task entfernt - AudioManager verwaltet seine eigenen Tasks
     
-    // WebSocket-Task
-    xTaskCreate(
-        websocketTask,
-        "websocket_task",
-        WEBSOCKET_TASK_STACK_SIZE,
-        nullptr,
-        WEBSOCKET_TASK_PRIORITY,
-        &websocketTaskHandle
-    );
+    // WebSocket-Task entfernt - Reconnect, Heartbeat und Pre-Roll-Rückstand
+    // erledigt die Netzwerk-Task des WebSocketClient
     
     // Power-Task
     xTaskCreate(
@@ -198,6 +304,16 @@ void createTasks() {
         &powerTaskHandle
     );
     
+    // Button-Task
+    xTaskCreate(
+        buttonTask,
+        "button_task",
+        BUTTON_TASK_STACK_SIZE,
+        nullptr,
+        BUTTON_TASK_PRIORITY,
+        &buttonTaskHandle
+    );
+    
     // OTA-Task
     xTaskCreate(
         otaTask,
@@ -236,9 +352,34 @@ void setup() {
     wifiManager.begin();
     Serial.println("Main: WifiManager initialisiert");
     
+    // Mikrofon-Modus aus NVS laden
+    Preferences preferences;
+    if (preferences.begin(NVS_NAMESPACE, true)) {
+        micMode = preferences.getString(NVS_KEY_MIC_MODE, DEFAULT_MIC_MODE);
+        preferences.end();
+    }
+    Serial.printf("Main: Mikrofon-Modus: %s\n", micMode.c_str());
+    
     // Audio-Manager initialisieren
     if (audioManager.begin()) {
         Serial.println("Main: AudioManager initialisiert");
+        audioManager.setAudioSink(onCapturedAudio);
+        audioManager.setAudioEventCallback(onAudioEvent);
+        
+        // Tastenbetrieb: Server früh über das Sprachende informieren,
+        // die Aufnahme selbst endet erst beim Loslassen
+        audioManager.setEndpointingEnabled(micMode == "on_button_press");
+        
+        // Tasten-Wakeup: sofort aufnehmen, der Pre-Roll überbrückt WLAN- und
+        // WebSocket-Verbindungsaufbau
+        if (micMode == "on_button_press" &&
+            powerManager.getLastWakeupSource() == WakeupSource::BUTTON &&
+            digitalRead(BUTTON_PIN) == LOW) {
+            buttonPressed = true;
+            audioManager.startRecording();
+            ledManager.setState(LedState::BUTTON_PRESSED);
+            Serial.println("Main: Aufnahme nach Tasten-Wakeup gestartet (Pre-Roll)");
+        }
         // Audio-Wiedergabe NICHT starten - das verursacht komische Geräusche
         // Audio-Wiedergabe nur starten wenn echte Audio-Daten verfügbar sind
         Serial.println("Main: Audio-Wiedergabe bleibt gestoppt bis Audio-Daten empfangen werden");
@@ -252,8 +393,30 @@ void setup() {
     
     // WebSocket-Client initialisieren
     webSocketClient.begin();
+    webSocketClient.setAudioManager(&audioManager);
+    webSocketClient.setAudioCallback(onDownlinkAudio);
+    webSocketClient.setEventCallback(onWebSocketEvent);
+    wifiManager.setServerDiscoveredCallback(onServerDiscovered);
+    powerManager.setSleepCallback(onSleep);
+    
+    // Server-Befehle direkt an die Manager
+    commandRegistry.setWebSocketClient(&webSocketClient);
+    commandRegistry.setAudioManager(&audioManager);
+    commandRegistry.setLedManager(&ledManager);
+    commandRegistry.setPowerManager(&powerManager);
+    commandRegistry.setOtaManager(&otaManager);
+    commandRegistry.setWifiManager(&wifiManager);
+    webSocketClient.setCommandRegistry(&commandRegistry);
     Serial.println("Main: WebSocketClient initialisiert");
     
+    // Dauerbetrieb: Aufnahme vorab scharf schalten, gesendet wird erst auf
+    // start_stream des Servers
+    if (micMode == "always_on") {
+        audioManager.closeStream();
+        audioManager.startRecording();
+        Serial.println("Main: Aufnahme scharf geschaltet (wartet auf start_stream)");
+    }
+    
     // OTA-Manager initialisieren
     otaManager.begin();
     Serial.println("Main: OtaManager initialisiert");
@@ -263,7 +426,7 @@ void setup() {
     
     // Button-Interrupt einrichten
     pinMode(BUTTON_PIN, INPUT_PULLUP);
-    attachInterrupt(digitalPinToInterrupt(BUTTON_PIN), buttonISR, FALLING);
+    attachInterrupt(digitalPinToInterrupt(BUTTON_PIN), buttonISR, CHANGE);
     Serial.println("Main: Button-Interrupt eingerichtet");
     
     // FreeRTOS-Tasks erstellen
@@ -273,17 +436,36 @@ void setup() {
     currentAppState = AppState::CONNECTING;
     ledManager.setState(LedState::WIFI_CONNECTING);
     
-    // Warte kurz für stabile Initialisierung
-    delay(2000);
+    // Snapshot vor dem Deep Sleep: Server und Sitzung stehen fest, ohne DNS-SD
+    bool fastWake = webSocketClient.restoreSnapshot();
+    
+    // Warte kurz für stabile Initialisierung (nicht nach dem Deep Sleep mit
+    // Snapshot, die Wartezeit ginge direkt in die Latenz bis zum ersten Audio)
+    if (!fastWake) {
+        delay(2000);
+    }
     
     if (wifiManager.connect()) {
         Serial.println("Main: WiFi-Verbindung erfolgreich");
         currentAppState = AppState::CONNECTED;
         ledManager.setState(LedState::CONNECTED);
         
-        // WebSocket-Verbindung aufbauen
-        if (webSocketClient.connect(DEFAULT_SERVER_HOST, DEFAULT_SERVER_PORT)) {
-            Serial.println("Main: WebSocket-Verbindung erfolgreich");
+        // Server-Adresse aus dem Cache, ohne Namensauflösung. Noch nie
+        // gefunden: Standard-Server versuchen und parallel per DNS-SD suchen.
+        IPAddress serverAddress((uint32_t)0);
+        uint16_t serverPort = DEFAULT_SERVER_PORT;
+        String serverHost = DEFAULT_SERVER_HOST;
+        if (fastWake) {
+            serverHost = webSocketClient.getServerHost();
+            serverAddress = webSocketClient.getServerAddress();
+            serverPort = webSocketClient.getServerPort();
+        } else if (!wifiManager.getServerEndpoint(serverHost, serverAddress, serverPort)) {
+            wifiManager.requestServerDiscovery();
+        }
+        
+        // WebSocket-Verbindung aufbauen (läuft im Hintergrund weiter)
+        if (webSocketClient.connect(serverHost, serverPort, serverAddress)) {
+            Serial.println("Main: WebSocket-Verbindungsaufbau gestartet");
             ledManager.setState(LedState::CONNECTED);
         } else {
             Serial.println("Main: WebSocket-Verbindung fehlgeschlagen");
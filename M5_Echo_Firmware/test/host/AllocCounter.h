@@ -0,0 +1,48 @@
+#ifndef HOST_ALLOC_COUNTER_H
+#define HOST_ALLOC_COUNTER_H
+
+// Zählt Heap-Allokationen im Host-Build. env:native linkt mit
+// --wrap=malloc,calloc,realloc, daher muss jedes Testprogramm diese Datei
+// genau einmal einbinden (in test_main.cpp).
+#include <stdlib.h>
+#include <new>
+
+static volatile size_t allocations = 0;
+
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+void* __wrap_malloc(size_t size) {
+    allocations++;
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+    allocations++;
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+    allocations++;
+    return __real_realloc(ptr, size);
+}
+}
+
+void* operator new(size_t size) {
+    allocations++;
+    return __real_malloc(size);
+}
+
+void* operator new[](size_t size) {
+    allocations++;
+    return __real_malloc(size);
+}
+
+void operator delete(void* ptr) noexcept { free(ptr); }
+void operator delete[](void* ptr) noexcept { free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { free(ptr); }
+
+#endif // HOST_ALLOC_COUNTER_H
@@ -0,0 +1,100 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// Minimaler Ersatz für den Host-Build (env:native): nur was die Module unter
+// Test brauchen
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <string>
+
+#define PI 3.1415926535897932384626433832795
+
+template <typename T>
+inline T min(T a, T b) { return a < b ? a : b; }
+
+template <typename T>
+inline T max(T a, T b) { return a > b ? a : b; }
+
+inline uint32_t millis() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)(now.tv_sec * 1000 + now.tv_nsec / 1000000);
+}
+
+inline void delay(uint32_t ms) {
+    usleep(ms * 1000);
+}
+
+// GPIOs sind auf dem Host ohne Wirkung
+#define LOW     0
+#define HIGH    1
+#define OUTPUT  0x03
+
+inline void pinMode(uint8_t pin, uint8_t mode) {
+    (void)pin;
+    (void)mode;
+}
+
+inline void digitalWrite(uint8_t pin, uint8_t value) {
+    (void)pin;
+    (void)value;
+}
+
+// Nur was die Module unter Test von Arduino-String nutzen
+class String {
+public:
+    String(const char* text = "") : value(text) {}
+    
+    const char* c_str() const { return value.c_str(); }
+    size_t length() const { return value.length(); }
+    bool operator==(const char* text) const { return value == text; }
+    
+private:
+    std::string value;
+};
+
+// glibc vor 2.38 hat kein strlcpy
+inline size_t hostStrlcpy(char* dst, const char* src, size_t size) {
+    size_t length = strlen(src);
+    if (size > 0) {
+        size_t copy = length < size - 1 ? length : size - 1;
+        memcpy(dst, src, copy);
+        dst[copy] = '\0';
+    }
+    return length;
+}
+#define strlcpy hostStrlcpy
+
+// Serial-Ausgaben landen auf stdout; Tests können sie mit quiet abschalten
+class HostSerial {
+public:
+    bool quiet = false;
+    
+    int printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        if (quiet) {
+            return 0;
+        }
+        va_list args;
+        va_start(args, format);
+        int written = vprintf(format, args);
+        va_end(args);
+        return written;
+    }
+    
+    void println(const char* text) {
+        if (!quiet) {
+            puts(text);
+        }
+    }
+};
+
+inline HostSerial Serial;
+
+#endif // HOST_ARDUINO_H
@@ -0,0 +1,28 @@
+#ifndef HOST_HTTPCLIENT_H
+#define HOST_HTTPCLIENT_H
+
+// Host-Ersatz ohne Netzwerk: jede Anfrage schlägt fehl (URL-Clips enden leer)
+#include <Arduino.h>
+
+#define HTTP_CODE_OK 200
+
+class WiFiClient {
+public:
+    int available() { return 0; }
+    int read(uint8_t* buffer, size_t size) { (void)buffer; (void)size; return -1; }
+};
+
+class HTTPClient {
+public:
+    bool begin(const String& url) { (void)url; return false; }
+    int GET() { return -1; }
+    int getSize() { return -1; }
+    bool connected() { return false; }
+    WiFiClient* getStreamPtr() { return &client; }
+    void end() {}
+    
+private:
+    WiFiClient client;
+};
+
+#endif // HOST_HTTPCLIENT_H
@@ -0,0 +1,278 @@
+#ifndef HOST_DRIVER_I2S_H
+#define HOST_DRIVER_I2S_H
+
+// Simulierter I2S-Treiber (16 bit mono). Die DMA läuft ab i2s_driver_install
+// in Echtzeit: RX liefert ganze DMA-Puffer mit fortlaufenden Sample-Werten,
+// TX gibt geschriebene Daten im Sample-Takt aus, füllt Lücken mit Nullen
+// (tx_desc_auto_clear) und meldet jeden ausgegebenen Puffer als TX_DONE.
+// Tests lesen den Zeitstrahl über hostI2s*() aus.
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
+#include <mutex>
+#include <esp_err.h>
+#include <esp_timer.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+#define ESP_INTR_FLAG_LEVEL1    (1 << 1)
+#define I2S_PIN_NO_CHANGE       (-1)
+
+typedef enum {
+    I2S_NUM_0 = 0,
+    I2S_NUM_1 = 1,
+    I2S_NUM_MAX,
+} i2s_port_t;
+
+typedef enum {
+    I2S_MODE_MASTER = 1,
+    I2S_MODE_SLAVE = 2,
+    I2S_MODE_TX = 4,
+    I2S_MODE_RX = 8,
+} i2s_mode_t;
+
+typedef enum {
+    I2S_BITS_PER_SAMPLE_16BIT = 16,
+    I2S_BITS_PER_SAMPLE_32BIT = 32,
+} i2s_bits_per_sample_t;
+
+typedef enum {
+    I2S_CHANNEL_FMT_RIGHT_LEFT = 0,
+    I2S_CHANNEL_FMT_ONLY_RIGHT = 3,
+    I2S_CHANNEL_FMT_ONLY_LEFT = 4,
+} i2s_channel_fmt_t;
+
+typedef enum {
+    I2S_COMM_FORMAT_STAND_I2S = 1,
+} i2s_comm_format_t;
+
+typedef struct {
+    i2s_mode_t mode;
+    uint32_t sample_rate;
+    i2s_bits_per_sample_t bits_per_sample;
+    i2s_channel_fmt_t channel_format;
+    i2s_comm_format_t communication_format;
+    int intr_alloc_flags;
+    int dma_buf_count;
+    int dma_buf_len;
+    bool use_apll;
+    bool tx_desc_auto_clear;
+    int fixed_mclk;
+} i2s_config_t;
+
+typedef struct {
+    int bck_io_num;
+    int ws_io_num;
+    int data_out_num;
+    int data_in_num;
+} i2s_pin_config_t;
+
+typedef enum {
+    I2S_EVENT_DMA_ERROR,
+    I2S_EVENT_TX_DONE,
+    I2S_EVENT_RX_DONE,
+} i2s_event_type_t;
+
+typedef struct {
+    i2s_event_type_t type;
+    size_t size;
+} i2s_event_t;
+
+// =============================================================================
+// SIMULATION
+// =============================================================================
+
+struct HostI2sPort {
+    bool installed;
+    bool tx;
+    uint32_t sampleRate;
+    uint64_t bufCount;
+    uint64_t bufLen;                // Frames pro DMA-Puffer
+    int64_t startUs;                // Frame 0 des Zeitstrahls
+    uint64_t consumedFrames;        // RX: abgeholt bzw. übersprungen
+    uint64_t queuedEnd;             // TX: Ende der geschriebenen Daten
+    uint64_t audibleEnd;            // TX: Ende des letzten Samples ungleich 0
+    uint64_t reportedBuffers;       // TX: gemeldete TX_DONE
+    int64_t zeroedUs;               // TX: letzter i2s_zero_dma_buffer, -1 = nie
+    QueueHandle_t events;
+};
+
+inline std::mutex hostI2sLock;
+inline HostI2sPort hostI2sPorts[I2S_NUM_MAX];
+
+inline uint64_t hostI2sElapsedFrames(const HostI2sPort& port) {
+    return (uint64_t)(esp_timer_get_time() - port.startUs) * port.sampleRate / 1000000;
+}
+
+inline int64_t hostI2sFrameUs(const HostI2sPort& port, uint64_t frame) {
+    return port.startUs + (int64_t)(frame * 1000000 / port.sampleRate);
+}
+
+// Wartet bis zum Ende des laufenden DMA-Puffers (Lock nicht gehalten)
+inline void hostI2sSleepBuffer(const HostI2sPort& port) {
+    uint64_t next = (hostI2sElapsedFrames(port) / port.bufLen + 1) * port.bufLen;
+    int64_t waitUs = hostI2sFrameUs(port, next) + 1 - esp_timer_get_time();   // +1: Frame-Zeit ist abgerundet
+    if (waitUs > 0) {
+        struct timespec delay = { (time_t)(waitUs / 1000000), (long)(waitUs % 1000000) * 1000 };
+        nanosleep(&delay, nullptr);
+    }
+}
+
+// TX: DMA bis jetzt fortschreiben, fertige Puffer melden; liefert die Ausgabeposition
+inline uint64_t hostI2sAdvanceTx(HostI2sPort& port) {
+    uint64_t played = hostI2sElapsedFrames(port);
+    uint64_t buffers = played / port.bufLen;
+    for (; port.reportedBuffers < buffers; port.reportedBuffers++) {
+        i2s_event_t event = { I2S_EVENT_TX_DONE, (size_t)port.bufLen * sizeof(int16_t) };
+        port.events->send(&event, 0);   // Volle Queue: Ereignis geht verloren wie im Treiber
+    }
+    if (port.queuedEnd < played) {
+        port.queuedEnd = played;
+    }
+    return played;
+}
+
+// Zeitpunkt, ab dem der Lautsprecher nur noch Nullen ausgibt
+inline int64_t hostI2sAudibleUntilUs(i2s_port_t portNum) {
+    std::lock_guard<std::mutex> guard(hostI2sLock);
+    return hostI2sFrameUs(hostI2sPorts[portNum], hostI2sPorts[portNum].audibleEnd);
+}
+
+inline int64_t hostI2sZeroedUs(i2s_port_t portNum) {
+    std::lock_guard<std::mutex> guard(hostI2sLock);
+    return hostI2sPorts[portNum].zeroedUs;
+}
+
+inline int64_t hostI2sBufferUs(i2s_port_t portNum) {
+    std::lock_guard<std::mutex> guard(hostI2sLock);
+    const HostI2sPort& port = hostI2sPorts[portNum];
+    return (int64_t)(port.bufLen * 1000000 / port.sampleRate);
+}
+
+// =============================================================================
+// TREIBER-API
+// =============================================================================
+
+inline esp_err_t i2s_driver_install(i2s_port_t portNum, const i2s_config_t* config, int queueSize, QueueHandle_t* queue) {
+    std::lock_guard<std::mutex> guard(hostI2sLock);
+    HostI2sPort& port = hostI2sPorts[portNum];
+    if (port.installed || config->dma_buf_count <= 0 || config->dma_buf_len <= 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    port = HostI2sPort();
+    port.installed = true;
+    port.tx = (config->mode & I2S_MODE_TX) != 0;
+    port.sampleRate = config->sample_rate;
+    port.bufCount = (uint64_t)config->dma_buf_count;
+    port.bufLen = (uint64_t)config->dma_buf_len;
+    port.startUs = esp_timer_get_time();
+    port.zeroedUs = -1;
+    port.events = xQueueCreate(queueSize > 0 ? queueSize : 1, sizeof(i2s_event_t));
+    if (queue) {
+        *queue = queueSize > 0 ? port.events : nullptr;
+    }
+    return ESP_OK;
+}
+
+inline esp_err_t i2s_driver_uninstall(i2s_port_t portNum) {
+    std::lock_guard<std::mutex> guard(hostI2sLock);
+    HostI2sPort& port = hostI2sPorts[portNum];
+    if (!port.installed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    port.installed = false;
+    vQueueDelete(port.events);
+    port.events = nullptr;
+    return ESP_OK;
+}
+
+inline esp_err_t i2s_set_pin(i2s_port_t portNum, const i2s_pin_config_t* pins) {
+    (void)pins;
+    std::lock_guard<std::mutex> guard(hostI2sLock);
+    return hostI2sPorts[portNum].installed ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
+
+// Blockiert wie der Treiber, bis 'size' Bytes gelesen sind. Sample n hat den
+// Wert (int16_t)n, Lücken im gelesenen Strom sind so direkt sichtbar.
+inline esp_err_t i2s_read(i2s_port_t portNum, void* dest, size_t size, size_t* bytesRead, TickType_t ticks) {
+    (void)ticks;
+    HostI2sPort& port = hostI2sPorts[portNum];
+    size_t frames = size / sizeof(int16_t);
+    int16_t* out = static_cast<int16_t*>(dest);
+    size_t done = 0;
+    *bytesRead = 0;
+    
+    while (done < frames) {
+        std::unique_lock<std::mutex> guard(hostI2sLock);
+        if (!port.installed || port.tx) {
+            return ESP_ERR_INVALID_STATE;
+        }
+        uint64_t filled = hostI2sElapsedFrames(port) / port.bufLen * port.bufLen;
+        uint64_t capacity = port.bufCount * port.bufLen;
+        if (filled - port.consumedFrames > capacity) {
+            port.consumedFrames = filled - capacity;
+        }
+        while (done < frames && port.consumedFrames < filled) {
+            out[done++] = (int16_t)port.consumedFrames++;
+        }
+        guard.unlock();
+        if (done < frames) {
+            hostI2sSleepBuffer(port);
+        }
+    }
+    *bytesRead = done * sizeof(int16_t);
+    return ESP_OK;
+}
+
+// Blockiert, solange die DMA-Puffer belegt sind
+inline esp_err_t i2s_write(i2s_port_t portNum, const void* src, size_t size, size_t* bytesWritten, TickType_t ticks) {
+    (void)ticks;
+    HostI2sPort& port = hostI2sPorts[portNum];
+    size_t frames = size / sizeof(int16_t);
+    const int16_t* in = static_cast<const int16_t*>(src);
+    size_t done = 0;
+    *bytesWritten = 0;
+    
+    while (done < frames) {
+        std::unique_lock<std::mutex> guard(hostI2sLock);
+        if (!port.installed || !port.tx) {
+            return ESP_ERR_INVALID_STATE;
+        }
+        // Ein DMA-Puffer wird erst mit seinem TX_DONE frei
+        uint64_t released = hostI2sAdvanceTx(port) / port.bufLen * port.bufLen;
+        uint64_t capacity = port.bufCount * port.bufLen;
+        while (done < frames && port.queuedEnd - released < capacity) {
+            if (in[done] != 0) {
+                port.audibleEnd = port.queuedEnd + 1;
+            }
+            port.queuedEnd++;
+            done++;
+        }
+        guard.unlock();
+        if (done < frames) {
+            hostI2sSleepBuffer(port);
+        }
+    }
+    *bytesWritten = done * sizeof(int16_t);
+    return ESP_OK;
+}
+
+// Nullt alle DMA-Puffer; der gerade ausgegebene Puffer läuft noch zu Ende
+inline esp_err_t i2s_zero_dma_buffer(i2s_port_t portNum) {
+    std::lock_guard<std::mutex> guard(hostI2sLock);
+    HostI2sPort& port = hostI2sPorts[portNum];
+    if (!port.installed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (port.tx) {
+        uint64_t played = hostI2sAdvanceTx(port);
+        uint64_t bufferEnd = (played / port.bufLen + 1) * port.bufLen;
+        if (port.audibleEnd > bufferEnd) {
+            port.audibleEnd = bufferEnd;
+        }
+        port.zeroedUs = esp_timer_get_time();
+    }
+    return ESP_OK;
+}
+
+#endif // HOST_DRIVER_I2S_H
@@ -0,0 +1,21 @@
+#ifndef HOST_ESP_ERR_H
+#define HOST_ESP_ERR_H
+
+typedef int esp_err_t;
+
+#define ESP_OK                  0
+#define ESP_FAIL                -1
+#define ESP_ERR_INVALID_ARG     0x102
+#define ESP_ERR_INVALID_STATE   0x103
+
+inline const char* esp_err_to_name(esp_err_t code) {
+    switch (code) {
+        case ESP_OK: return "ESP_OK";
+        case ESP_FAIL: return "ESP_FAIL";
+        case ESP_ERR_INVALID_ARG: return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+        default: return "ERROR";
+    }
+}
+
+#endif // HOST_ESP_ERR_H
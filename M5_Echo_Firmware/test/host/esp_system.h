@@ -0,0 +1,13 @@
+#ifndef HOST_ESP_SYSTEM_H
+#define HOST_ESP_SYSTEM_H
+
+// Host-Ersatz für den Hardware-RNG
+#include <stdint.h>
+#include <random>
+
+inline uint32_t esp_random() {
+    static std::mt19937 generator(std::random_device{}());
+    return generator();
+}
+
+#endif // HOST_ESP_SYSTEM_H
@@ -0,0 +1,20 @@
+#ifndef HOST_ESP_TIMER_H
+#define HOST_ESP_TIMER_H
+
+// Host-Ersatz: Mikrosekunden seit einem beliebigen, festen Zeitpunkt
+#include <stdint.h>
+#include <time.h>
+
+// Tests können die Zeit vorgeben (z.B. Ankunftszeiten für den Jitter); < 0 = echte Uhr
+inline int64_t hostTimeUs = -1;
+
+inline int64_t esp_timer_get_time() {
+    if (hostTimeUs >= 0) {
+        return hostTimeUs;
+    }
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+#endif // HOST_ESP_TIMER_H
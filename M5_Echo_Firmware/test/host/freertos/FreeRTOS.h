@@ -0,0 +1,38 @@
+#ifndef HOST_FREERTOS_H
+#define HOST_FREERTOS_H
+
+// Host-Ersatz: ein Tick ist eine Millisekunde
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define pdFALSE         0
+#define pdTRUE          1
+#define pdFAIL          pdFALSE
+#define pdPASS          pdTRUE
+#define portMAX_DELAY   ((TickType_t)0xFFFFFFFF)
+
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+// Kritischer Abschnitt als Spinlock (auf dem ESP32 zusätzlich Interrupts aus)
+typedef struct {
+    volatile int locked;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED { 0 }
+
+inline void hostEnterCritical(portMUX_TYPE* mux) {
+    while (__atomic_exchange_n(&mux->locked, 1, __ATOMIC_ACQUIRE)) {
+    }
+}
+
+inline void hostExitCritical(portMUX_TYPE* mux) {
+    __atomic_store_n(&mux->locked, 0, __ATOMIC_RELEASE);
+}
+
+#define portENTER_CRITICAL(mux) hostEnterCritical(mux)
+#define portEXIT_CRITICAL(mux)  hostExitCritical(mux)
+
+#endif // HOST_FREERTOS_H
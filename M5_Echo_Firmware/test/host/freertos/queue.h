@@ -0,0 +1,81 @@
+#ifndef HOST_FREERTOS_QUEUE_H
+#define HOST_FREERTOS_QUEUE_H
+
+// Queue mit fester Elementgröße; Semaphoren sind wie bei FreeRTOS Queues
+// ohne Nutzdaten (nur der Zähler)
+#include <string.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+#include "FreeRTOS.h"
+
+struct HostQueue {
+    std::mutex lock;
+    std::condition_variable changed;
+    std::vector<uint8_t> storage;
+    size_t itemSize;
+    size_t capacity;
+    size_t head;
+    size_t count;
+    
+    HostQueue(size_t length, size_t size)
+        : storage(length * size), itemSize(size), capacity(length), head(0), count(0) {}
+    
+    // Wartet höchstens 'ticks' ms, bis cond() gilt (portMAX_DELAY: unbegrenzt)
+    template <typename Condition>
+    bool wait(std::unique_lock<std::mutex>& guard, TickType_t ticks, Condition cond) {
+        if (ticks == portMAX_DELAY) {
+            changed.wait(guard, cond);
+            return true;
+        }
+        return changed.wait_for(guard, std::chrono::milliseconds(ticks), cond);
+    }
+    
+    bool send(const void* item, TickType_t ticks) {
+        std::unique_lock<std::mutex> guard(lock);
+        if (!wait(guard, ticks, [this] { return count < capacity; })) {
+            return false;
+        }
+        if (itemSize > 0) {
+            memcpy(&storage[((head + count) % capacity) * itemSize], item, itemSize);
+        }
+        count++;
+        changed.notify_all();
+        return true;
+    }
+    
+    bool receive(void* item, TickType_t ticks) {
+        std::unique_lock<std::mutex> guard(lock);
+        if (!wait(guard, ticks, [this] { return count > 0; })) {
+            return false;
+        }
+        if (itemSize > 0) {
+            memcpy(item, &storage[head * itemSize], itemSize);
+        }
+        head = (head + 1) % capacity;
+        count--;
+        changed.notify_all();
+        return true;
+    }
+};
+
+typedef HostQueue* QueueHandle_t;
+
+inline QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+    return new HostQueue(length, itemSize);
+}
+
+inline void vQueueDelete(QueueHandle_t queue) {
+    delete queue;
+}
+
+inline BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticks) {
+    return queue->send(item, ticks) ? pdTRUE : pdFALSE;
+}
+
+inline BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t ticks) {
+    return queue->receive(item, ticks) ? pdTRUE : pdFALSE;
+}
+
+#endif // HOST_FREERTOS_QUEUE_H
@@ -0,0 +1,31 @@
+#ifndef HOST_FREERTOS_SEMPHR_H
+#define HOST_FREERTOS_SEMPHR_H
+
+// Mutex und binäre Semaphore als Queue der Länge 1 (ohne Prioritätsvererbung)
+#include "queue.h"
+
+typedef HostQueue* SemaphoreHandle_t;
+
+inline SemaphoreHandle_t xSemaphoreCreateBinary() {
+    return new HostQueue(1, 0);
+}
+
+inline SemaphoreHandle_t xSemaphoreCreateMutex() {
+    SemaphoreHandle_t mutex = new HostQueue(1, 0);
+    mutex->send(nullptr, 0);
+    return mutex;
+}
+
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks) {
+    return semaphore->receive(nullptr, ticks) ? pdTRUE : pdFALSE;
+}
+
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    return semaphore->send(nullptr, 0) ? pdTRUE : pdFALSE;
+}
+
+inline void vSemaphoreDelete(SemaphoreHandle_t semaphore) {
+    delete semaphore;
+}
+
+#endif // HOST_FREERTOS_SEMPHR_H
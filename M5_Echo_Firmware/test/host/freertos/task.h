@@ -0,0 +1,65 @@
+#ifndef HOST_FREERTOS_TASK_H
+#define HOST_FREERTOS_TASK_H
+
+// Tasks als losgelöste pthreads; Priorität, Stack und Kern werden ignoriert
+#include <pthread.h>
+#include <unistd.h>
+#include "FreeRTOS.h"
+
+typedef void (*TaskFunction_t)(void* parameter);
+
+struct HostTask {
+    pthread_t thread;
+    TaskFunction_t function;
+    void* parameter;
+};
+
+typedef HostTask* TaskHandle_t;
+
+inline void* hostTaskEntry(void* argument) {
+    HostTask* task = static_cast<HostTask*>(argument);
+    task->function(task->parameter);
+    return nullptr;
+}
+
+// Das HostTask-Objekt bleibt bestehen: der Aufrufer hält das Handle ggf. über
+// das Task-Ende hinaus (wie ein TCB, den FreeRTOS erst im Idle-Task freigibt)
+inline BaseType_t xTaskCreate(TaskFunction_t function, const char* name, uint32_t stackDepth,
+                              void* parameter, UBaseType_t priority, TaskHandle_t* handle) {
+    (void)name;
+    (void)stackDepth;
+    (void)priority;
+    HostTask* task = new HostTask;
+    task->function = function;
+    task->parameter = parameter;
+    if (pthread_create(&task->thread, nullptr, hostTaskEntry, task) != 0) {
+        delete task;
+        return pdFAIL;
+    }
+    pthread_detach(task->thread);
+    if (handle) {
+        *handle = task;
+    }
+    return pdPASS;
+}
+
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char* name, uint32_t stackDepth,
+                                          void* parameter, UBaseType_t priority, TaskHandle_t* handle,
+                                          BaseType_t core) {
+    (void)core;
+    return xTaskCreate(function, name, stackDepth, parameter, priority, handle);
+}
+
+// Nur die Selbstbeendigung wird nachgebildet; fremde Threads lassen sich auf
+// dem Host nicht sicher abbrechen
+inline void vTaskDelete(TaskHandle_t task) {
+    if (task == nullptr) {
+        pthread_exit(nullptr);
+    }
+}
+
+inline void vTaskDelay(TickType_t ticks) {
+    usleep(ticks * 1000);
+}
+
+#endif // HOST_FREERTOS_TASK_H
@@ -0,0 +1,11 @@
+#ifndef HOST_LWIP_SOCKETS_H
+#define HOST_LWIP_SOCKETS_H
+
+// Host-Ersatz: lwIP bietet die BSD-Socket-API, auf dem Host ist es POSIX
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+#endif // HOST_LWIP_SOCKETS_H
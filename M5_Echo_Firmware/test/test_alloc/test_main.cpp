@@ -0,0 +1,107 @@
+// Host-Test (pio test -e native): Ausgehende Steuer-Nachrichten entstehen
+// ohne Heap-Allokation. malloc & Co. werden per --wrap gezählt.
+#include <unity.h>
+#include "JsonWriter.h"
+#include "ControlProtocol.h"
+#include "AllocCounter.h"
+
+// Felder wie beim Barge-in (main.cpp): Zahlen, Zeitpunkt der Tastenflanke, String
+static const EventField FIELDS[] = {
+    { ControlTag::CLIP_ID, (int64_t)42 },
+    { ControlTag::CLIP_SAMPLE, (int64_t)123456789 },
+    { ControlTag::TIMESTAMP, (int64_t)5123456789 },
+    { ControlTag::TARGET, "playback" },
+};
+static const size_t FIELD_COUNT = sizeof(FIELDS) / sizeof(FIELDS[0]);
+
+// Negative Zahl: nur in JSON darstellbar
+static const EventField NEGATIVE_FIELD[] = {
+    { ControlTag::CLIP_SAMPLE, (int64_t)-5 },
+};
+
+static char slot[WS_TX_SLOT_SIZE];
+
+static size_t countKey(const char* json, size_t length, const char* quotedKey) {
+    size_t count = 0;
+    size_t keyLength = strlen(quotedKey);
+    for (size_t i = 0; i + keyLength <= length; i++) {
+        if (memcmp(json + i, quotedKey, keyLength) == 0) {
+            count++;
+        }
+    }
+    return count;
+}
+
+void test_json_event_without_allocation() {
+    allocations = 0;
+    JsonWriter json(slot, sizeof(slot));
+    controlWriteJsonEvent(json, EVENT_BARGE_IN, FIELDS, FIELD_COUNT, "m5echo-0011223344", 1234);
+    
+    TEST_ASSERT_EQUAL_UINT32(0, allocations);
+    TEST_ASSERT_TRUE(json.ok());
+    TEST_ASSERT_EQUAL_STRING_LEN(
+        "{\"type\":\"event\",\"event\":\"barge_in\",\"clipId\":42,\"clipSample\":123456789,"
+        "\"eventTimeUs\":5123456789,\"target\":\"playback\",\"clientId\":\"m5echo-0011223344\",\"timestamp\":1234}",
+        json.data(), json.size());
+    
+    // Jeder Schlüssel genau einmal, sonst gewinnt beim Parser der letzte
+    TEST_ASSERT_EQUAL_UINT32(1, countKey(json.data(), json.size(), "\"timestamp\""));
+    TEST_ASSERT_EQUAL_UINT32(1, countKey(json.data(), json.size(), "\"eventTimeUs\""));
+}
+
+void test_reencoded_event_without_allocation() {
+    uint8_t eventId = 0;
+    TEST_ASSERT_TRUE(controlEventId(EVENT_BARGE_IN, eventId));
+    uint8_t frame[WS_TLV_MAX_SIZE];
+    ControlWriter writer(frame, sizeof(frame), ControlType::EVENT);
+    writer.putUint(ControlTag::EVENT, eventId);
+    writer.putUint(ControlTag::UPTIME_MS, 1234);
+    TEST_ASSERT_TRUE(writer.putFields(FIELDS, FIELD_COUNT));
+    
+    // Nach einem Verbindungsabbruch: TLV aus der Queue als JSON senden
+    allocations = 0;
+    JsonWriter json(slot, sizeof(slot));
+    TEST_ASSERT_TRUE(controlWriteJsonMessage(json, writer.data() + 1, writer.size() - 1, "m5echo-0011223344"));
+    
+    TEST_ASSERT_EQUAL_UINT32(0, allocations);
+    TEST_ASSERT_EQUAL_STRING_LEN(
+        "{\"type\":\"event\",\"event\":\"barge_in\",\"timestamp\":1234,\"clipId\":42,\"clipSample\":123456789,"
+        "\"eventTimeUs\":5123456789,\"target\":\"playback\",\"clientId\":\"m5echo-0011223344\"}",
+        json.data(), json.size());
+    TEST_ASSERT_EQUAL_UINT32(1, countKey(json.data(), json.size(), "\"timestamp\""));
+}
+
+void test_tlv_event_without_allocation() {
+    allocations = 0;
+    uint8_t eventId = 0;
+    TEST_ASSERT_TRUE(controlEventId(EVENT_BARGE_IN, eventId));
+    
+    ControlWriter writer((uint8_t*)slot, WS_TLV_MAX_SIZE, ControlType::EVENT);
+    writer.putUint(ControlTag::EVENT, eventId);
+    writer.putUint(ControlTag::UPTIME_MS, 1234);
+    TEST_ASSERT_TRUE(writer.putFields(FIELDS, FIELD_COUNT));
+    TEST_ASSERT_FALSE(writer.putFields(NEGATIVE_FIELD, 1)); // Negativ: JSON-Fallback
+    
+    TEST_ASSERT_EQUAL_UINT32(0, allocations);
+}
+
+void test_overflow_without_allocation() {
+    allocations = 0;
+    char small[16];
+    JsonWriter json(small, sizeof(small));
+    json.beginObject();
+    controlWriteJsonFields(json, FIELDS, FIELD_COUNT);
+    json.endObject();
+    
+    TEST_ASSERT_EQUAL_UINT32(0, allocations);
+    TEST_ASSERT_FALSE(json.ok());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_json_event_without_allocation);
+    RUN_TEST(test_reencoded_event_without_allocation);
+    RUN_TEST(test_tlv_event_without_allocation);
+    RUN_TEST(test_overflow_without_allocation);
+    return UNITY_END();
+}
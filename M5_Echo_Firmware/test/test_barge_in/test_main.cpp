@@ -0,0 +1,186 @@
+// Host-Test (pio test -e native): Barge-in gegen den simulierten I2S-Treiber.
+// Gemessen wird wie in onButtonPressed() die Zeit vom Tastendruck bis zur
+// laufenden Aufnahme, dazu bis zum ersten Block an der Senke und bis zur
+// Stille am Lautsprecher.
+#include <unity.h>
+#include <atomic>
+#include <esp_timer.h>
+#include "AudioManager.h"
+#include "AllocCounter.h"
+
+#define PRESS_TO_CAPTURE_MAX_US     5000    // "innerhalb weniger Millisekunden"
+#define FIRST_BLOCK_MAX_US          20000
+#define SCHEDULING_SLACK_US         8000    // vTaskDelay(1) im Playing-Task, verspätetes Aufwachen auf dem Host
+#define BARGE_IN_ROUNDS             8       // Verschiedene Phasen gegen den DMA-Takt
+
+static AudioManager* audio = nullptr;
+
+// Senke: erster Block und Lücken im fortlaufend nummerierten Mikrofon-Strom
+static std::atomic<int64_t> firstBlockUs(0);
+static std::atomic<uint32_t> blocks(0);
+static std::atomic<uint32_t> gaps(0);
+static int16_t nextSample = 0;
+
+static bool captureSink(const uint8_t* data, size_t length) {
+    const int16_t* samples = (const int16_t*)data;
+    size_t count = length / sizeof(int16_t);
+    
+    if (blocks.load() == 0) {
+        firstBlockUs = esp_timer_get_time();
+    } else if (samples[0] != nextSample) {
+        gaps++;
+    }
+    for (size_t i = 1; i < count; i++) {
+        if ((int16_t)(samples[i - 1] + 1) != samples[i]) {
+            gaps++;
+        }
+    }
+    nextSample = (int16_t)(samples[count - 1] + 1);
+    blocks++;
+    return true;
+}
+
+// Wartet bis cond() gilt, höchstens timeoutMs
+template <typename Condition>
+static bool waitFor(uint32_t timeoutMs, Condition cond) {
+    uint32_t start = millis();
+    while (!cond()) {
+        if (millis() - start > timeoutMs) {
+            return false;
+        }
+        delay(1);
+    }
+    return true;
+}
+
+// Sinuston nahe Vollaussteuerung, keine Nullen (jedes Sample hörbar)
+static void fillTone(int16_t* samples, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        int16_t value = (int16_t)(20000.0f * sinf(2.0f * PI * 440.0f * (float)i / I2S_SAMPLE_RATE));
+        samples[i] = value != 0 ? value : 1;
+    }
+}
+
+static void resetSink() {
+    blocks = 0;
+    gaps = 0;
+    firstBlockUs = 0;
+}
+
+// Ein Tastendruck mitten in einer Antwort; liefert die Verzögerungen relativ zur Flanke
+struct BargeInTiming {
+    int64_t pressToCaptureUs;
+    int64_t firstBlockUs;
+    int64_t zeroedUs;
+    int64_t silentUs;
+};
+
+static BargeInTiming bargeInRound(uint32_t clipId, uint32_t phaseMs) {
+    static int16_t tone[AUDIO_DOWNLINK_TARGET_BYTES / sizeof(int16_t)];
+    fillTone(tone, sizeof(tone) / sizeof(tone[0]));
+    resetSink();
+    
+    // Neue Antwort (queue_clip hebt die Sperre nach dem vorigen Barge-in auf),
+    // läuft seit 100 ms; der Downlink liefert nach, der Playing-Task steckt
+    // also in i2s_write. phaseMs verschiebt den Druck gegen den DMA-Takt.
+    uint64_t startSamples = audio->getPlaybackPosition().playedSamples;
+    TEST_ASSERT_TRUE(audio->queueStreamClip(clipId, 0, 0));
+    TEST_ASSERT_TRUE(audio->writeAudio((const uint8_t*)tone, sizeof(tone)));
+    TEST_ASSERT_TRUE(waitFor(500, [startSamples] {
+        return audio->getPlaybackPosition().playedSamples >= startSamples + I2S_SAMPLE_RATE / 10;
+    }));
+    TEST_ASSERT_TRUE(audio->writeAudio((const uint8_t*)tone, sizeof(tone) / 2));
+    delay(phaseMs);
+    TEST_ASSERT_TRUE(audio->isPlaybackActive());
+    
+    // Weg aus onButtonPressed()
+    int64_t edgeUs = esp_timer_get_time();
+    PlaybackPosition position;
+    TEST_ASSERT_TRUE(audio->bargeIn(&position));
+    TEST_ASSERT_TRUE(audio->startRecording());
+    BargeInTiming timing;
+    timing.pressToCaptureUs = esp_timer_get_time() - edgeUs;
+    
+    TEST_ASSERT_TRUE(position.playedSamples > startSamples);
+    TEST_ASSERT_EQUAL_UINT32(clipId, position.clipId);
+    TEST_ASSERT_TRUE(audio->isRecording());
+    
+    // Erster Block an der Senke, Playing-Task hat die DMA genullt
+    TEST_ASSERT_TRUE(waitFor(200, [] { return blocks.load() > 0; }));
+    TEST_ASSERT_TRUE(waitFor(200, [edgeUs] { return hostI2sZeroedUs(I2S_SPEAKER_PORT) >= edgeUs; }));
+    timing.firstBlockUs = firstBlockUs.load() - edgeUs;
+    timing.zeroedUs = hostI2sZeroedUs(I2S_SPEAKER_PORT) - edgeUs;
+    int64_t audibleUntilUs = hostI2sAudibleUntilUs(I2S_SPEAKER_PORT);
+    timing.silentUs = audibleUntilUs - edgeUs;
+    
+    // Verspätete Frames der abgebrochenen Antwort bleiben stumm
+    TEST_ASSERT_TRUE(audio->writeAudio((const uint8_t*)tone, sizeof(tone)));
+    delay(20);
+    TEST_ASSERT_TRUE(hostI2sAudibleUntilUs(I2S_SPEAKER_PORT) == audibleUntilUs);
+    TEST_ASSERT_FALSE(audio->isPlaybackActive());
+    
+    // Aufnahme lückenlos ab dem ersten Block
+    TEST_ASSERT_TRUE(waitFor(200, [] { return blocks.load() >= 4; }));
+    TEST_ASSERT_EQUAL_UINT32(0, gaps.load());
+    TEST_ASSERT_TRUE(audio->stopRecording());
+    return timing;
+}
+
+void test_barge_in_during_playback() {
+    BargeInTiming worst = { 0, 0, 0, 0 };
+    for (uint32_t round = 0; round < BARGE_IN_ROUNDS; round++) {
+        BargeInTiming timing = bargeInRound(round + 1, (round * 3) % 17);
+        worst.pressToCaptureUs = max(worst.pressToCaptureUs, timing.pressToCaptureUs);
+        worst.firstBlockUs = max(worst.firstBlockUs, timing.firstBlockUs);
+        worst.zeroedUs = max(worst.zeroedUs, timing.zeroedUs);
+        worst.silentUs = max(worst.silentUs, timing.silentUs);
+    }
+    
+    // Laufendes i2s_write (höchstens ein DMA-Puffer) kehrt zurück, dann wird
+    // genullt; hörbar bleibt danach nur der Puffer in Ausgabe
+    int64_t dmaBufferUs = hostI2sBufferUs(I2S_SPEAKER_PORT);
+    char message[192];
+    snprintf(message, sizeof(message),
+             "worst of %d: press->capture %lld us, first block %lld us, zeroed %lld us, silent %lld us (DMA buffer %lld us)",
+             BARGE_IN_ROUNDS, (long long)worst.pressToCaptureUs, (long long)worst.firstBlockUs,
+             (long long)worst.zeroedUs, (long long)worst.silentUs, (long long)dmaBufferUs);
+    TEST_MESSAGE(message);
+    
+    TEST_ASSERT_TRUE(worst.pressToCaptureUs <= PRESS_TO_CAPTURE_MAX_US);
+    TEST_ASSERT_TRUE(worst.firstBlockUs <= FIRST_BLOCK_MAX_US);
+    TEST_ASSERT_TRUE(worst.zeroedUs <= dmaBufferUs + SCHEDULING_SLACK_US);
+    TEST_ASSERT_TRUE(worst.silentUs <= 2 * dmaBufferUs + SCHEDULING_SLACK_US);
+}
+
+void test_barge_in_without_playback() {
+    // Leere Queue: Playing-Task schaltet den Lautsprecher nach dem Idle-Timeout ab
+    TEST_ASSERT_TRUE(waitFor(AUDIO_PLAYBACK_IDLE_TIMEOUT_MS + 1000, [] { return !audio->isPlaying(); }));
+    
+    PlaybackPosition position;
+    TEST_ASSERT_FALSE(audio->bargeIn(&position));
+    
+    // Aufnahme startet auch ohne Barge-in sofort
+    int64_t edgeUs = esp_timer_get_time();
+    uint32_t before = blocks.load();
+    TEST_ASSERT_TRUE(audio->startRecording());
+    TEST_ASSERT_TRUE(esp_timer_get_time() - edgeUs <= PRESS_TO_CAPTURE_MAX_US);
+    TEST_ASSERT_TRUE(waitFor(200, [before] { return blocks.load() > before; }));
+    TEST_ASSERT_TRUE(audio->stopRecording());
+    TEST_ASSERT_FALSE(audio->isRecording());
+}
+
+int main() {
+    Serial.quiet = true;
+    
+    // Bewusst nie gelöscht: der Destruktor kann fremde Tasks auf dem Host nicht beenden
+    audio = new AudioManager();
+    if (!audio->begin()) {
+        return 1;
+    }
+    audio->setAudioSink(captureSink);
+    
+    UNITY_BEGIN();
+    RUN_TEST(test_barge_in_during_playback);
+    RUN_TEST(test_barge_in_without_playback);
+    return UNITY_END();
+}
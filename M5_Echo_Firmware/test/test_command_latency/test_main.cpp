@@ -0,0 +1,198 @@
+// Host-Test (pio test -e native_commands): Befehl bis Wirkung durch
+// CommandRegistry (Tabelle, JSON- und TLV-Parser). Die Manager ersetzt ein
+// Stub für dispatch(), der die Wirkung mit Zeitpunkt festhält; die Zeiten
+// werden nur ausgegeben, weil sie vom Host abhängen.
+#include <unity.h>
+#include <chrono>
+#include <esp_timer.h>
+#include "CommandRegistry.h"
+#include "AllocCounter.h"
+
+#define BENCH_ITERATIONS 20000
+
+static int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// =============================================================================
+// STUB-MANAGER
+// =============================================================================
+
+struct Effect {
+    uint32_t count;
+    ControlCommand command;
+    CommandArgs args;
+    int64_t atNs;               // Zeitpunkt der Wirkung
+};
+
+static Effect effect;
+
+// Ersetzt CommandDispatch.cpp: statt der Manager wirkt der Befehl hier
+bool CommandRegistry::dispatch(ControlCommand command, const CommandArgs& args) {
+    int64_t startUs = esp_timer_get_time();
+    effect.count++;
+    effect.command = command;
+    effect.args = args;
+    effect.atNs = nowNs();
+    recordHandlerTime(startUs);
+    return true;
+}
+
+static void resetEffect() {
+    memset(&effect, 0, sizeof(effect));
+}
+
+static void report(const char* what, size_t bytes, int64_t totalNs) {
+    char line[128];
+    snprintf(line, sizeof(line), "%-26s %4u Bytes %8.1f ns Befehl bis Wirkung",
+             what, (unsigned)bytes, (double)totalNs / BENCH_ITERATIONS);
+    TEST_MESSAGE(line);
+}
+
+// =============================================================================
+// TESTS
+// =============================================================================
+
+void test_every_command_name_resolves() {
+    CommandRegistry registry;
+    
+#define COMMAND_NAME_CHECK(id, value, jsonName) \
+    { \
+        char json[64]; \
+        int length = snprintf(json, sizeof(json), "{\"command\":\"%s\"}", jsonName); \
+        resetEffect(); \
+        TEST_ASSERT_TRUE(registry.dispatchJson(json, length, nullptr)); \
+        TEST_ASSERT_EQUAL_UINT32(1, effect.count); \
+        TEST_ASSERT_EQUAL_UINT32(value, (uint32_t)effect.command); \
+    }
+    CONTROL_COMMANDS(COMMAND_NAME_CHECK)
+#undef COMMAND_NAME_CHECK
+    
+    // Ohne "command" gilt der Typ der Nachricht (ota, config)
+    static const char config[] = "{\"type\":\"config\",\"brightness\":40,\"timeoutMs\":60000,\"mode\":\"deep_sleep\"}";
+    resetEffect();
+    TEST_ASSERT_TRUE(registry.dispatchJson(config, sizeof(config) - 1, "config"));
+    TEST_ASSERT_EQUAL_UINT32((uint32_t)ControlCommand::CONFIG, (uint32_t)effect.command);
+    TEST_ASSERT_EQUAL_INT(40, effect.args.brightness);
+    TEST_ASSERT_EQUAL_UINT32(60000, effect.args.timeoutMs);     // Letzte Schlüssel des Filters
+    TEST_ASSERT_EQUAL_STRING("deep_sleep", effect.args.mode);
+}
+
+void test_unknown_command_has_no_effect() {
+    CommandRegistry registry;
+    Serial.quiet = true;
+    resetEffect();
+    
+    static const char* unknown[] = {
+        "{\"command\":\"led_stat\"}",           // Tippfehler
+        "{\"command\":\"LED\"}",                // Groß/klein
+        "{\"type\":\"command\"}",               // Kein Name
+    };
+    for (size_t i = 0; i < sizeof(unknown) / sizeof(unknown[0]); i++) {
+        TEST_ASSERT_FALSE(registry.dispatchJson(unknown[i], strlen(unknown[i]), nullptr));
+    }
+    uint8_t noId[] = { (uint8_t)ControlType::COMMAND };
+    TEST_ASSERT_FALSE(registry.dispatchControl(noId, sizeof(noId)));
+    
+    Serial.quiet = false;
+    TEST_ASSERT_EQUAL_UINT32(0, effect.count);
+    TEST_ASSERT_EQUAL_UINT32(4, registry.getStats().unknown);
+    TEST_ASSERT_EQUAL_UINT32(0, registry.getStats().dispatched);
+}
+
+void test_json_command_to_effect() {
+    static const char json[] =
+        "{\"type\":\"command\",\"command\":\"queue_clip\",\"clipId\":7,\"length\":48000,"
+        "\"crossfadeMs\":20,\"name\":\"answer-7\",\"clientId\":\"ignored\"}";
+    CommandRegistry registry;
+    
+    resetEffect();
+    allocations = 0;
+    TEST_ASSERT_TRUE(registry.dispatchJson(json, sizeof(json) - 1, nullptr));
+    TEST_ASSERT_EQUAL_UINT32(0, allocations);
+    TEST_ASSERT_EQUAL_UINT32((uint32_t)ControlCommand::QUEUE_CLIP, (uint32_t)effect.command);
+    TEST_ASSERT_EQUAL_UINT32(7, effect.args.clipId);
+    TEST_ASSERT_EQUAL_UINT32(48000, effect.args.length);
+    TEST_ASSERT_EQUAL_UINT32(20, effect.args.crossfadeMs);
+    TEST_ASSERT_EQUAL_STRING("stream", effect.args.source);    // Vorgabe
+    TEST_ASSERT_EQUAL_STRING("answer-7", effect.args.name);
+    
+    int64_t totalNs = 0;
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        int64_t start = nowNs();
+        registry.dispatchJson(json, sizeof(json) - 1, nullptr);
+        totalNs += effect.atNs - start;
+    }
+    report("queue_clip JSON", sizeof(json) - 1, totalNs);
+    TEST_ASSERT_EQUAL_UINT32(BENCH_ITERATIONS + 1, registry.getStats().dispatched);
+}
+
+void test_tlv_command_to_effect() {
+    uint8_t frame[WS_TLV_MAX_SIZE];
+    ControlWriter writer(frame, sizeof(frame), ControlType::COMMAND);
+    writer.putUint(ControlTag::COMMAND, (uint8_t)ControlCommand::QUEUE_CLIP);
+    writer.putUint(ControlTag::CLIP_ID, 7);
+    writer.putUint(ControlTag::LENGTH, 48000);
+    writer.putUint(ControlTag::CROSSFADE_MS, 20);
+    writer.putString(ControlTag::NAME, "answer-7", 8);
+    TEST_ASSERT_TRUE(writer.ok());
+    const uint8_t* message = writer.data() + 1;    // Ohne Kind-Byte, wie von der Netzwerk-Task
+    size_t length = writer.size() - 1;
+    CommandRegistry registry;
+    
+    resetEffect();
+    allocations = 0;
+    TEST_ASSERT_TRUE(registry.dispatchControl(message, length));
+    TEST_ASSERT_EQUAL_UINT32(0, allocations);
+    TEST_ASSERT_EQUAL_UINT32((uint32_t)ControlCommand::QUEUE_CLIP, (uint32_t)effect.command);
+    TEST_ASSERT_EQUAL_UINT32(7, effect.args.clipId);
+    TEST_ASSERT_EQUAL_UINT32(48000, effect.args.length);
+    TEST_ASSERT_EQUAL_UINT32(20, effect.args.crossfadeMs);
+    TEST_ASSERT_EQUAL_STRING("stream", effect.args.source);
+    TEST_ASSERT_EQUAL_STRING("answer-7", effect.args.name);
+    
+    int64_t totalNs = 0;
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        int64_t start = nowNs();
+        registry.dispatchControl(message, length);
+        totalNs += effect.atNs - start;
+    }
+    report("queue_clip TLV", length, totalNs);
+}
+
+void test_color_in_both_encodings() {
+    CommandRegistry registry;
+    static const char json[] = "{\"command\":\"led\",\"color\":\"#FF8000\",\"effect\":\"pulsing\"}";
+    
+    resetEffect();
+    TEST_ASSERT_TRUE(registry.dispatchJson(json, sizeof(json) - 1, nullptr));
+    TEST_ASSERT_TRUE(effect.args.hasColor);
+    TEST_ASSERT_EQUAL_UINT32(0xFF8000, effect.args.color);
+    TEST_ASSERT_EQUAL_STRING("pulsing", effect.args.effect);
+    
+    uint8_t frame[WS_TLV_MAX_SIZE];
+    ControlWriter writer(frame, sizeof(frame), ControlType::COMMAND);
+    writer.putUint(ControlTag::COMMAND, (uint8_t)ControlCommand::LED);
+    writer.putString(ControlTag::COLOR, "#FF8000", 7);
+    resetEffect();
+    TEST_ASSERT_TRUE(registry.dispatchControl(writer.data() + 1, writer.size() - 1));
+    TEST_ASSERT_TRUE(effect.args.hasColor);
+    TEST_ASSERT_EQUAL_UINT32(0xFF8000, effect.args.color);
+    
+    // Ungültige Farbe: Befehl wirkt, aber ohne Farbe
+    static const char bad[] = "{\"command\":\"led\",\"color\":\"#GG0000\"}";
+    resetEffect();
+    TEST_ASSERT_TRUE(registry.dispatchJson(bad, sizeof(bad) - 1, nullptr));
+    TEST_ASSERT_FALSE(effect.args.hasColor);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_every_command_name_resolves);
+    RUN_TEST(test_unknown_command_has_no_effect);
+    RUN_TEST(test_json_command_to_effect);
+    RUN_TEST(test_tlv_command_to_effect);
+    RUN_TEST(test_color_in_both_encodings);
+    return UNITY_END();
+}
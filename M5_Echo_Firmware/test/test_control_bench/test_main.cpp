@@ -0,0 +1,194 @@
+// Host-Benchmark (pio test -e native): Bytes und CPU-Zeit je Steuer-Nachricht,
+// TLV (ControlWriter/ControlReader) gegen JSON (JsonWriter/ArduinoJson).
+// Geprüft werden Inhalt, Größe und Allokationen; die Zeiten werden nur
+// ausgegeben, weil sie vom Host abhängen.
+#include <unity.h>
+#include <ArduinoJson.h>
+#include <chrono>
+#include "JsonWriter.h"
+#include "ControlProtocol.h"
+#include "AllocCounter.h"
+
+#define BENCH_ITERATIONS 20000
+
+// Barge-in wie in main.cpp
+static const EventField EVENT_FIELDS[] = {
+    { ControlTag::CLIP_ID, (int64_t)42 },
+    { ControlTag::CLIP_SAMPLE, (int64_t)123456789 },
+    { ControlTag::TIMESTAMP, (int64_t)5123456789 },
+    { ControlTag::TARGET, "playback" },
+};
+static const size_t EVENT_FIELD_COUNT = sizeof(EVENT_FIELDS) / sizeof(EVENT_FIELDS[0]);
+
+// queue_clip vom Server in beiden Kodierungen
+static const char COMMAND_JSON[] =
+    "{\"type\":\"command\",\"command\":\"queue_clip\",\"clipId\":7,\"length\":48000,"
+    "\"crossfadeMs\":20,\"source\":\"stream\",\"name\":\"answer-7\"}";
+
+struct DecodedCommand {
+    uint32_t command;
+    uint32_t clipId;
+    uint32_t length;
+    uint32_t crossfadeMs;
+    char source[16];
+    char name[64];
+};
+
+static char slot[WS_TX_SLOT_SIZE];
+static uint8_t frame[WS_TLV_MAX_SIZE];
+
+static volatile size_t sink = 0;    // Verhindert, dass der Compiler Schleifen entfernt
+
+static int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void report(const char* what, size_t bytes, int64_t totalNs) {
+    char line[128];
+    snprintf(line, sizeof(line), "%-24s %4u Bytes %8.1f ns/Nachricht",
+             what, (unsigned)bytes, (double)totalNs / BENCH_ITERATIONS);
+    TEST_MESSAGE(line);
+}
+
+// =============================================================================
+// KODIEREN (Client -> Server)
+// =============================================================================
+
+static size_t encodeJsonEvent() {
+    JsonWriter json(slot, sizeof(slot));
+    controlWriteJsonEvent(json, EVENT_BARGE_IN, EVENT_FIELDS, EVENT_FIELD_COUNT, "m5echo-0011223344", 1234);
+    return json.ok() ? json.size() : 0;
+}
+
+static size_t encodeTlvEvent() {
+    uint8_t eventId = 0;
+    controlEventId(EVENT_BARGE_IN, eventId);
+    ControlWriter writer(frame, sizeof(frame), ControlType::EVENT);
+    writer.putUint(ControlTag::EVENT, eventId);
+    writer.putUint(ControlTag::UPTIME_MS, 1234);
+    writer.putFields(EVENT_FIELDS, EVENT_FIELD_COUNT);
+    return writer.ok() ? writer.size() : 0;
+}
+
+void test_encode_event() {
+    allocations = 0;
+    size_t jsonBytes = encodeJsonEvent();
+    size_t tlvBytes = encodeTlvEvent();
+    TEST_ASSERT_EQUAL_UINT32(0, allocations);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, tlvBytes);
+    TEST_ASSERT_LESS_THAN_UINT32(jsonBytes / 2, tlvBytes);
+    
+    int64_t start = nowNs();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        sink += encodeJsonEvent();
+    }
+    report("Event JSON kodieren", jsonBytes, nowNs() - start);
+    
+    start = nowNs();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        sink += encodeTlvEvent();
+    }
+    report("Event TLV kodieren", tlvBytes, nowNs() - start);
+    
+    // Die TLV-Nachricht trägt denselben Inhalt: zurück nach JSON ergibt alle Felder
+    JsonWriter json(slot, sizeof(slot));
+    TEST_ASSERT_TRUE(controlWriteJsonMessage(json, frame + 1, tlvBytes - 1, "m5echo-0011223344"));
+    TEST_ASSERT_EQUAL_UINT32(jsonBytes, json.size());
+}
+
+// =============================================================================
+// DEKODIEREN (Server -> Client)
+// =============================================================================
+
+static bool decodeJsonCommand(DecodedCommand& out) {
+    StaticJsonDocument<512> doc;
+    if (deserializeJson(doc, COMMAND_JSON, sizeof(COMMAND_JSON) - 1)) {
+        return false;
+    }
+    const char* name = doc["command"] | "";
+    out.command = strcmp(name, "queue_clip") == 0 ? (uint32_t)ControlCommand::QUEUE_CLIP : 0;
+    out.clipId = doc["clipId"] | 0;
+    out.length = doc["length"] | 0;
+    out.crossfadeMs = doc["crossfadeMs"] | 0;
+    strlcpy(out.source, doc["source"] | "stream", sizeof(out.source));
+    strlcpy(out.name, doc["name"] | "", sizeof(out.name));
+    return true;
+}
+
+static bool decodeTlvCommand(const uint8_t* data, size_t length, DecodedCommand& out) {
+    ControlReader reader(data, length);
+    if (!reader.isValid() || reader.type() != ControlType::COMMAND) {
+        return false;
+    }
+    ControlTag tag;
+    const uint8_t* value;
+    uint8_t valueLength;
+    while (reader.next(tag, value, valueLength)) {
+        switch (tag) {
+            case ControlTag::COMMAND:      out.command = ControlReader::toUint(value, valueLength); break;
+            case ControlTag::CLIP_ID:      out.clipId = ControlReader::toUint(value, valueLength); break;
+            case ControlTag::LENGTH:       out.length = ControlReader::toUint(value, valueLength); break;
+            case ControlTag::CROSSFADE_MS: out.crossfadeMs = ControlReader::toUint(value, valueLength); break;
+            case ControlTag::SOURCE: ControlReader::toString(value, valueLength, out.source, sizeof(out.source)); break;
+            case ControlTag::NAME:   ControlReader::toString(value, valueLength, out.name, sizeof(out.name)); break;
+            default: break;
+        }
+    }
+    return true;
+}
+
+static void assertQueueClip(const DecodedCommand& command) {
+    TEST_ASSERT_EQUAL_UINT32((uint32_t)ControlCommand::QUEUE_CLIP, command.command);
+    TEST_ASSERT_EQUAL_UINT32(7, command.clipId);
+    TEST_ASSERT_EQUAL_UINT32(48000, command.length);
+    TEST_ASSERT_EQUAL_UINT32(20, command.crossfadeMs);
+    TEST_ASSERT_EQUAL_STRING("stream", command.source);
+    TEST_ASSERT_EQUAL_STRING("answer-7", command.name);
+}
+
+void test_decode_command() {
+    ControlWriter writer(frame, sizeof(frame), ControlType::COMMAND);
+    writer.putUint(ControlTag::COMMAND, (uint8_t)ControlCommand::QUEUE_CLIP);
+    writer.putUint(ControlTag::CLIP_ID, 7);
+    writer.putUint(ControlTag::LENGTH, 48000);
+    writer.putUint(ControlTag::CROSSFADE_MS, 20);
+    writer.putString(ControlTag::SOURCE, "stream", 6);
+    writer.putString(ControlTag::NAME, "answer-7", 8);
+    TEST_ASSERT_TRUE(writer.ok());
+    const uint8_t* tlv = writer.data() + 1;     // Ohne Kind-Byte, wie beim Dispatcher
+    size_t tlvBytes = writer.size() - 1;
+    size_t jsonBytes = sizeof(COMMAND_JSON) - 1;
+    TEST_ASSERT_LESS_THAN_UINT32(jsonBytes / 2, tlvBytes);
+    
+    DecodedCommand fromJson;
+    DecodedCommand fromTlv;
+    memset(&fromJson, 0, sizeof(fromJson));
+    memset(&fromTlv, 0, sizeof(fromTlv));
+    allocations = 0;
+    TEST_ASSERT_TRUE(decodeJsonCommand(fromJson));
+    TEST_ASSERT_TRUE(decodeTlvCommand(tlv, tlvBytes, fromTlv));
+    TEST_ASSERT_EQUAL_UINT32(0, allocations);
+    assertQueueClip(fromJson);
+    assertQueueClip(fromTlv);
+    
+    DecodedCommand command;
+    int64_t start = nowNs();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        sink += decodeJsonCommand(command);
+    }
+    report("Befehl JSON dekodieren", jsonBytes, nowNs() - start);
+    
+    start = nowNs();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        sink += decodeTlvCommand(tlv, tlvBytes, command);
+    }
+    report("Befehl TLV dekodieren", tlvBytes, nowNs() - start);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_encode_event);
+    RUN_TEST(test_decode_command);
+    return UNITY_END();
+}
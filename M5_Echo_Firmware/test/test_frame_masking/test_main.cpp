@@ -0,0 +1,196 @@
+// Host-Test (pio test -e native): Maskierung der Client-Frames (RFC 6455, 5.3)
+// und write()-Aufrufe pro Frame. Durchsatz wird nur ausgegeben, weil er vom
+// Host abhängt; die Zahl der Aufrufe je Chunk wird geprüft.
+#include <unity.h>
+#include <chrono>
+#include <vector>
+#include "WebSocketFrame.h"
+#include "ControlProtocol.h"
+#include "AllocCounter.h"
+
+#define BENCH_CHUNK_SIZE 1024           // Audio-Chunk (32 ms bei 16 kHz, 16 Bit)
+#define BENCH_ITERATIONS 20000
+
+static const uint8_t MASK[4] = { 0xA5, 0x5A, 0x3C, 0xC3 };
+
+static int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Referenz: Byte für Byte wie in RFC 6455, 5.3
+static void maskBytewise(uint8_t* dst, const uint8_t* src, size_t length, const uint8_t maskKey[4], size_t keyOffset) {
+    for (size_t i = 0; i < length; i++) {
+        dst[i] = src[i] ^ maskKey[(keyOffset + i) & 3];
+    }
+}
+
+// =============================================================================
+// SOCKET-ATTRAPPE
+// =============================================================================
+
+struct Socket {
+    uint32_t writes;
+    std::vector<uint8_t> bytes;
+};
+
+static size_t socketWrite(void* context, const uint8_t* data, size_t length) {
+    Socket* socket = (Socket*)context;
+    socket->writes++;
+    socket->bytes.insert(socket->bytes.end(), data, data + length);
+    return length;
+}
+
+struct Received {
+    uint32_t messages;
+    std::vector<uint8_t> data;
+};
+
+static void receiveData(void* context, uint8_t opcode, const uint8_t* data, size_t length) {
+    (void)opcode;
+    Received* received = (Received*)context;
+    received->data.insert(received->data.end(), data, data + length);
+}
+
+static void receiveEnd(void* context, uint8_t opcode) {
+    (void)opcode;
+    ((Received*)context)->messages++;
+}
+
+// =============================================================================
+// TESTS
+// =============================================================================
+
+void test_word_kernel_matches_bytewise() {
+    uint8_t source[80];
+    uint8_t expected[80];
+    uint8_t actual[80];
+    for (size_t i = 0; i < sizeof(source); i++) {
+        source[i] = (uint8_t)(i * 37 + 11);
+    }
+    
+    // Alle Längen um die Wortgrenze, jede Schlüssel-Phase, unausgerichtete Quelle
+    for (size_t align = 0; align < 4; align++) {
+        for (size_t keyOffset = 0; keyOffset < 4; keyOffset++) {
+            for (size_t length = 0; length <= 72; length++) {
+                maskBytewise(expected, source + align, length, MASK, keyOffset);
+                wsMaskPayload(actual, source + align, length, MASK, keyOffset);
+                TEST_ASSERT_TRUE(memcmp(expected, actual, length) == 0);
+                
+                // An Ort und Stelle (Entmaskieren im Parser)
+                memcpy(actual, source + align, length);
+                wsMaskPayload(actual, actual, length, MASK, keyOffset);
+                TEST_ASSERT_TRUE(memcmp(expected, actual, length) == 0);
+            }
+        }
+    }
+}
+
+static void writeAndParse(size_t length, int kind, uint32_t expectedWrites) {
+    std::vector<uint8_t> data(length);
+    for (size_t i = 0; i < length; i++) {
+        data[i] = (uint8_t)(i * 13 + length);
+    }
+    static uint8_t buffer[WS_TX_BUFFER_SIZE];
+    Socket socket = { 0, {} };
+    
+    TEST_ASSERT_TRUE(wsWriteFrame(buffer, sizeof(buffer), data.data(), length, WS_OPCODE_BINARY, kind, MASK,
+                                  socketWrite, &socket));
+    TEST_ASSERT_EQUAL_UINT32(expectedWrites, socket.writes);
+    TEST_ASSERT_TRUE(socket.bytes[1] & 0x80);       // Mask-Bit
+    
+    // Server-Sicht: Frame parsen, Kind-Byte und Daten unverändert
+    Received received = { 0, {} };
+    FrameParser parser;
+    FrameCallbacks callbacks = { &received, nullptr, receiveData, receiveEnd, nullptr, nullptr };
+    parser.setCallbacks(callbacks);
+    TEST_ASSERT_TRUE(parser.parse(socket.bytes.data(), socket.bytes.size()));
+    TEST_ASSERT_EQUAL_UINT32(1, received.messages);
+    
+    std::vector<uint8_t> expected;
+    if (kind >= 0) {
+        expected.push_back((uint8_t)kind);
+    }
+    expected.insert(expected.end(), data.begin(), data.end());
+    TEST_ASSERT_EQUAL_UINT32(expected.size(), received.data.size());
+    TEST_ASSERT_TRUE(expected == received.data);
+}
+
+void test_one_write_per_frame() {
+    const size_t capacity = WS_TX_BUFFER_SIZE - WS_FRAME_HEADROOM;
+    
+    // Übliche Chunks: Header, Kind-Byte und Daten mit einem write()
+    static const size_t CHUNKS[] = { 0, 1, 125, 126, 320, 640, BENCH_CHUNK_SIZE };
+    for (size_t length : CHUNKS) {
+        writeAndParse(length, -1, 1);
+        writeAndParse(length, WS_KIND_AUDIO, 1);
+    }
+    writeAndParse(capacity, -1, 1);
+    writeAndParse(capacity - 1, WS_KIND_AUDIO, 1);
+    
+    // Übergroß: Header, Kind-Byte, dann abschnittsweise
+    writeAndParse(capacity, WS_KIND_AUDIO, 3);
+    writeAndParse(3 * capacity + 5, -1, 1 + 4);
+    writeAndParse(70000, WS_KIND_BULK, 2 + (70000 + capacity - 1) / capacity);
+}
+
+void test_masking_throughput() {
+    static uint8_t source[BENCH_CHUNK_SIZE + 1];
+    static uint8_t target[BENCH_CHUNK_SIZE + 1];
+    for (size_t i = 0; i < sizeof(source); i++) {
+        source[i] = (uint8_t)i;
+    }
+    
+    static const struct {
+        const char* what;
+        void (*mask)(uint8_t*, const uint8_t*, size_t, const uint8_t*, size_t);
+        size_t align;
+    } variants[] = {
+        { "Byteweise", maskBytewise, 0 },
+        { "32 Bit", wsMaskPayload, 0 },
+        { "32 Bit, unausgerichtet", wsMaskPayload, 1 },
+    };
+    
+    allocations = 0;
+    for (size_t v = 0; v < sizeof(variants) / sizeof(variants[0]); v++) {
+        int64_t start = nowNs();
+        for (int i = 0; i < BENCH_ITERATIONS; i++) {
+            variants[v].mask(target, source + variants[v].align, BENCH_CHUNK_SIZE, MASK, i & 3);
+            // Abhängigkeit zwischen den Durchläufen, damit nichts wegoptimiert wird
+            source[0] = target[BENCH_CHUNK_SIZE - 1];
+        }
+        int64_t elapsedNs = nowNs() - start;
+        
+        char line[128];
+        snprintf(line, sizeof(line), "Maskieren %-24s %8.1f MB/s", variants[v].what,
+                 (double)BENCH_CHUNK_SIZE * BENCH_ITERATIONS * 1000.0 / elapsedNs);
+        TEST_MESSAGE(line);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, allocations);
+    
+    // Segmente pro Audio-Chunk: write()-Aufrufe je Frame
+    static uint8_t buffer[WS_TX_BUFFER_SIZE];
+    Socket socket = { 0, {} };
+    socket.bytes.reserve(BENCH_CHUNK_SIZE + 16);
+    int64_t start = nowNs();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        socket.bytes.clear();
+        wsWriteFrame(buffer, sizeof(buffer), source, BENCH_CHUNK_SIZE, WS_OPCODE_BINARY, WS_KIND_AUDIO, MASK,
+                     socketWrite, &socket);
+    }
+    int64_t elapsedNs = nowNs() - start;
+    TEST_ASSERT_EQUAL_UINT32(BENCH_ITERATIONS, socket.writes);
+    
+    char line[128];
+    snprintf(line, sizeof(line), "Frame %u B: %.2f write()/Chunk, %.1f ns/Frame", BENCH_CHUNK_SIZE,
+             (double)socket.writes / BENCH_ITERATIONS, (double)elapsedNs / BENCH_ITERATIONS);
+    TEST_MESSAGE(line);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_word_kernel_matches_bytewise);
+    RUN_TEST(test_one_write_per_frame);
+    RUN_TEST(test_masking_throughput);
+    return UNITY_END();
+}
@@ -0,0 +1,302 @@
+// Host-Test (pio test -e native): FrameParser (RFC 6455) mit beliebig
+// zerteilten Lesevorgängen, Protokollfehlern und Durchsatz in MB/s. Der
+// Durchsatz wird nur ausgegeben, weil er vom Host abhängt.
+#include <unity.h>
+#include <chrono>
+#include <vector>
+#include "WebSocketFrame.h"
+#include "AllocCounter.h"
+
+#define BENCH_BYTES (8u * 1024 * 1024)
+#define BENCH_FRAME_SIZE 1024           // Audio-Chunk vom Server
+#define BENCH_READ_SIZE 1460            // Ein TCP-Segment pro Lesevorgang
+
+static int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// =============================================================================
+// FRAMES UND EMPFÄNGER
+// =============================================================================
+
+static void appendFrame(std::vector<uint8_t>& stream, uint8_t first, const uint8_t* payload, size_t length,
+                        const uint8_t* maskKey = nullptr) {
+    uint8_t maskBit = maskKey ? 0x80 : 0x00;
+    stream.push_back(first);
+    if (length < 126) {
+        stream.push_back(maskBit | length);
+    } else if (length < 65536) {
+        stream.push_back(maskBit | 126);
+        stream.push_back(length >> 8);
+        stream.push_back(length & 0xFF);
+    } else {
+        stream.push_back(maskBit | 127);
+        for (int i = 7; i >= 0; i--) {
+            stream.push_back(((uint64_t)length >> (i * 8)) & 0xFF);
+        }
+    }
+    if (maskKey) {
+        stream.insert(stream.end(), maskKey, maskKey + 4);
+    }
+    for (size_t i = 0; i < length; i++) {
+        stream.push_back(maskKey ? payload[i] ^ maskKey[i & 3] : payload[i]);
+    }
+}
+
+struct Message {
+    uint8_t opcode;
+    std::vector<uint8_t> data;
+};
+
+struct Recorder {
+    std::vector<Message> messages;      // Daten- und Control-Frames in Reihenfolge
+    std::vector<uint8_t> current;
+    uint64_t announced;                 // Länge aus messageBegin (erstes Fragment)
+    uint16_t errorCode;
+    bool stopOnClose;
+    FrameParser* parser;
+};
+
+static void recordBegin(void* context, uint8_t opcode, uint64_t payloadLength) {
+    Recorder* recorder = (Recorder*)context;
+    (void)opcode;
+    recorder->current.clear();
+    recorder->announced = payloadLength;
+}
+
+static void recordData(void* context, uint8_t opcode, const uint8_t* data, size_t length) {
+    (void)opcode;
+    Recorder* recorder = (Recorder*)context;
+    recorder->current.insert(recorder->current.end(), data, data + length);
+}
+
+static void recordEnd(void* context, uint8_t opcode) {
+    Recorder* recorder = (Recorder*)context;
+    recorder->messages.push_back({ opcode, recorder->current });
+    recorder->current.clear();
+}
+
+static void recordControl(void* context, uint8_t opcode, const uint8_t* payload, size_t length) {
+    Recorder* recorder = (Recorder*)context;
+    recorder->messages.push_back({ opcode, std::vector<uint8_t>(payload, payload + length) });
+    if (opcode == WS_OPCODE_CLOSE && recorder->stopOnClose) {
+        recorder->parser->stop();
+    }
+}
+
+static void recordError(void* context, uint16_t closeCode, const char* reason) {
+    (void)reason;
+    ((Recorder*)context)->errorCode = closeCode;
+}
+
+static void attach(FrameParser& parser, Recorder& recorder) {
+    recorder.messages.clear();
+    recorder.current.clear();
+    recorder.announced = 0;
+    recorder.errorCode = 0;
+    recorder.stopOnClose = false;
+    recorder.parser = &parser;
+    FrameCallbacks callbacks = { &recorder, recordBegin, recordData, recordEnd, recordControl, recordError };
+    parser.setCallbacks(callbacks);
+    parser.reset();
+}
+
+static std::vector<uint8_t> pattern(size_t length, uint8_t seed) {
+    std::vector<uint8_t> data(length);
+    for (size_t i = 0; i < length; i++) {
+        data[i] = (uint8_t)(i * 31 + seed);
+    }
+    return data;
+}
+
+static void assertMessage(const Message& message, uint8_t opcode, const std::vector<uint8_t>& data) {
+    TEST_ASSERT_EQUAL_UINT32(opcode, message.opcode);
+    TEST_ASSERT_EQUAL_UINT32(data.size(), message.data.size());
+    TEST_ASSERT_TRUE(data == message.data);
+}
+
+// =============================================================================
+// TESTS
+// =============================================================================
+
+void test_any_split_of_the_stream() {
+    static const uint8_t MASK[4] = { 0x12, 0x34, 0x56, 0x78 };
+    std::vector<uint8_t> text = pattern(40, 'a');
+    std::vector<uint8_t> ping = pattern(8, 1);
+    std::vector<uint8_t> medium = pattern(300, 2);          // 16-Bit-Länge
+    std::vector<uint8_t> large = pattern(70000, 3);         // 64-Bit-Länge
+    std::vector<uint8_t> empty;
+    std::vector<uint8_t> close = { 0x03, 0xE8 };
+    
+    // Fragmentierte Text-Nachricht mit Ping dazwischen, dann Binär-Frames
+    std::vector<uint8_t> stream;
+    appendFrame(stream, WS_OPCODE_TEXT, text.data(), 10);
+    appendFrame(stream, WS_OPCODE_CONTINUATION, text.data() + 10, 20);
+    appendFrame(stream, 0x80 | WS_OPCODE_PING, ping.data(), ping.size());
+    appendFrame(stream, 0x80 | WS_OPCODE_CONTINUATION, text.data() + 30, 10);
+    appendFrame(stream, 0x80 | WS_OPCODE_BINARY, medium.data(), medium.size());
+    appendFrame(stream, 0x80 | WS_OPCODE_BINARY, large.data(), large.size(), MASK);
+    appendFrame(stream, 0x80 | WS_OPCODE_TEXT, empty.data(), 0);
+    appendFrame(stream, 0x80 | WS_OPCODE_CLOSE, close.data(), close.size());
+    
+    static const size_t SPLITS[] = { 1, 2, 3, 7, 13, 125, 1460, 65536 };
+    for (size_t split : SPLITS) {
+        FrameParser parser;
+        Recorder recorder;
+        attach(parser, recorder);
+        std::vector<uint8_t> copy = stream;     // Entmaskieren geschieht an Ort und Stelle
+        for (size_t offset = 0; offset < copy.size(); offset += split) {
+            TEST_ASSERT_TRUE(parser.parse(copy.data() + offset, min(split, copy.size() - offset)));
+        }
+        
+        TEST_ASSERT_EQUAL_UINT32(0, recorder.errorCode);
+        TEST_ASSERT_EQUAL_UINT32(6, recorder.messages.size());
+        assertMessage(recorder.messages[0], WS_OPCODE_PING, ping);
+        assertMessage(recorder.messages[1], WS_OPCODE_TEXT, text);
+        assertMessage(recorder.messages[2], WS_OPCODE_BINARY, medium);
+        assertMessage(recorder.messages[3], WS_OPCODE_BINARY, large);
+        assertMessage(recorder.messages[4], WS_OPCODE_TEXT, empty);
+        assertMessage(recorder.messages[5], WS_OPCODE_CLOSE, close);
+        TEST_ASSERT_TRUE(parser.inHeader());
+    }
+}
+
+void test_protocol_errors_stop_the_parser() {
+    static const struct {
+        uint8_t header[2];
+        const char* what;
+    } invalid[] = {
+        { { 0xC2, 0x00 }, "RSV1 gesetzt" },
+        { { 0x09, 0x00 }, "Fragmentierter Ping" },
+        { { 0x89, 0x7E }, "Ping mit 16-Bit-Länge" },
+        { { 0x8B, 0x00 }, "Reservierter Control-Opcode" },
+        { { 0x83, 0x00 }, "Reservierter Daten-Opcode" },
+        { { 0x80, 0x00 }, "Fortsetzung ohne Nachricht" },
+    };
+    
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+        FrameParser parser;
+        Recorder recorder;
+        attach(parser, recorder);
+        
+        // Gültiger Frame dahinter darf nicht mehr ausgewertet werden
+        uint8_t data[] = { invalid[i].header[0], invalid[i].header[1], 0x81, 0x01, 'x' };
+        TEST_ASSERT_FALSE(parser.parse(data, sizeof(data)));
+        TEST_ASSERT_EQUAL_UINT32(1002, recorder.errorCode);
+        TEST_ASSERT_TRUE(parser.isStopped());
+        TEST_ASSERT_EQUAL_UINT32(0, recorder.messages.size());
+        
+        // Neue Verbindung: Parser wieder betriebsbereit
+        parser.reset();
+        uint8_t text[] = { 0x81, 0x01, 'x' };
+        TEST_ASSERT_TRUE(parser.parse(text, sizeof(text)));
+        TEST_ASSERT_EQUAL_UINT32(1, recorder.messages.size());
+    }
+    
+    // Neue Nachricht, bevor die fragmentierte endet
+    FrameParser parser;
+    Recorder recorder;
+    attach(parser, recorder);
+    uint8_t interleaved[] = { 0x01, 0x01, 'a', 0x82, 0x01, 'b' };
+    TEST_ASSERT_FALSE(parser.parse(interleaved, sizeof(interleaved)));
+    TEST_ASSERT_EQUAL_UINT32(1002, recorder.errorCode);
+}
+
+void test_stop_after_close() {
+    FrameParser parser;
+    Recorder recorder;
+    attach(parser, recorder);
+    recorder.stopOnClose = true;
+    
+    uint8_t data[] = { 0x88, 0x02, 0x03, 0xE8, 0x81, 0x01, 'x' };
+    TEST_ASSERT_FALSE(parser.parse(data, sizeof(data)));
+    TEST_ASSERT_EQUAL_UINT32(1, recorder.messages.size());
+    TEST_ASSERT_EQUAL_UINT32(WS_OPCODE_CLOSE, recorder.messages[0].opcode);
+}
+
+void test_payload_read_past_the_parser() {
+    // Wie readBinaryPayload(): Header über den Parser, Audio direkt in den Puffer
+    FrameParser parser;
+    Recorder recorder;
+    attach(parser, recorder);
+    
+    // Erst nach zwei Bytes steht fest, dass zwei Längen-Bytes folgen
+    uint8_t header[] = { 0x82, 0x7E, 0x04, 0x00 };     // 1024 Bytes
+    static const size_t REMAINING[] = { 2, 1, 2, 1 };
+    for (size_t i = 0; i < sizeof(header); i++) {
+        TEST_ASSERT_TRUE(parser.inHeader());
+        TEST_ASSERT_EQUAL_UINT32(REMAINING[i], parser.headerRemaining());
+        parser.parse(header + i, 1);
+    }
+    TEST_ASSERT_TRUE(parser.inMessagePayload());
+    TEST_ASSERT_EQUAL_UINT32(WS_OPCODE_BINARY, parser.getMessageOpcode());
+    TEST_ASSERT_FALSE(parser.isMasked());
+    TEST_ASSERT_EQUAL_UINT32(1024, recorder.announced);
+    TEST_ASSERT_EQUAL_UINT32(1024, parser.payloadRemaining());
+    
+    parser.consumePayload(1000);
+    TEST_ASSERT_EQUAL_UINT32(24, parser.payloadRemaining());
+    TEST_ASSERT_EQUAL_UINT32(0, recorder.messages.size());
+    parser.consumePayload(24);
+    TEST_ASSERT_TRUE(parser.inHeader());
+    TEST_ASSERT_EQUAL_UINT32(1, recorder.messages.size());
+    TEST_ASSERT_EQUAL_UINT32(WS_OPCODE_BINARY, recorder.messages[0].opcode);
+}
+
+// =============================================================================
+// DURCHSATZ
+// =============================================================================
+
+static size_t benchDelivered = 0;
+
+static void countData(void* context, uint8_t opcode, const uint8_t* data, size_t length) {
+    (void)context;
+    (void)opcode;
+    (void)data;
+    benchDelivered += length;
+}
+
+static void benchmark(const char* what, const uint8_t* maskKey) {
+    std::vector<uint8_t> chunk = pattern(BENCH_FRAME_SIZE, 7);
+    std::vector<uint8_t> stream;
+    stream.reserve(BENCH_BYTES + BENCH_BYTES / BENCH_FRAME_SIZE * 8);
+    for (size_t sent = 0; sent < BENCH_BYTES; sent += BENCH_FRAME_SIZE) {
+        appendFrame(stream, 0x80 | WS_OPCODE_BINARY, chunk.data(), chunk.size(), maskKey);
+    }
+    
+    FrameParser parser;
+    FrameCallbacks callbacks = { nullptr, nullptr, countData, nullptr, nullptr, nullptr };
+    parser.setCallbacks(callbacks);
+    benchDelivered = 0;
+    
+    allocations = 0;
+    int64_t start = nowNs();
+    for (size_t offset = 0; offset < stream.size(); offset += BENCH_READ_SIZE) {
+        parser.parse(stream.data() + offset, min((size_t)BENCH_READ_SIZE, stream.size() - offset));
+    }
+    int64_t elapsedNs = nowNs() - start;
+    
+    TEST_ASSERT_EQUAL_UINT32(0, allocations);
+    TEST_ASSERT_EQUAL_UINT32(BENCH_BYTES, benchDelivered);
+    
+    char line[128];
+    snprintf(line, sizeof(line), "%-28s %8.1f MB/s", what, (double)stream.size() * 1000.0 / elapsedNs);
+    TEST_MESSAGE(line);
+}
+
+void test_throughput() {
+    static const uint8_t MASK[4] = { 0xA5, 0x5A, 0x3C, 0xC3 };
+    benchmark("Binär 1024 B, unmaskiert", nullptr);
+    benchmark("Binär 1024 B, maskiert", MASK);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_any_split_of_the_stream);
+    RUN_TEST(test_protocol_errors_stop_the_parser);
+    RUN_TEST(test_stop_after_close);
+    RUN_TEST(test_payload_read_past_the_parser);
+    RUN_TEST(test_throughput);
+    return UNITY_END();
+}
@@ -0,0 +1,224 @@
+// Host-Test (pio test -e native): RtpTransport gegen eine UDP-Senke auf
+// 127.0.0.1. Der Downlink läuft durch eine netem-artige Stufe (Verlust,
+// Vertauschung, Duplikat); geprüft werden packetsLost, packetsLate und jitterUs.
+#include <unity.h>
+#include <vector>
+#include <poll.h>
+#include <esp_timer.h>
+#include <lwip/sockets.h>
+#include "RtpTransport.h"
+#include "AllocCounter.h"
+
+#define PACKET_SAMPLES  320             // 20 ms bei 16 kHz
+#define PACKET_US       20000
+#define SERVER_SSRC     0x5EC0DE01u
+
+// =============================================================================
+// UDP-SENKE (SERVER-SEITE)
+// =============================================================================
+
+struct Sink {
+    int sock;
+    uint16_t port;
+    struct sockaddr_in client;      // Aus dem Keepalive gelernt, wie hinter NAT
+};
+
+static void openSink(Sink& sink) {
+    sink.sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    TEST_ASSERT_TRUE(sink.sock >= 0);
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+    socklen_t length = sizeof(address);
+    TEST_ASSERT_TRUE(bind(sink.sock, (struct sockaddr*)&address, sizeof(address)) == 0);
+    TEST_ASSERT_TRUE(getsockname(sink.sock, (struct sockaddr*)&address, &length) == 0);
+    sink.port = ntohs(address.sin_port);
+    
+    struct timeval timeout = { 1, 0 };
+    setsockopt(sink.sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+}
+
+static int sinkReceive(Sink& sink, uint8_t* buffer, size_t size) {
+    socklen_t length = sizeof(sink.client);
+    return recvfrom(sink.sock, buffer, size, 0, (struct sockaddr*)&sink.client, &length);
+}
+
+static uint16_t readSequence(const uint8_t* packet) {
+    return (packet[2] << 8) | packet[3];
+}
+
+static uint32_t readWord(const uint8_t* data) {
+    return ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) | ((uint32_t)data[2] << 8) | data[3];
+}
+
+// Startet den Transport und liest dessen Keepalive
+static void startSession(RtpTransport& rtp, Sink& sink) {
+    openSink(sink);
+    TEST_ASSERT_TRUE(rtp.start(htonl(INADDR_LOOPBACK), sink.port, RTP_PAYLOAD_TYPE));
+    
+    uint8_t keepalive[64];
+    TEST_ASSERT_EQUAL_INT(RTP_HEADER_SIZE, sinkReceive(sink, keepalive, sizeof(keepalive)));
+    TEST_ASSERT_EQUAL_UINT32(rtp.getLocalPort(), ntohs(sink.client.sin_port));
+}
+
+// =============================================================================
+// NETEM-STUFE (SERVER -> CLIENT)
+// =============================================================================
+
+static void buildPacket(std::vector<uint8_t>& packet, uint16_t seq, uint32_t ts, uint32_t ssrc,
+                        uint8_t type = RTP_PAYLOAD_TYPE) {
+    packet.assign(RTP_HEADER_SIZE + PACKET_SAMPLES * 2, (uint8_t)seq);
+    packet[0] = RTP_VERSION << 6;
+    packet[1] = type;
+    packet[2] = seq >> 8;
+    packet[3] = seq & 0xFF;
+    for (int i = 0; i < 4; i++) {
+        packet[4 + i] = (ts >> (24 - 8 * i)) & 0xFF;
+        packet[8 + i] = (ssrc >> (24 - 8 * i)) & 0xFF;
+    }
+}
+
+// Paket senden, Ankunftszeit vorgeben und abholen; liefert die Zahl der Nutzdaten
+static size_t deliver(Sink& sink, RtpTransport& rtp, const std::vector<uint8_t>& packet, int64_t arrivalUs) {
+    TEST_ASSERT_EQUAL_INT(packet.size(), sendto(sink.sock, packet.data(), packet.size(), 0,
+                                                (struct sockaddr*)&sink.client, sizeof(sink.client)));
+    hostTimeUs = arrivalUs;
+    
+    // Warten, bis das Datagramm im Socket des Clients liegt
+    struct pollfd readable = { rtp.getSocket(), POLLIN, 0 };
+    TEST_ASSERT_EQUAL_INT(1, poll(&readable, 1, 1000));
+    
+    size_t payloads = 0;
+    const uint8_t* payload;
+    size_t length;
+    while ((length = rtp.receive(payload)) > 0) {
+        TEST_ASSERT_EQUAL_UINT32(PACKET_SAMPLES * 2, length);
+        payloads++;
+    }
+    return payloads;
+}
+
+// =============================================================================
+// TESTS
+// =============================================================================
+
+void test_uplink_packets() {
+    RtpTransport rtp;
+    Sink sink;
+    startSession(rtp, sink);
+    
+    // 3000 Bytes: zwei volle Pakete (1460 Bytes) und ein Rest
+    uint8_t pcm[3000];
+    for (size_t i = 0; i < sizeof(pcm); i++) {
+        pcm[i] = (uint8_t)(i * 7);
+    }
+    allocations = 0;
+    TEST_ASSERT_TRUE(rtp.sendAudio(pcm, sizeof(pcm)));
+    TEST_ASSERT_EQUAL_UINT32(0, allocations);
+    
+    uint8_t packet[RTP_MAX_PACKET_SIZE];
+    size_t offset = 0;
+    int previousSeq = -1;
+    uint32_t previousTs = 0;
+    while (offset < sizeof(pcm)) {
+        int length = sinkReceive(sink, packet, sizeof(packet));
+        TEST_ASSERT_TRUE(length > RTP_HEADER_SIZE && length <= RTP_MAX_PACKET_SIZE);
+        TEST_ASSERT_EQUAL_UINT32(RTP_VERSION, packet[0] >> 6);
+        TEST_ASSERT_EQUAL_UINT32(RTP_PAYLOAD_TYPE, packet[1] & 0x7F);
+        TEST_ASSERT_EQUAL_UINT32(rtp.getSsrc(), readWord(packet + 8));
+        if (previousSeq >= 0) {
+            TEST_ASSERT_EQUAL_UINT32((uint16_t)(previousSeq + 1), readSequence(packet));
+            TEST_ASSERT_EQUAL_UINT32(1460 / 2, readWord(packet + 4) - previousTs);
+        }
+        previousSeq = readSequence(packet);
+        previousTs = readWord(packet + 4);
+        TEST_ASSERT_TRUE(memcmp(packet + RTP_HEADER_SIZE, pcm + offset, length - RTP_HEADER_SIZE) == 0);
+        offset += length - RTP_HEADER_SIZE;
+    }
+    TEST_ASSERT_EQUAL_UINT32(sizeof(pcm), offset);
+    TEST_ASSERT_EQUAL_UINT32(3, rtp.getStats().packetsSent);
+    TEST_ASSERT_EQUAL_UINT32(0, rtp.getStats().sendErrors);
+    
+    // Nach stop() geht nichts mehr hinaus
+    rtp.stop();
+    TEST_ASSERT_FALSE(rtp.sendAudio(pcm, sizeof(pcm)));
+    TEST_ASSERT_EQUAL_INT(-1, rtp.getSocket());
+    close(sink.sock);
+}
+
+void test_downlink_loss_reorder_duplicate() {
+    RtpTransport rtp;
+    Sink sink;
+    startSession(rtp, sink);
+    
+    // Reihenfolge am Client: 5 und 11 verloren, 14/15 vertauscht, 17 doppelt
+    static const uint16_t ARRIVALS[] = {
+        1, 2, 3, 4, 6, 7, 8, 9, 10, 12, 13, 15, 14, 16, 17, 17, 18, 19, 20,
+    };
+    const uint32_t base = 0xFFF0;       // Überlauf der Sequenznummer mitten im Strom
+    std::vector<uint8_t> packet;
+    size_t payloads = 0;
+    for (size_t i = 0; i < sizeof(ARRIVALS) / sizeof(ARRIVALS[0]); i++) {
+        uint32_t n = base + ARRIVALS[i];
+        buildPacket(packet, (uint16_t)n, n * PACKET_SAMPLES, SERVER_SSRC);
+        payloads += deliver(sink, rtp, packet, (int64_t)n * PACKET_US);
+    }
+    
+    // Falscher Payload-Typ wird gezählt, aber nicht abgespielt
+    buildPacket(packet, (uint16_t)(base + 21), (base + 21) * PACKET_SAMPLES, SERVER_SSRC, 0);
+    payloads += deliver(sink, rtp, packet, (int64_t)(base + 21) * PACKET_US);
+    
+    RtpStats stats = rtp.getStats();
+    TEST_ASSERT_EQUAL_UINT32(17, payloads);
+    TEST_ASSERT_EQUAL_UINT32(17, stats.packetsReceived);
+    TEST_ASSERT_EQUAL_UINT32(3, stats.packetsLost);         // 5, 11 und das überholte 14
+    TEST_ASSERT_EQUAL_UINT32(2, stats.packetsLate);         // 14 nach 15, zweites 17
+    TEST_ASSERT_EQUAL_UINT32(1, stats.packetsInvalid);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.jitterUs);            // Ankunft genau im Takt
+    
+    rtp.stop();
+    close(sink.sock);
+    hostTimeUs = -1;
+}
+
+void test_downlink_jitter() {
+    RtpTransport rtp;
+    Sink sink;
+    startSession(rtp, sink);
+    
+    // Jedes zweite Paket 4 ms später: |D| = 4 ms, J nähert sich 4 ms (RFC 3550, 6.4.1)
+    std::vector<uint8_t> packet;
+    for (uint16_t seq = 1; seq <= 200; seq++) {
+        buildPacket(packet, seq, seq * PACKET_SAMPLES, SERVER_SSRC);
+        int64_t arrivalUs = 1000000 + (int64_t)seq * PACKET_US + (seq & 1 ? 4000 : 0);
+        TEST_ASSERT_EQUAL_UINT32(1, deliver(sink, rtp, packet, arrivalUs));
+    }
+    RtpStats stats = rtp.getStats();
+    TEST_ASSERT_EQUAL_UINT32(200, stats.packetsReceived);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.packetsLost);
+    TEST_ASSERT_UINT32_WITHIN(100, 4000, stats.jitterUs);
+    
+    // Neue SSRC (Server startet den Stream neu): ohne Verlust neu synchronisiert
+    for (uint16_t seq = 5000; seq < 5010; seq++) {
+        buildPacket(packet, seq, seq * PACKET_SAMPLES, SERVER_SSRC + 1);
+        TEST_ASSERT_EQUAL_UINT32(1, deliver(sink, rtp, packet, 9000000 + (int64_t)seq * PACKET_US));
+    }
+    stats = rtp.getStats();
+    TEST_ASSERT_EQUAL_UINT32(210, stats.packetsReceived);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.packetsLost);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.jitterUs);
+    
+    rtp.stop();
+    close(sink.sock);
+    hostTimeUs = -1;
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_uplink_packets);
+    RUN_TEST(test_downlink_loss_reorder_duplicate);
+    RUN_TEST(test_downlink_jitter);
+    return UNITY_END();
+}